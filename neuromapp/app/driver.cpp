@@ -39,9 +39,19 @@ namespace mapp{
         std::cout << "       kernel <arg> \n";
         std::cout << "       solver <arg> \n";
         std::cout << "       cstep <arg> \n";
+        std::cout << "       spike <arg> \n";
+        std::cout << "       bandwidth <arg> \n";
         std::cout << "       queueing <arg> \n";
+        std::cout << "   The data sets of any size can be generated: \n";
+        std::cout << "       generate <arg> \n";
+        std::cout << "   The data sets can be loaded in the background: \n";
+        std::cout << "       prefetch <arg> \n";
+        std::cout << "       storage <arg> \n";
+        std::cout << "   The miniapps can be benchmarked: \n";
+        std::cout << "       bench <arg> -- miniapp <arg> \n";
         std::cout << "   quit to exit \n";
-        std::cout << "   The miniapp: kernel, solver, cstep can use the provided data set: \n";
+        std::cout << "   app --script file runs the commands of file, see app/README \n";
+        std::cout << "   The miniapp: kernel, solver, cstep, bandwidth can use the provided data set: \n";
         std::cout << "\n";
         std::cout << "       "+mapp::data_test()+" \n";
     }
@@ -50,6 +60,10 @@ namespace mapp{
         m.insert(std::pair<std::string, int(*)(int,char *const *)>(name,f));
     }
 
+    bool driver::has(const std::string &name) const{
+        return m.find(name) != m.end();
+    }
+
     void driver::execute(int argc, char * const argv[]){
         if(argc == 1)
             usage();
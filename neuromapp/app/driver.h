@@ -68,6 +68,8 @@ namespace mapp{
              \param argv the commane line
          */
         void execute(int argc, char * const argv[]);
+        /** \return true if a miniapp is registered under name */
+        bool has(const std::string &name) const;
 
         private:
         /** Map containing functor of miniapp assocaited to key */
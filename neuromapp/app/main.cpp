@@ -28,6 +28,7 @@
 #include <sstream>
 #include <iterator>
 #include <algorithm>
+#include <fstream>
 #include <cstring>
 #include <vector>
 #include <algorithm>
@@ -40,6 +41,7 @@
 #include "app/miniapp.h" // the list of the miniapp API
 #include "app/driver.h"
 #include "app/driver_exception.h"
+#include "app/script.h"
 #include "utils/argv_data.h"
 
 
@@ -53,6 +55,30 @@ int main(int argc, char * const argv[]){
      d.insert("kernel",coreneuron10_kernel_execute);
      d.insert("solver",coreneuron10_solver_execute);
      d.insert("cstep",coreneuron10_cstep_execute);
+     d.insert("spike",coreneuron10_spike_execute);
+     d.insert("generate",coreneuron10_generate_execute);
+     d.insert("bandwidth",bandwidth_execute);
+     d.insert("prefetch",prefetch_execute);
+     d.insert("storage",storage_execute);
+     d.insert("bench",bench_execute);
+     bench_driver(&d);
+
+     //batch run, the data sets are loaded once for all the commands
+     if(argv[1] != NULL && std::strcmp(argv[1],"--script") == 0){
+         std::ifstream script(argv[2] ? argv[2] : "");
+         if(!script.good()){
+             std::cerr << "usage: app --script file\n";
+             return 1;
+         }
+         try {
+             std::vector<mapp::script_record> records = mapp::script_run(d, mapp::script_expand(script));
+             mapp::script_summary(std::cout, records);
+         } catch(mapp::driver_exception & e) {
+             std::cerr << "caught exception: " << e.what() << "\n";
+             return 1;
+         }
+         return 0;
+     }
 
      //direct run
      if(argv[1] != NULL){
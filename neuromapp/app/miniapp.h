@@ -31,5 +31,10 @@
 #include "coreneuron_1.0/kernel/kernel.h"
 #include "coreneuron_1.0/solver/solver.h"
 #include "coreneuron_1.0/cstep/cstep.h"
+#include "coreneuron_1.0/spike/spike.h"
+#include "coreneuron_1.0/generate/generate.h"
+#include "bandwidth/bandwidth.h"
+#include "app/storage_command.h"
+#include "bench/bench.h"
 
 #endif
@@ -0,0 +1,214 @@
+/*
+ * Neuromapp - script.cpp, Copyright (c), 2015,
+ * Timothee Ewart - Swiss Federal Institute of technology in Lausanne,
+ * timothee.ewart@epfl.ch,
+ * All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+
+/**
+ * @file neuromapp/app/script.cpp
+ * \brief Batch mode implementation
+ */
+
+#include <sstream>
+#include <iterator>
+#include <map>
+#include <cstdio>
+#include <sys/time.h>
+
+#include "app/script.h"
+#include "app/driver_exception.h"
+#include "utils/argv_data.h"
+#include "utils/storage/neuromapp_data.h"
+#include "utils/storage/storage.h"
+
+namespace mapp{
+
+    namespace {
+
+        typedef std::map<std::string, std::string> variables;
+
+        /** a line of the script and its number in the file */
+        struct line {
+            int number;
+            std::string text;
+        };
+
+        void syntax_error(line const &l, std::string const &what){
+            std::ostringstream m;
+            m << "script line " << l.number << ": " << what;
+            throw driver_exception(m.str(), MAPP_BAD_ARG);
+        }
+
+        std::vector<std::string> split(std::string const &s){
+            std::istringstream stream(s);
+            std::istream_iterator<std::string> b(stream), e;
+            return std::vector<std::string>(b, e);
+        }
+
+        std::string join(std::vector<std::string> const &words){
+            std::string r;
+            for(std::size_t k = 0; k < words.size(); ++k)
+                r += (k ? " " : "") + words[k];
+            return r;
+        }
+
+        /** replaces the ${NAME} of l by their value */
+        std::string substitute(line const &l, variables const &vars){
+            std::string r;
+            std::string::size_type pos = 0;
+            while(true){
+                std::string::size_type begin = l.text.find("${", pos);
+                if(begin == std::string::npos)
+                    break;
+                std::string::size_type end = l.text.find('}', begin);
+                if(end == std::string::npos)
+                    syntax_error(l, "unterminated ${");
+                std::string name = l.text.substr(begin + 2, end - begin - 2);
+                variables::const_iterator it = vars.find(name);
+                if(it == vars.end())
+                    syntax_error(l, "unknown variable " + name);
+                r += l.text.substr(pos, begin - pos) + it->second;
+                pos = end + 1;
+            }
+            return r + l.text.substr(pos);
+        }
+
+        /** expands the lines [b,e), returns false at quit */
+        bool expand(std::vector<line> const &lines, std::size_t b, std::size_t e,
+                    variables &vars, std::vector<std::string> &commands){
+            for(std::size_t i = b; i < e; ++i){
+                std::vector<std::string> words = split(lines[i].text);
+                if(words.empty() || words[0][0] == '#')
+                    continue;
+
+                if(words[0] == "quit")
+                    return false;
+
+                if(words[0] == "end")
+                    syntax_error(lines[i], "end without for");
+
+                if(words[0] == "set"){
+                    if(words.size() < 2)
+                        syntax_error(lines[i], "set NAME value");
+                    // the value is the rest of the line after the name
+                    std::istringstream stream(lines[i].text);
+                    line value = lines[i];
+                    stream >> words[0] >> words[1];
+                    std::getline(stream, value.text);
+                    vars[words[1]] = join(split(substitute(value, vars)));
+                    continue;
+                }
+
+                if(words[0] == "for"){
+                    if(words.size() < 4 || words[2] != "in")
+                        syntax_error(lines[i], "for NAME in value...");
+                    // the matching end
+                    std::size_t j = i + 1;
+                    for(int depth = 1; j < e; ++j){
+                        std::vector<std::string> w = split(lines[j].text);
+                        if(w.empty()) continue;
+                        if(w[0] == "for") ++depth;
+                        if(w[0] == "end" && --depth == 0) break;
+                    }
+                    if(j == e)
+                        syntax_error(lines[i], "for without end");
+                    std::vector<std::string> values = split(substitute(lines[i], vars));
+                    for(std::size_t k = 3; k < values.size(); ++k){
+                        vars[words[1]] = values[k];
+                        if(!expand(lines, i + 1, j, vars, commands))
+                            return false;
+                    }
+                    i = j;
+                    continue;
+                }
+
+                commands.push_back(join(split(substitute(lines[i], vars))));
+            }
+            return true;
+        }
+
+        double seconds(struct timeval const &tv){
+            return tv.tv_sec + 1e-6 * tv.tv_usec;
+        }
+    }
+
+    std::vector<std::string> script_expand(std::istream &in){
+        std::vector<line> lines;
+        std::string text;
+        for(int number = 1; std::getline(in, text); ++number){
+            line l = {number, text};
+            lines.push_back(l);
+        }
+        variables vars;
+        std::vector<std::string> commands;
+        expand(lines, 0, lines.size(), vars, commands);
+        return commands;
+    }
+
+    std::vector<script_record> script_run(driver &d, std::vector<std::string> const &commands){
+        std::vector<script_record> records;
+        for(std::size_t i = 0; i < commands.size(); ++i){
+            std::cout << ">? " << commands[i] << std::endl;
+            std::vector<std::string> command_v(1, "app");
+            std::vector<std::string> words = split(commands[i]);
+            command_v.insert(command_v.end(), words.begin(), words.end());
+            argv_data A(command_v.begin(), command_v.end());
+
+            script_record r = {commands[i], MAPP_OK, 0., -1.};
+            neuromapp_data.clear(STORAGE_COMPUTE_TIME);
+            struct timeval begin, end;
+            gettimeofday(&begin, NULL);
+            try {
+                d.execute(A.argc(), A.argv());
+            } catch(driver_exception & e) {
+                r.error = e.error_code;
+                if(e.error_code != MAPP_USAGE)
+                    std::cerr << "caught exception: " << e.what() << "\n";
+            } catch(std::exception & e) {
+                r.error = MAPP_UNKNOWN_ERROR;
+                std::cerr << "caught exception: " << e.what() << "\n";
+            }
+            gettimeofday(&end, NULL);
+            r.wall = seconds(end) - seconds(begin);
+            if(neuromapp_data.has<double>(STORAGE_COMPUTE_TIME))
+                r.compute = neuromapp_data.get<double>(STORAGE_COMPUTE_TIME);
+            records.push_back(r);
+            std::cout << std::endl;
+        }
+        return records;
+    }
+
+    void script_summary(std::ostream &out, std::vector<script_record> const &records){
+        char buffer[64];
+        double total = 0.;
+        out << "\n    # status    wall [s] compute [s] command\n";
+        for(std::size_t i = 0; i < records.size(); ++i){
+            script_record const &r = records[i];
+            if(r.compute < 0.)
+                snprintf(buffer, sizeof(buffer), "%5d %6s %11.6f %11s ", (int)i + 1,
+                         r.error ? "error" : "ok", r.wall, "-");
+            else
+                snprintf(buffer, sizeof(buffer), "%5d %6s %11.6f %11.6f ", (int)i + 1,
+                         r.error ? "error" : "ok", r.wall, r.compute);
+            out << buffer << r.command << "\n";
+            total += r.wall;
+        }
+        snprintf(buffer, sizeof(buffer), "%12s %11.6f ", "total", total);
+        out << buffer << records.size() << " commands\n";
+    }
+
+}// end namespace
@@ -0,0 +1,78 @@
+/*
+ * Neuromapp - script.h, Copyright (c), 2015,
+ * Timothee Ewart - Swiss Federal Institute of technology in Lausanne,
+ * timothee.ewart@epfl.ch,
+ * All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+
+/**
+ * @file neuromapp/app/script.h
+ * \brief Batch mode of the driver
+ */
+
+#ifndef MAPP_SCRIPT_
+#define MAPP_SCRIPT_
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "app/driver.h"
+
+namespace mapp{
+
+    /** \fn std::vector<std::string> script_expand(std::istream &in)
+        \brief Reads a script and returns its commands, the loops unrolled and the variables substituted.
+
+        One command of the interactive driver per line, # starts a comment and
+
+            set NAME value          defines ${NAME}, the value can use other variables
+            for NAME in v1 v2 ...   repeats the lines until the matching end for every value
+            end
+            quit                    ignores the rest of the script
+
+        A driver_exception (MAPP_BAD_ARG) reports an unknown variable or unbalanced for/end,
+        with the line number.
+     */
+    std::vector<std::string> script_expand(std::istream &in);
+
+    /** \struct script_record
+        \brief the execution of one command of a script
+     */
+    struct script_record {
+        std::string command;
+        /** error message from mapp::mapp_error */
+        int error;
+        /** duration of the command in seconds */
+        double wall;
+        /** duration of the compute phase reported by the miniapp, negative if not reported */
+        double compute;
+    };
+
+    /** \fn std::vector<script_record> script_run(driver &d, std::vector<std::string> const &commands)
+        \brief executes the commands one after the other, an error does not stop the script.
+        The data sets stay in the storage between the commands.
+     */
+    std::vector<script_record> script_run(driver &d, std::vector<std::string> const &commands);
+
+    /** \fn void script_summary(std::ostream &out, std::vector<script_record> const &records)
+        \brief prints the table of the commands and their timings
+     */
+    void script_summary(std::ostream &out, std::vector<script_record> const &records);
+
+}// end namespace
+
+#endif
@@ -0,0 +1,126 @@
+/*
+ * Neuromapp - storage_command.cpp, Copyright (c), 2015,
+ * Timothee Ewart - Swiss Federal Institute of technology in Lausanne,
+ * timothee.ewart@epfl.ch,
+ * All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+
+/**
+ * @file neuromapp/app/storage_command.cpp
+ * \brief commands of the driver acting on the storage of the data sets
+ */
+
+#include <iostream>
+#include <string>
+#include <boost/program_options.hpp>
+
+#include "app/storage_command.h"
+#include "coreneuron_1.0/common/data/helper.h"
+#include "coreneuron_1.0/common/util/nrnthread_handler.h"
+#include "utils/storage/storage.h"
+#include "utils/error.h"
+
+/** namespace alias for boost::program_options **/
+namespace po = boost::program_options;
+
+namespace {
+
+/** the path of the data set, owned by the background load: the command
+    line of the driver is gone when the load runs */
+struct prefetch_context {
+    std::string path;
+};
+
+void *make_nrnthread_owned(void *context){
+    prefetch_context *c = (prefetch_context *)context;
+    void *nt = make_nrnthread((void *)c->path.c_str());
+    delete c;
+    return nt;
+}
+
+}
+
+int prefetch_execute(int argc, char* const argv[]){
+    po::options_description desc("Allowed options");
+    desc.add_options()
+    ("help", "produce help message")
+    ("data", po::value<std::string>()->default_value(mapp::data_test()),
+     "path to the input")
+    ("name", po::value<std::string>()->default_value("coreneuron_1.0_kernel_data"),
+     "to internally reference the data, as the --name of the miniapp that uses it");
+
+    po::variables_map vm;
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    po::notify(vm);
+
+    if (vm.count("help")){
+        std::cout << desc;
+        return mapp::MAPP_USAGE;
+    }
+
+    std::string name = vm["name"].as<std::string>();
+    prefetch_context *c = new prefetch_context;
+    c->path = vm["data"].as<std::string>();
+
+    // c belongs to the load once it has started
+    if(storage_prefetch(name.c_str(), make_nrnthread_owned, c, free_nrnthread, size_nrnthread)){
+        std::cout << "loading " << name << " in the background" << std::endl;
+    }else{
+        delete c;
+        std::cout << name << " is already loaded or loading" << std::endl;
+    }
+    return mapp::MAPP_OK;
+}
+
+int storage_execute(int argc, char* const argv[]){
+    po::options_description desc("Allowed options");
+    desc.add_options()
+    ("help", "produce help message")
+    ("budget", po::value<double>(),
+     "memory budget of the data sets in MB, the least recently used data sets not "
+     "in use are evicted beyond it, 0 for unlimited")
+    ("clear", po::value<std::string>(),
+     "removes the data set of this name");
+
+    po::variables_map vm;
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    po::notify(vm);
+
+    if (vm.count("help")){
+        std::cout << desc;
+        return mapp::MAPP_USAGE;
+    }
+
+    if (vm.count("budget")){
+        double mb = vm["budget"].as<double>();
+        if(mb < 0.)
+            return mapp::MAPP_BAD_ARG;
+        storage_set_budget((size_t)(mb*1024*1024));
+    }
+
+    if (vm.count("clear"))
+        storage_clear(vm["clear"].as<std::string>().c_str());
+
+    storage_stats s;
+    storage_get_stats(&s);
+    const double mb = 1024.*1024.;
+    std::cout << "data sets: " << s.items << ", " << s.used/mb << " MB";
+    if(s.budget)
+        std::cout << " of " << s.budget/mb << " MB";
+    std::cout << "\nhits: " << s.hits << ", misses: " << s.misses
+              << ", evictions: " << s.evictions << std::endl;
+    return mapp::MAPP_OK;
+}
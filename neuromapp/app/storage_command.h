@@ -0,0 +1,47 @@
+/*
+ * Neuromapp - storage_command.h, Copyright (c), 2015,
+ * Timothee Ewart - Swiss Federal Institute of technology in Lausanne,
+ * timothee.ewart@epfl.ch,
+ * All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+
+/**
+ * @file neuromapp/app/storage_command.h
+ * \brief commands of the driver acting on the storage of the data sets
+ */
+
+#ifndef MAPP_STORAGE_COMMAND_
+#define MAPP_STORAGE_COMMAND_
+
+/** \fn prefetch_execute(int argc, char *const argv[])
+    \brief starts to load a data set in the storage on a background thread,
+    the next miniapp using the same --name finds it loaded
+    \param argc number of argument from the command line
+    \param argv the command line from the driver or external call
+    \return error message from mapp::mapp_error
+ */
+int prefetch_execute(int argc, char* const argv[]);
+
+/** \fn storage_execute(int argc, char *const argv[])
+    \brief sets the memory budget of the data sets, clears a data set,
+    and prints the usage of the storage
+    \param argc number of argument from the command line
+    \param argv the command line from the driver or external call
+    \return error message from mapp::mapp_error
+ */
+int storage_execute(int argc, char* const argv[]);
+
+#endif
@@ -0,0 +1,346 @@
+/*
+ * Neuromapp - main.cpp, Copyright (c), 2015,
+ * Timothee Ewart - Swiss Federal Institute of technology in Lausanne,
+ * timothee.ewart@epfl.ch,
+ * All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+
+/**
+ * @file neuromapp/bandwidth/main.cpp
+ * \brief Memory bandwidth baseline Miniapp
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include <unistd.h>
+#include <sys/time.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <boost/program_options.hpp>
+
+#include "bandwidth/bandwidth.h"
+#include "bandwidth/patterns.h"
+#include "coreneuron_1.0/kernel/mechanism/mechanism.h"
+#include "coreneuron_1.0/kernel/mechanism/descriptor.h"
+#include "coreneuron_1.0/common/util/nrnthread_handler.h"
+#include "coreneuron_1.0/common/data/helper.h"
+#include "utils/storage/storage.h"
+#include "utils/storage/neuromapp_data.h"
+#include "utils/error.h"
+
+/** namespace alias for boost::program_options **/
+namespace po = boost::program_options;
+
+namespace bandwidth {
+
+/** \fn void kernel_bytes(mech_descriptor const& d, Mechanism const& ml, double bytes[npatterns])
+    \brief compulsory traffic of a kernel by access pattern, from its descriptor
+ */
+void kernel_bytes(mech_descriptor const& d, Mechanism const& ml, double bytes[npatterns]){
+    bytes[pattern_stream] = mech_stream_bytes(&d, &ml);
+    bytes[pattern_gather] = mech_gather_bytes(&d, &ml);
+    bytes[pattern_scatter] = mech_scatter_bytes(&d, &ml);
+}
+
+/** \fn double now()
+    \return wall time in seconds
+ */
+inline double now(){
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return tv.tv_sec + 1e-6 * tv.tv_usec;
+}
+
+/** keeps the results of the patterns alive */
+volatile double sink;
+
+/** \fn void measure_patterns(NrnThread const* nt, int repeat, std::size_t sizes[npatterns], double gbs[npatterns])
+    \brief every thread runs the patterns on its own arrays, sized as the data
+    set: the stream on _ndata doubles, the gathers and scatters through the
+    nodeindices of all the mechanisms into arrays of end nodes
+    \param sizes receives the number of elements of every pattern, per thread
+    \param gbs receives the aggregated bandwidth of the best run, in GB/s
+ */
+void measure_patterns(NrnThread const* nt, int repeat, std::size_t sizes[npatterns], double gbs[npatterns]){
+    std::vector<int> idx;
+    for(int i = 0; i < nt->nmech; ++i)
+        if(!nt->ml[i].is_art)
+            idx.insert(idx.end(), nt->ml[i].nodeindices, nt->ml[i].nodeindices + nt->ml[i].nodecount);
+
+    sizes[pattern_stream] = nt->_ndata;
+    sizes[pattern_gather] = idx.size();
+    sizes[pattern_scatter] = idx.size();
+    double best[npatterns];
+    for(int p = 0; p < npatterns; ++p)
+        best[p] = std::numeric_limits<double>::max();
+    int nthreads = 1;
+
+    #pragma omp parallel
+    {
+        // first touch by the thread which uses them
+        std::vector<double> a(sizes[pattern_stream]), b(sizes[pattern_stream], 1.), c(sizes[pattern_stream], 2.);
+        std::vector<double> v(nt->end, 1.), out(idx.size()), x(idx.size(), 1e-3);
+        std::vector<int> local_idx(idx);
+        double t0 = 0.;
+#ifdef _OPENMP
+        #pragma omp single
+        nthreads = omp_get_num_threads();
+#endif
+        for(int r = 0; r < repeat; ++r){
+            for(int p = 0; p < npatterns; ++p){
+                #pragma omp barrier
+                #pragma omp master
+                t0 = now();
+                switch(p){
+                    case pattern_stream: triad(&a[0], &b[0], &c[0], 3., sizes[pattern_stream]); break;
+                    case pattern_gather: gather(&out[0], &v[0], &local_idx[0], idx.size()); break;
+                    case pattern_scatter: scatter_add(&v[0], &x[0], &local_idx[0], idx.size()); break;
+                }
+                #pragma omp barrier
+                #pragma omp master
+                {
+                    double t = now() - t0;
+                    if(t < best[p])
+                        best[p] = t;
+                }
+            }
+        }
+        #pragma omp critical
+        sink = sink + a[0] + out[0] + v[0];
+    }
+
+    for(int p = 0; p < npatterns; ++p)
+        gbs[p] = nthreads * sizes[p] * bytes_per_element[p] / best[p] * 1e-9;
+}
+
+/** \fn double measure_flops(int repeat)
+    \brief every thread runs independent multiply-adds on registers
+    \return the aggregated floating point rate of the best run, in GFLOP/s
+ */
+double measure_flops(int repeat){
+    const std::size_t n = 1 << 16;
+    double best = std::numeric_limits<double>::max();
+    int nthreads = 1;
+    #pragma omp parallel
+    {
+        std::vector<double> x(flops_width, 1.);
+        double t0 = 0.;
+#ifdef _OPENMP
+        #pragma omp single
+        nthreads = omp_get_num_threads();
+#endif
+        for(int r = 0; r < repeat; ++r){
+            #pragma omp barrier
+            #pragma omp master
+            t0 = now();
+            multiply_add(&x[0], n);
+            #pragma omp barrier
+            #pragma omp master
+            {
+                double t = now() - t0;
+                if(t < best)
+                    best = t;
+            }
+        }
+        #pragma omp critical
+        sink = sink + x[0];
+    }
+    return nthreads * 2. * flops_width * n / best * 1e-9;
+}
+
+/** \fn std::size_t flush_size()
+    \return the doubles a thread streams through to evict the data of the
+    previous run, twice the last level cache shared by the threads
+ */
+std::size_t flush_size(){
+    long llc = -1;
+#ifdef _SC_LEVEL3_CACHE_SIZE
+    llc = sysconf(_SC_LEVEL3_CACHE_SIZE);
+#endif
+    if(llc <= 0)
+        llc = 32 * 1024 * 1024;
+    int nthreads = 1;
+#ifdef _OPENMP
+    nthreads = omp_get_max_threads();
+#endif
+    return 2 * llc / nthreads / sizeof(double);
+}
+
+/** \fn double measure_kernel(NrnThread *nt, mech_descriptor const& k, int repeat)
+    \brief every thread runs the kernel on its own clone of the data set, the
+    caches are flushed before every run as the ceilings are measured from memory
+    \return the best time in seconds
+ */
+double measure_kernel(NrnThread *nt, mech_descriptor const& k, int repeat){
+    double best = std::numeric_limits<double>::max();
+    std::size_t n = flush_size();
+    #pragma omp parallel
+    {
+        NrnThread *clone = (NrnThread *) clone_nrnthread(nt);
+        std::vector<double> flush(n, 1.);
+        double t0 = 0.;
+        for(int r = 0; r < repeat; ++r){
+            double s = 0.;
+            for(std::size_t i = 0; i < n; ++i)
+                s += flush[i];
+            flush[r % n] = s;
+            #pragma omp barrier
+            #pragma omp master
+            t0 = now();
+            k.f(clone, &clone->ml[k.mech_id]);
+            #pragma omp barrier
+            #pragma omp master
+            {
+                double t = now() - t0;
+                if(t < best)
+                    best = t;
+            }
+        }
+        free_nrnthread(clone);
+    }
+    return best;
+}
+
+/** \fn help(int argc, char *const argv[], po::variables_map& vm)
+    \brief Helper using boost program option to facilitate the command line manipulation
+    \param argc number of argument from the command line
+    \param argv the command line from the driver or external call
+    \param vm encapsulate the command line
+    \return error message from mapp::mapp_error
+ */
+int help(int argc, char* const argv[], po::variables_map& vm){
+    po::options_description desc("Allowed options");
+    desc.add_options()
+    ("help", "produce help message")
+    ("data", po::value<std::string>()->default_value(mapp::data_test()), "path to the input")
+    ("name", po::value<std::string>()->default_value("coreneuron_1.0_kernel_data"),
+     "to internally reference the data, as the --name of the kernel miniapp")
+    ("numthread", po::value<int>()->default_value(1), "number of OMP thread")
+    ("repeat", po::value<int>()->default_value(10), "number of runs, the best one is reported");
+
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    po::notify(vm);
+
+    if (vm.count("help")){
+        std::cout << desc;
+        return mapp::MAPP_USAGE;
+    }
+
+    if(vm["numthread"].as<int>() < 1 || vm["repeat"].as<int>() < 1)
+        return mapp::MAPP_BAD_ARG;
+
+    if(access(vm["data"].as<std::string>().c_str(), F_OK) == -1)
+        return mapp::MAPP_BAD_DATA;
+
+#ifdef _OPENMP
+    omp_set_num_threads(vm["numthread"].as<int>());
+#endif
+    return mapp::MAPP_OK;
+}
+
+/** \fn content(po::variables_map const& vm)
+    \brief Measures the ceilings, then the mechanism kernels against them
+    \param vm encapsulate the command line and all needed informations
+ */
+int content(po::variables_map const& vm){
+    std::string name = vm["name"].as<std::string>();
+    std::string data = vm["data"].as<std::string>();
+    int repeat = vm["repeat"].as<int>();
+    NrnThread *nt = (NrnThread *) storage_acquire(name.c_str(), make_nrnthread, (void *)data.c_str(),
+                                                  free_nrnthread, size_nrnthread);
+    if(nt == NULL){
+        storage_clear(name.c_str());
+        return mapp::MAPP_BAD_DATA;
+    }
+
+    std::size_t sizes[npatterns];
+    double gbs[npatterns];
+    measure_patterns(nt, repeat, sizes, gbs);
+
+    std::cout << "\n Bandwidth: " << vm["numthread"].as<int>() << " threads, best of "
+              << repeat << " runs\n" << std::fixed;
+    for(int p = 0; p < npatterns; ++p){
+        std::cout << "   " << std::left << std::setw(10) << pattern_names[p] << std::right
+                  << std::setw(10) << sizes[p] << " elements " << std::setprecision(2)
+                  << std::setw(8) << gbs[p] << " GB/s\n";
+        neuromapp_data.put_copy(std::string("bandwidth_") + pattern_names[p], gbs[p]);
+    }
+
+    double gflops = measure_flops(repeat);
+    std::cout << "   " << std::left << std::setw(10) << "flops" << std::right << std::setw(19)
+              << " " << std::setprecision(2) << std::setw(8) << gflops << " GFLOP/s\n";
+    neuromapp_data.put_copy(std::string("bandwidth_flops"), gflops);
+
+    // the memory ceiling of a kernel is the mix of the ceilings of its patterns
+    std::cout << " Roofline: bytes and flops per instance, arithmetic intensity [flop/B],\n"
+              << " achieved GB/s and GFLOP/s, attainable GFLOP/s and fraction of the roofline\n";
+    for(int i = 0; i < mech_ndescriptors; ++i){
+        mech_descriptor const& k = mech_descriptors[i];
+        Mechanism const& ml = nt->ml[k.mech_id];
+        if(mech_descriptor_check(&k, &ml) != 0 || ml.nodecount == 0)
+            continue;
+        double bytes[npatterns], total = 0., ceiling_time = 0.;
+        kernel_bytes(k, ml, bytes);
+        for(int p = 0; p < npatterns; ++p){
+            total += bytes[p];
+            ceiling_time += bytes[p] / (gbs[p] * 1e9);
+        }
+        double flops = mech_flops(&k, &ml);
+        double intensity = flops / total;
+        double memory_gbs = total / ceiling_time * 1e-9;
+        double attainable = std::min(gflops, intensity * memory_gbs);
+
+        int nthreads = vm["numthread"].as<int>();
+        double t = measure_kernel(nt, k, repeat);
+        double achieved = nthreads * flops / t * 1e-9;
+        std::string name = std::string(k.mechanism) + " " + k.function;
+        std::cout << "   " << std::left << std::setw(22) << name << std::right
+                  << std::setprecision(0) << std::setw(6) << total / ml.nodecount << " B "
+                  << std::setw(5) << flops / ml.nodecount << " flop "
+                  << std::setprecision(2) << std::setw(6) << intensity << " "
+                  << std::setw(8) << nthreads * total / t * 1e-9 << " GB/s "
+                  << std::setw(8) << achieved << " GFLOP/s "
+                  << std::setw(8) << attainable << " GFLOP/s "
+                  << std::setprecision(0) << std::setw(4) << 100. * achieved / attainable << " % "
+                  << (intensity * memory_gbs < gflops ? "memory" : "compute") << " bound\n";
+    }
+    std::cout.unsetf(std::ios::floatfield);
+    std::cout << std::setprecision(6);
+
+    storage_release(name.c_str());
+    return mapp::MAPP_OK;
+}
+
+} // end namespace
+
+int bandwidth_execute(int argc, char* const argv[]){
+    try {
+        po::variables_map vm; // it contains everything
+        if(int error = bandwidth::help(argc, argv, vm)) return error;
+        return bandwidth::content(vm); // execute the miniapp
+    }
+    catch(std::exception& e){
+        std::cout << e.what() << "\n";
+        return mapp::MAPP_UNKNOWN_ERROR;
+    }
+}
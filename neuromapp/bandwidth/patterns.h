@@ -0,0 +1,95 @@
+/*
+ * Neuromapp - patterns.h, Copyright (c), 2015,
+ * Timothee Ewart - Swiss Federal Institute of technology in Lausanne,
+ * timothee.ewart@epfl.ch,
+ * All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+
+/**
+ * @file neuromapp/bandwidth/patterns.h
+ * \brief The memory access patterns of the NrnThread kernels
+ */
+
+#ifndef MAPP_BANDWIDTH_PATTERNS_H_
+#define MAPP_BANDWIDTH_PATTERNS_H_
+
+#include <cstddef>
+
+namespace bandwidth {
+
+/** \enum pattern
+    \brief the access patterns measured
+ */
+enum pattern { pattern_stream = 0, pattern_gather, pattern_scatter, npatterns };
+
+/** bytes moved per element of every pattern */
+const double bytes_per_element[npatterns] = {
+    3 * sizeof(double),                  // read b and c, write a
+    sizeof(int) + 2 * sizeof(double),    // read the index and the gathered value, write out
+    sizeof(int) + 3 * sizeof(double)     // read the index and x, read and write rhs
+};
+
+/** names of the patterns */
+const char * const pattern_names[npatterns] = {"stream", "gather", "scatter"};
+
+/** \fn void triad(double *a, const double *b, const double *c, double s, std::size_t n)
+    \brief sequential SoA streams, as the loops over the data of a mechanism
+ */
+inline void triad(double * __restrict__ a, const double * __restrict__ b,
+                  const double * __restrict__ c, double s, std::size_t n){
+    for(std::size_t i = 0; i < n; ++i)
+        a[i] = b[i] + s * c[i];
+}
+
+/** \fn void gather(double *out, const double *v, const int *idx, std::size_t n)
+    \brief indexed reads, as _vec_v[_ni[_iml]]
+ */
+inline void gather(double * __restrict__ out, const double * __restrict__ v,
+                   const int * __restrict__ idx, std::size_t n){
+    for(std::size_t i = 0; i < n; ++i)
+        out[i] = v[idx[i]];
+}
+
+/** \fn void scatter_add(double *rhs, const double *x, const int *idx, std::size_t n)
+    \brief indexed updates, as _vec_rhs[_nd_idx] -= _rhs
+ */
+inline void scatter_add(double * __restrict__ rhs, const double * __restrict__ x,
+                        const int * __restrict__ idx, std::size_t n){
+    for(std::size_t i = 0; i < n; ++i)
+        rhs[idx[i]] -= x[i];
+}
+
+/** independent accumulators of the FLOP ceiling, enough to fill the pipelines */
+const int flops_width = 32;
+
+/** \fn void multiply_add(double *x, std::size_t n)
+    \brief 2 n flops_width floating point operations on registers, the
+    compute ceiling: independent multiply-adds without memory traffic
+ */
+inline void multiply_add(double * __restrict__ x, std::size_t n){
+    double acc[flops_width];
+    for(int j = 0; j < flops_width; ++j)
+        acc[j] = x[j];
+    for(std::size_t i = 0; i < n; ++i)
+        for(int j = 0; j < flops_width; ++j)
+            acc[j] = acc[j] * 0.999999 + 1e-6;
+    for(int j = 0; j < flops_width; ++j)
+        x[j] = acc[j];
+}
+
+} // end namespace
+
+#endif
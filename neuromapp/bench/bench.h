@@ -0,0 +1,48 @@
+/*
+ * Neuromapp - bench.h, Copyright (c), 2015,
+ * Timothee Ewart - Swiss Federal Institute of technology in Lausanne,
+ * timothee.ewart@epfl.ch,
+ * All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+
+/**
+ * @file neuromapp/bench/bench.h
+ * \brief Benchmark harness miniapp
+ */
+
+#ifndef MAPP_BENCH_EXECUTE_
+#define MAPP_BENCH_EXECUTE_
+
+namespace mapp{
+    class driver;
+}
+
+/** \fn bench_driver(mapp::driver* d)
+    \brief the miniapps bench can run are the ones registered in d
+    \param d the driver of the application, must outlive the runs of bench
+ */
+void bench_driver(mapp::driver* d);
+
+/** \fn bench_execute(int argc, char *const argv[])
+    \brief runs a miniapp of the driver several times and reports the statistics
+    of the duration of its compute phase
+    \param argc number of argument from the command line
+    \param argv the command line from the driver or external call
+    \return error message from mapp::mapp_error
+ */
+int bench_execute(int argc, char* const argv[]);
+
+#endif
@@ -0,0 +1,316 @@
+/*
+ * Neuromapp - main.cpp, Copyright (c), 2015,
+ * Timothee Ewart - Swiss Federal Institute of technology in Lausanne,
+ * timothee.ewart@epfl.ch,
+ * All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+
+/**
+ * @file neuromapp/bench/main.cpp
+ * \brief Runs a miniapp of the driver several times and reports the statistics
+ */
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cstdlib>
+#include <sys/time.h>
+#include <boost/program_options.hpp>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "bench/bench.h"
+#include "bench/statistics.h"
+#include "neuromapp/bench/build_info.h" // this file is generated automatically
+#include "app/driver.h"
+#include "app/driver_exception.h"
+#include "utils/argv_data.h"
+#include "utils/storage/neuromapp_data.h"
+#include "utils/error.h"
+
+/** namespace alias for boost::program_options **/
+namespace po = boost::program_options;
+
+namespace bench {
+
+/** the driver of the application */
+mapp::driver* driver = NULL;
+
+/** \struct run_description
+    \brief what was benchmarked, reported with the statistics
+ */
+struct run_description {
+    std::string miniapp;
+    std::string arguments;
+    std::string dataset;
+    int threads;
+    int warmup;
+    int repeat;
+    /** "compute" if the miniapp reported its compute phase, else "wall" */
+    std::string timer;
+};
+
+/** \fn std::string option_value(std::vector<std::string> const& args, std::string const& option)
+    \return the value of --option in args (--option value or --option=value), empty if absent
+ */
+std::string option_value(std::vector<std::string> const& args, std::string const& option){
+    for(std::size_t i = 0; i < args.size(); ++i){
+        if(args[i] == option && i + 1 < args.size())
+            return args[i+1];
+        if(args[i].compare(0, option.size() + 1, option + "=") == 0)
+            return args[i].substr(option.size() + 1);
+    }
+    return std::string();
+}
+
+/** \fn std::string json_string(std::string const& s)
+    \return s quoted and escaped for JSON
+ */
+std::string json_string(std::string const& s){
+    std::string r("\"");
+    for(std::size_t i = 0; i < s.size(); ++i){
+        if(s[i] == '"' || s[i] == '\\')
+            r += '\\';
+        if(s[i] == '\n')
+            r += "\\n";
+        else
+            r += s[i];
+    }
+    return r + "\"";
+}
+
+/** \fn std::string csv_string(std::string const& s)
+    \return s quoted for CSV
+ */
+std::string csv_string(std::string const& s){
+    std::string r("\"");
+    for(std::size_t i = 0; i < s.size(); ++i){
+        if(s[i] == '"')
+            r += '"';
+        r += s[i];
+    }
+    return r + "\"";
+}
+
+/** \fn void write_json(std::ostream& out, run_description const& d, summary const& s, std::vector<double> const& samples)
+    \brief one JSON object per line and per run of bench, the times in seconds
+ */
+void write_json(std::ostream& out, run_description const& d, summary const& s,
+                std::vector<double> const& samples){
+    out.precision(9);
+    out << "{\"miniapp\": " << json_string(d.miniapp)
+        << ", \"arguments\": " << json_string(d.arguments)
+        << ", \"dataset\": " << json_string(d.dataset)
+        << ", \"threads\": " << d.threads
+        << ", \"warmup\": " << d.warmup
+        << ", \"repeat\": " << d.repeat
+        << ", \"timer\": " << json_string(d.timer)
+        << ", \"build\": {\"type\": " << json_string(build_info::type())
+        << ", \"compiler\": " << json_string(build_info::compiler())
+        << ", \"c_flags\": " << json_string(build_info::c_flags())
+        << ", \"cxx_flags\": " << json_string(build_info::cxx_flags())
+        << ", \"options\": " << json_string(build_info::options()) << "}"
+        << ", \"mean\": " << s.mean
+        << ", \"median\": " << s.median
+        << ", \"stddev\": " << s.stddev
+        << ", \"min\": " << s.min
+        << ", \"max\": " << s.max
+        << ", \"ci95_low\": " << s.ci95_low
+        << ", \"ci95_high\": " << s.ci95_high
+        << ", \"samples\": [";
+    for(std::size_t i = 0; i < samples.size(); ++i)
+        out << (i ? ", " : "") << samples[i];
+    out << "]}\n";
+}
+
+/** \fn void write_csv(std::ostream& out, run_description const& d, summary const& s, bool header)
+    \brief one CSV row per run of bench, the times in seconds
+ */
+void write_csv(std::ostream& out, run_description const& d, summary const& s, bool header){
+    if(header)
+        out << "miniapp,arguments,dataset,threads,warmup,repeat,timer,build_type,compiler,"
+            << "c_flags,cxx_flags,options,mean,median,stddev,min,max,ci95_low,ci95_high\n";
+    out.precision(9);
+    out << csv_string(d.miniapp) << "," << csv_string(d.arguments) << ","
+        << csv_string(d.dataset) << "," << d.threads << "," << d.warmup << ","
+        << d.repeat << "," << d.timer << ","
+        << csv_string(build_info::type()) << "," << csv_string(build_info::compiler()) << ","
+        << csv_string(build_info::c_flags()) << "," << csv_string(build_info::cxx_flags()) << ","
+        << csv_string(build_info::options()) << ","
+        << s.mean << "," << s.median << "," << s.stddev << "," << s.min << ","
+        << s.max << "," << s.ci95_low << "," << s.ci95_high << "\n";
+}
+
+/** \fn int run_once(std::vector<std::string> const& command, double& seconds, bool& compute)
+    \brief runs the miniapp once
+    \param command the command line of the driver, the name of the miniapp first
+    \param seconds the duration of the compute phase if the miniapp reports it, else of the call
+    \param compute true if the miniapp reported its compute phase
+    \return error message from mapp::mapp_error
+ */
+int run_once(std::vector<std::string> const& command, double& seconds, bool& compute){
+    std::vector<std::string> v(1, "bench");
+    v.insert(v.end(), command.begin(), command.end());
+    mapp::argv_data A(v.begin(), v.end());
+
+    neuromapp_data.clear(STORAGE_COMPUTE_TIME);
+    struct timeval start, end;
+    gettimeofday(&start, NULL);
+    try {
+        driver->execute(A.argc(), A.argv());
+    } catch(mapp::driver_exception & e) {
+        return e.error_code;
+    }
+    gettimeofday(&end, NULL);
+
+    compute = neuromapp_data.has<double>(STORAGE_COMPUTE_TIME);
+    if(compute)
+        seconds = neuromapp_data.get<double>(STORAGE_COMPUTE_TIME);
+    else
+        seconds = (end.tv_sec - start.tv_sec) + 1e-6 * (end.tv_usec - start.tv_usec);
+    return mapp::MAPP_OK;
+}
+
+/** \fn help(int argc, char *const argv[], po::variables_map& vm, std::vector<std::string>& command)
+    \brief Helper using boost program option to facilitate the command line manipulation
+    \param argc number of argument from the command line
+    \param argv the command line from the driver or external call
+    \param vm encapsulate the command line of bench
+    \param command the command line of the miniapp, after --
+    \return error message from mapp::mapp_error
+ */
+int help(int argc, char* const argv[], po::variables_map& vm, std::vector<std::string>& command){
+    po::options_description desc("Usage: bench [options] -- miniapp [arguments of the miniapp]\n"
+                                  "Allowed options");
+    desc.add_options()
+    ("help", "produce help message")
+    ("warmup", po::value<int>()->default_value(1),
+     "number of runs before the measure, they load the data set in the storage")
+    ("repeat", po::value<int>()->default_value(10),
+     "number of measured runs")
+    ("output", po::value<std::string>(),
+     "file the results are written to, appended to if it exists")
+    ("format", po::value<std::string>()->default_value("json"),
+     "format of the output: json or csv");
+
+    // the arguments after -- belong to the miniapp
+    int n = 1;
+    while(n < argc && std::strcmp(argv[n], "--") != 0)
+        ++n;
+    for(int i = n + 1; i < argc; ++i)
+        command.push_back(argv[i]);
+
+    po::store(po::parse_command_line(n, argv, desc), vm);
+    po::notify(vm);
+
+    if (vm.count("help") || command.empty()){
+        std::cout << desc;
+        return mapp::MAPP_USAGE;
+    }
+
+    if(vm["warmup"].as<int>() < 0 || vm["repeat"].as<int>() < 1)
+        return mapp::MAPP_BAD_ARG;
+
+    std::string format = vm["format"].as<std::string>();
+    if(format != "json" && format != "csv")
+        return mapp::MAPP_BAD_ARG;
+
+    if(driver == NULL || !driver->has(command[0]) || command[0] == "bench")
+        return mapp::MAPP_BAD_ARG;
+
+    return mapp::MAPP_OK;
+}
+
+/** \fn int bench_miniapp(po::variables_map const& vm, std::vector<std::string> const& command)
+    \brief runs the warmup and the measure, prints the summary and writes the output
+ */
+int bench_miniapp(po::variables_map const& vm, std::vector<std::string> const& command){
+    run_description d;
+    d.miniapp = command[0];
+    std::vector<std::string> args(command.begin() + 1, command.end());
+    for(std::size_t i = 0; i < args.size(); ++i)
+        d.arguments += (i ? " " : "") + args[i];
+    d.dataset = option_value(args, "--data");
+    std::string threads = option_value(args, "--numthread");
+    d.threads = 1;
+#ifdef _OPENMP
+    d.threads = omp_get_max_threads();
+#endif
+    if(!threads.empty())
+        d.threads = std::atoi(threads.c_str());
+    d.warmup = vm["warmup"].as<int>();
+    d.repeat = vm["repeat"].as<int>();
+
+    double seconds = 0.;
+    bool compute = true;
+    for(int i = 0; i < d.warmup; ++i)
+        if(int error = run_once(command, seconds, compute))
+            return error;
+
+    std::vector<double> samples;
+    bool all_compute = true;
+    for(int i = 0; i < d.repeat; ++i){
+        if(int error = run_once(command, seconds, compute))
+            return error;
+        all_compute = all_compute && compute;
+        samples.push_back(seconds);
+    }
+    d.timer = all_compute ? "compute" : "wall";
+
+    summary s = summarize(samples);
+    std::cout << "\n" << d.miniapp << " (" << d.timer << ", " << d.repeat << " runs): mean "
+              << s.mean << " [s], median " << s.median << " [s], stddev " << s.stddev
+              << " [s], 95% CI [" << s.ci95_low << ", " << s.ci95_high << "] [s]" << std::endl;
+
+    if(vm.count("output")){
+        std::string name = vm["output"].as<std::string>();
+        std::ifstream in(name.c_str());
+        bool empty = !in.good() || in.peek() == std::ifstream::traits_type::eof();
+        in.close();
+        std::ofstream out(name.c_str(), std::ios::app);
+        if(!out.good())
+            return mapp::MAPP_BAD_ARG;
+        if(vm["format"].as<std::string>() == "csv")
+            write_csv(out, d, s, empty);
+        else
+            write_json(out, d, s, samples);
+    }
+    return mapp::MAPP_OK;
+}
+
+} //end namespace
+
+void bench_driver(mapp::driver* d){
+    bench::driver = d;
+}
+
+int bench_execute(int argc, char* const argv[]){
+    try {
+        po::variables_map vm; // it contains everything
+        std::vector<std::string> command;
+        if(int error = bench::help(argc, argv, vm, command)) return error;
+        return bench::bench_miniapp(vm, command); // execute the miniapp
+    }
+    catch(std::exception& e){
+        std::cout << e.what() << "\n";
+        return mapp::MAPP_UNKNOWN_ERROR;
+    }
+}
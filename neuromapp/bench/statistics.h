@@ -0,0 +1,105 @@
+/*
+ * Neuromapp - statistics.h, Copyright (c), 2015,
+ * Timothee Ewart - Swiss Federal Institute of technology in Lausanne,
+ * timothee.ewart@epfl.ch,
+ * All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+
+/**
+ * @file neuromapp/bench/statistics.h
+ * \brief Summary statistics of the timings of the bench miniapp
+ */
+
+#ifndef MAPP_BENCH_STATISTICS_H_
+#define MAPP_BENCH_STATISTICS_H_
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+namespace bench {
+
+/** \fn double student_t95(std::size_t dof)
+    \brief two-sided 95% quantile of the Student t distribution
+    \param dof degrees of freedom, at least 1
+ */
+inline double student_t95(std::size_t dof){
+    static const double t[30] = {12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+                                 2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+                                 2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+    if(dof == 0)
+        return 0.;
+    if(dof <= 30)
+        return t[dof-1];
+    if(dof <= 60)
+        return 2.000;
+    if(dof <= 120)
+        return 1.980;
+    return 1.960;
+}
+
+/** \struct summary
+    \brief statistics of a sample of timings, in the unit of the samples
+ */
+struct summary {
+    std::size_t n;
+    double mean;
+    double median;
+    /** sample standard deviation, 0 for less than 2 samples */
+    double stddev;
+    double min;
+    double max;
+    /** 95% confidence interval of the mean */
+    double ci95_low;
+    double ci95_high;
+};
+
+/** \fn summary summarize(std::vector<double> samples)
+    \brief computes the statistics of the samples, all zero if empty
+ */
+inline summary summarize(std::vector<double> samples){
+    summary s = {samples.size(), 0., 0., 0., 0., 0., 0., 0.};
+    if(samples.empty())
+        return s;
+
+    std::sort(samples.begin(), samples.end());
+    std::size_t n = samples.size();
+    s.min = samples.front();
+    s.max = samples.back();
+    s.median = (n % 2) ? samples[n/2] : 0.5 * (samples[n/2-1] + samples[n/2]);
+
+    double sum = 0.;
+    for(std::size_t i = 0; i < n; ++i)
+        sum += samples[i];
+    s.mean = sum / n;
+
+    if(n > 1){
+        double sq = 0.;
+        for(std::size_t i = 0; i < n; ++i)
+            sq += (samples[i] - s.mean) * (samples[i] - s.mean);
+        s.stddev = std::sqrt(sq / (n - 1));
+    }
+
+    double half = student_t95(n - 1) * s.stddev / std::sqrt((double)n);
+    s.ci95_low = s.mean - half;
+    s.ci95_high = s.mean + half;
+    return s;
+}
+
+} // end namespace
+
+#endif
@@ -0,0 +1,387 @@
+/*
+ * Neuromapp - generator.c, Copyright (c), 2015,
+ * Timothee Ewart - Swiss Federal Institute of technology in Lausanne,
+ * Pramod Kumbhar - Swiss Federal Institute of technology in Lausanne,
+ * timothee.ewart@epfl.ch,
+ * paramod.kumbhar@epfl.ch
+ * All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+
+/**
+ * @file neuromapp/coreneuron_1.0/common/memory/generator.c
+ * \brief Construction of synthetic NrnThread data sets of any size
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#include "coreneuron_1.0/common/memory/generator.h"
+#include "coreneuron_1.0/common/memory/memory.h"
+#include "utils/error.h"
+
+/** \enum gen_kind
+ *  \brief how the instances of a mechanism are placed
+ */
+enum gen_kind {
+    /** at most one instance per compartment */
+    GEN_CHANNEL,
+    /** one instance where a channel uses the ion */
+    GEN_ION,
+    /** any number of instances per compartment, pdata: area, point process */
+    GEN_POINT,
+    /** without compartment, pdata: instance */
+    GEN_ARTIFICIAL
+};
+
+/** \struct gen_mechanism
+ *  \brief a mechanism of the generated data sets
+ */
+struct gen_mechanism {
+    /** name for nrn_generator_density(), NULL if only the type is known */
+    const char *name;
+    int type;
+    enum gen_kind kind;
+    int szp;
+    int szdp;
+    /** index of the ion the pdata of a channel point to, -1 if none */
+    int ion;
+    /** instances per compartment in bench.101392 */
+    double density;
+    /** values of the fields of an instance, NULL for zeros */
+    const double *init;
+};
+
+/* the fields of instance 0 of bench.101392, nodecount_pad apart in the file */
+static const double init_capacitance[] = {1., 0.};
+static const double init_pas[] = {3e-05, -75., 0.0003, -65., 0.};
+/* e, the inside and outside concentrations, i and di/dv */
+static const double init_na_ion[] = {50., 10., 140., 0., 0.};
+static const double init_k_ion[] = {-85., 54.4, 2.5, 0., 0.};
+static const double init_ca_ion[] = {140.2, 5e-05, 2., 0., 0.};
+static const double init_Ih[] = {8e-05, 0.0111, 0., 0., -65., 0.};
+static const double init_Na[] = {0.927, 0.00596, 0.697, 50., 0., 0., -65., 0.};
+static const double init_ProbAMPANMDA[] = {
+    0.2, 1.85198, 0.29, 43., 0.512443, 682., 20., 0., 1., 0., 9., 0., 0.8,
+    0.882497, 0.986592, 0.917404, 0.999419, 1., 0., 0., 0., 0., 0., 0., 0., 0., 0.,
+    1.46776, 1.04155, 0., 0., 0., 0., 0., -65., 0., -1e+20};
+static const double init_ProbGABAAB[] = {
+    0.061792, 36.6817, 3.5, 260.9, 0.268166, 763., 22., -80., -97., 0., 46., 0., 0.75,
+    0.667253, 0.999319, 0.992883, 0.999904, 1., 0., 0., 0., 0., 0., 0., 0., 0., 0., 0., 0.,
+    1.01254, 1.07479, 0., 0., 0., 0., -65., 0., -1e+20};
+
+/** the mechanisms of bench.101392, the densities are its counts over its 8039 compartments */
+static const struct gen_mechanism gen_mechanisms[NRN_GENERATOR_NMECH] = {
+    {"capacitance", 3, GEN_CHANNEL, 2, 0, -1, 0.777, init_capacitance},
+    {"pas", 4, GEN_CHANNEL, 5, 0, -1, 0.777, init_pas},
+    {"na_ion", 15, GEN_ION, 5, 1, -1, 0., init_na_ion},
+    {"k_ion", 16, GEN_ION, 5, 1, -1, 0., init_k_ion},
+    {"ca_ion", 28, GEN_ION, 5, 1, -1, 0., init_ca_ion},
+    {NULL, 32, GEN_CHANNEL, 9, 3, 4, 0.0063, NULL},
+    {NULL, 7, GEN_POINT, 6, 2, -1, 0.0063, NULL},
+    {NULL, 35, GEN_CHANNEL, 18, 3, 4, 0.006, NULL},
+    {NULL, 44, GEN_CHANNEL, 14, 3, 4, 0.0063, NULL},
+    {NULL, 45, GEN_CHANNEL, 18, 3, 4, 0.0004, NULL},
+    {"Ih", 69, GEN_CHANNEL, 6, 0, -1, 0.773, init_Ih},
+    {NULL, 71, GEN_CHANNEL, 6, 3, 3, 0.461, NULL},
+    {NULL, 82, GEN_CHANNEL, 13, 2, 3, 0.0193, NULL},
+    {NULL, 91, GEN_CHANNEL, 14, 3, 3, 0.0235, NULL},
+    {NULL, 98, GEN_CHANNEL, 14, 3, 3, 0.0235, NULL},
+    {NULL, 119, GEN_CHANNEL, 18, 3, 2, 0.0235, NULL},
+    {NULL, 122, GEN_CHANNEL, 18, 3, 2, 0.0042, NULL},
+    {"Na", 125, GEN_CHANNEL, 8, 3, 2, 0.4626, init_Na},
+    {"ProbAMPANMDA", 134, GEN_POINT, 37, 3, -1, 2.477, init_ProbAMPANMDA},
+    {"ProbGABAAB", 136, GEN_POINT, 38, 3, -1, 1.097, init_ProbGABAAB},
+    {NULL, 141, GEN_CHANNEL, 10, 4, 3, 0.0063, NULL},
+    {NULL, 144, GEN_CHANNEL, 6, 3, 3, 0.4669, NULL},
+    {NULL, 26, GEN_ARTIFICIAL, 1, 3, -1, 0.000125, NULL},
+    {NULL, 129, GEN_ARTIFICIAL, 8, 7, -1, 3.574, NULL}
+};
+
+/** fields of an ion the successive pdata of a channel point to: e, i, di/dv, the inside concentration */
+static const int gen_ion_fields[] = {0, 3, 4, 1};
+
+void nrn_generator_default(struct nrn_generator *g) {
+    int i;
+    g->ncell = 17;
+    g->ncompartment = 473;
+    g->section = 10;
+    g->branching = 2;
+    g->seed = 101392;
+    for (i=0; i<NRN_GENERATOR_NMECH; i++)
+        g->density[i] = gen_mechanisms[i].density;
+}
+
+int nrn_generator_density(struct nrn_generator *g, const char *spec) {
+    const char *p = spec;
+    while (1) {
+        int i, found = -1;
+        size_t len = strcspn(p, "=,");
+        char *end;
+        double d;
+        if (len == 0 || p[len] != '=')
+            return -1;
+        for (i=0; i<NRN_GENERATOR_NMECH; i++) {
+            const struct gen_mechanism *m = &gen_mechanisms[i];
+            if (m->name && strlen(m->name) == len && strncmp(m->name, p, len) == 0)
+                found = i;
+            if (strtol(p, &end, 10) == m->type && end == p + len)
+                found = i;
+        }
+        if (found < 0 || gen_mechanisms[found].kind == GEN_ION)
+            return -1;
+        d = strtod(p + len + 1, &end);
+        if (end == p + len + 1 || d < 0. || (gen_mechanisms[found].kind == GEN_CHANNEL && d > 1.))
+            return -1;
+        g->density[found] = d;
+        if (*end == '\0')
+            return 0;
+        if (*end != ',')
+            return -1;
+        p = end + 1;
+    }
+}
+
+enum nrn_pdata nrn_pdata_semantics(int type, int slot) {
+    int i;
+    for (i=0; i<NRN_GENERATOR_NMECH; i++) {
+        if (gen_mechanisms[i].type != type)
+            continue;
+        switch (gen_mechanisms[i].kind) {
+            case GEN_ION:
+                return NRN_PDATA_VALUE;
+            case GEN_POINT:
+                return slot == 0 ? NRN_PDATA_DATA : NRN_PDATA_INSTANCE;
+            case GEN_ARTIFICIAL:
+                return NRN_PDATA_INSTANCE;
+            default:
+                return NRN_PDATA_DATA;
+        }
+    }
+    return NRN_PDATA_DATA;
+}
+
+/** \brief Uniform random number in [0,1), a 64 bits linear congruential
+ *  generator: the data sets do not depend on the libc. */
+static double gen_uniform(unsigned long long *state) {
+    *state = *state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return (*state >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/** \struct gen_nodes
+ *  \brief the compartments of the instances of a mechanism, sorted
+ */
+struct gen_nodes {
+    int *node;
+    int n;
+    int capacity;
+};
+
+static void gen_push(struct gen_nodes *l, int node) {
+    if (l->n == l->capacity) {
+        l->capacity = l->capacity ? 2*l->capacity : 64;
+        l->node = (int *)realloc(l->node, sizeof(int) * l->capacity);
+    }
+    l->node[l->n++] = node;
+}
+
+/** \brief Node of the compartment j of the cell c: the roots first, as the
+ *  solver expects, then the compartments of every cell in a row. */
+static int gen_node(const struct nrn_generator *g, int c, int j) {
+    return j == 0 ? c : g->ncell + c*(g->ncompartment - 1) + j - 1;
+}
+
+/** \brief Parent of the compartment j > 0: the previous one in its section,
+ *  or the end of the parent section, the sections numbered breadth first. */
+static int gen_parent(const struct nrn_generator *g, int j) {
+    int s = (j - 1) / g->section;
+    if ((j - 1) % g->section)
+        return j - 1;
+    if (s == 0)
+        return 0;
+    return ((s - 1) / g->branching + 1) * g->section;
+}
+
+/** \brief Places the instances of every mechanism on the compartments. */
+static void gen_place(const struct nrn_generator *g, int end, struct gen_nodes nodes[]) {
+    int i, k, node;
+    unsigned long long state = g->seed;
+    char *has_ion = (char *)calloc(end * NRN_GENERATOR_NMECH, 1);
+
+    for (i=0; i<NRN_GENERATOR_NMECH; i++) {
+        const struct gen_mechanism *m = &gen_mechanisms[i];
+        double d = g->density[i];
+        if (m->kind == GEN_ION)
+            continue;
+        for (node=0; node<end; node++) {
+            int n = (int)d + (gen_uniform(&state) < d - (int)d);
+            for (k=0; k<n; k++)
+                gen_push(&nodes[i], node);
+            if (n && m->ion >= 0)
+                has_ion[m->ion*end + node] = 1;
+        }
+    }
+
+    for (i=0; i<NRN_GENERATOR_NMECH; i++)
+        if (gen_mechanisms[i].kind == GEN_ION)
+            for (node=0; node<end; node++)
+                if (has_ion[i*end + node])
+                    gen_push(&nodes[i], node);
+    free(has_ion);
+}
+
+int nrnthread_generate(const struct nrn_generator *g, NrnThread *nt) {
+    int i, j, k, c, ne, end;
+    long offset, file_offset;
+    unsigned long long state = g->seed ^ 0x5bd1e995ULL;
+    struct gen_nodes nodes[NRN_GENERATOR_NMECH];
+    int *instance = NULL;
+    NrnThread tmp;
+
+    if (g->ncell < 1 || g->ncompartment < 2 || g->section < 1 || g->branching < 1)
+        return MAPP_BAD_ARG;
+    if ((double)g->ncell * g->ncompartment > INT_MAX / 8)
+        return MAPP_BAD_ARG;
+    for (i=0; i<NRN_GENERATOR_NMECH; i++)
+        if (g->density[i] < 0. || (gen_mechanisms[i].kind == GEN_CHANNEL && g->density[i] > 1.))
+            return MAPP_BAD_ARG;
+
+    memset(&tmp, 0, sizeof(tmp));
+    memset(nodes, 0, sizeof(nodes));
+    end = g->ncell * g->ncompartment;
+    ne = nrn_soa_padded_size(end, 0);
+    gen_place(g, end, nodes);
+
+    /* the sizes, then the layout of nrnthread_read() */
+    tmp.end = end;
+    tmp.end_pad = ne;
+    tmp.ncell = g->ncell;
+    tmp.dt = 0.025;
+    tmp.nmech = NRN_GENERATOR_NMECH;
+    tmp.ml = (Mechanism *)ecalloc_align(tmp.nmech, NRN_SOA_BYTE_ALIGN, sizeof(Mechanism));
+    offset = 6*ne;
+    file_offset = 6*end;
+    for (i=0; i<tmp.nmech; i++) {
+        Mechanism *ml = &tmp.ml[i];
+        ml->type = gen_mechanisms[i].type;
+        ml->is_art = gen_mechanisms[i].kind == GEN_ARTIFICIAL;
+        ml->nodecount = nodes[i].n;
+        ml->nodecount_pad = nrn_soa_padded_size(ml->nodecount, 0);
+        ml->szp = gen_mechanisms[i].szp;
+        ml->szdp = gen_mechanisms[i].szdp;
+        ml->offset = file_offset;
+        file_offset += (long)ml->nodecount * ml->szp;
+        offset += (long)ml->nodecount_pad * ml->szp;
+        if (tmp.max_nodecount < ml->nodecount_pad)
+            tmp.max_nodecount = ml->nodecount_pad;
+    }
+    if (offset > INT_MAX - NRN_SOA_PAD) { /* _ndata is an int */
+        efree_align(tmp.ml);
+        for (i=0; i<NRN_GENERATOR_NMECH; i++)
+            free(nodes[i].node);
+        return MAPP_BAD_ARG;
+    }
+    tmp._ndata = nrn_soa_padded_size(offset, 0);
+    tmp._data = (double *)ecalloc_align(tmp._ndata, NRN_SOA_BYTE_ALIGN, sizeof(double));
+    tmp._actual_rhs = tmp._data + 0*ne;
+    tmp._actual_d = tmp._data + 1*ne;
+    tmp._actual_a = tmp._data + 2*ne;
+    tmp._actual_b = tmp._data + 3*ne;
+    tmp._actual_v = tmp._data + 4*ne;
+    tmp._actual_area = tmp._data + 5*ne;
+
+    /* the trees and the matrix, diagonally dominant */
+    tmp._v_parent_index = (int *)ecalloc_align(ne, NRN_SOA_BYTE_ALIGN, sizeof(int));
+    for (c=0; c<g->ncell; c++)
+        for (j=1; j<g->ncompartment; j++)
+            tmp._v_parent_index[gen_node(g, c, j)] = gen_node(g, c, gen_parent(g, j));
+    for (i=0; i<end; i++) {
+        double coupling = i < g->ncell ? 0. : -(0.01 + 0.1*gen_uniform(&state));
+        tmp._actual_a[i] = coupling;
+        tmp._actual_b[i] = coupling;
+        tmp._actual_d[i] = 1. + 0.5*gen_uniform(&state);
+        tmp._actual_v[i] = -65.;
+        tmp._actual_area[i] = 20. + 60.*gen_uniform(&state);
+    }
+
+    /* the mechanisms, fields and pdata of an instance are nodecount apart as
+       the kernels index them */
+    offset = 6*ne;
+    for (i=0; i<tmp.nmech; i++) {
+        Mechanism *ml = &tmp.ml[i];
+        const struct gen_mechanism *m = &gen_mechanisms[i];
+        int n = ml->nodecount;
+        ml->data = tmp._data + offset;
+        offset += (long)ml->nodecount_pad * ml->szp;
+        if (m->init)
+            for (k=0; k<ml->szp; k++)
+                for (j=0; j<n; j++)
+                    ml->data[k*n + j] = m->init[k];
+
+        if (!ml->is_art) {
+            ml->nodeindices = (int *)ecalloc_align(ml->nodecount_pad, NRN_SOA_BYTE_ALIGN, sizeof(int));
+            if (n)
+                memcpy(ml->nodeindices, nodes[i].node, sizeof(int) * n);
+        }
+        if (!ml->szdp)
+            continue;
+        ml->pdata = (int *)ecalloc_align(ml->nodecount_pad*ml->szdp, NRN_SOA_BYTE_ALIGN, sizeof(int));
+        for (j=0; j<n; j++) {
+            int node = nodes[i].node[j];
+            for (k=0; k<ml->szdp; k++) {
+                int *pd = &ml->pdata[k*n + j];
+                if (m->kind == GEN_POINT)
+                    *pd = k == 0 ? 5*ne + node : j;
+                else if (m->kind == GEN_ARTIFICIAL)
+                    *pd = j;
+                else if (m->kind == GEN_CHANNEL && m->ion >= 0)
+                    *pd = -1; /* set below, once the ions are laid out */
+                else
+                    *pd = 0;
+            }
+        }
+    }
+
+    /* the pdata of the channels point to the ion of their compartment */
+    instance = (int *)malloc(sizeof(int) * end);
+    for (i=0; i<tmp.nmech; i++) {
+        const Mechanism *ion = &tmp.ml[i];
+        long ion_offset = ion->data - tmp._data;
+        if (gen_mechanisms[i].kind != GEN_ION)
+            continue;
+        for (j=0; j<ion->nodecount; j++)
+            instance[ion->nodeindices[j]] = j;
+        for (k=0; k<tmp.nmech; k++) {
+            Mechanism *ml = &tmp.ml[k];
+            int s, n = ml->nodecount;
+            if (gen_mechanisms[k].kind != GEN_CHANNEL || gen_mechanisms[k].ion != i)
+                continue;
+            for (s=0; s<ml->szdp; s++)
+                for (j=0; j<n; j++)
+                    ml->pdata[s*n + j] = ion_offset + gen_ion_fields[s]*ion->nodecount
+                                         + instance[ml->nodeindices[j]];
+        }
+    }
+    free(instance);
+
+    for (i=0; i<NRN_GENERATOR_NMECH; i++)
+        free(nodes[i].node);
+
+    tmp._shadow_rhs = (double *)ecalloc_align(nrn_soa_padded_size(tmp.max_nodecount, 0), NRN_SOA_BYTE_ALIGN, sizeof(double));
+    tmp._shadow_d = (double *)ecalloc_align(nrn_soa_padded_size(tmp.max_nodecount, 0), NRN_SOA_BYTE_ALIGN, sizeof(double));
+
+    return nrnthread_assemble(&tmp, nt);
+}
@@ -0,0 +1,107 @@
+/*
+ * Neuromapp - generator.h, Copyright (c), 2015,
+ * Timothee Ewart - Swiss Federal Institute of technology in Lausanne,
+ * Pramod Kumbhar - Swiss Federal Institute of technology in Lausanne,
+ * timothee.ewart@epfl.ch,
+ * paramod.kumbhar@epfl.ch
+ * All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+
+/**
+ * @file neuromapp/coreneuron_1.0/common/memory/generator.h
+ * \brief Construction of synthetic NrnThread data sets of any size
+ */
+
+#ifndef MAPP_NRNTHREAD_GENERATOR_
+#define MAPP_NRNTHREAD_GENERATOR_
+
+#include "coreneuron_1.0/common/memory/nrnthread.h"
+
+#ifdef __cplusplus
+     extern "C" {
+#endif
+
+/** number of mechanisms of a generated data set, the mechanisms of the
+    bundled bench.101392 in the same order: the kernels find Na, Ih and
+    ProbAMPANMDA at the same index of ml */
+#define NRN_GENERATOR_NMECH 24
+
+/** \enum nrn_pdata
+ *  \brief what a pdata of a mechanism holds
+ */
+enum nrn_pdata {
+    /** an index in _data: the area of the compartment, a field of an ion */
+    NRN_PDATA_DATA,
+    /** the index of the instance, e.g. its point process */
+    NRN_PDATA_INSTANCE,
+    /** a value, e.g. the style of an ion */
+    NRN_PDATA_VALUE
+};
+
+/** \struct nrn_generator
+ *  \brief the shape of a generated data set
+ */
+struct nrn_generator {
+    /** number of cells */
+    int ncell;
+    /** compartments per cell, the root included */
+    int ncompartment;
+    /** compartments per section, an unbranched cable */
+    int section;
+    /** child sections at the end of every section */
+    int branching;
+    /** instances per compartment of every mechanism: between 0 and 1 for the
+        channels, any for the point processes and the artificial cells, the
+        ions are placed where their channels are */
+    double density[NRN_GENERATOR_NMECH];
+    /** seed of the placement of the mechanisms */
+    unsigned int seed;
+};
+
+/** \fn void nrn_generator_default(struct nrn_generator *g)
+    \brief the shape and the densities of bench.101392, 17 cells of 473 compartments
+ */
+void nrn_generator_default(struct nrn_generator *g);
+
+/** \fn int nrn_generator_density(struct nrn_generator *g, const char *spec)
+    \brief sets the densities of a list of mechanisms
+    \param spec name=density[,name=density...], the name or the type of the
+    mechanism, e.g. Na=0.5,Ih=1,134=4
+    \return 0 on success, -1 if a mechanism is unknown, an ion, or its density is not valid
+ */
+int nrn_generator_density(struct nrn_generator *g, const char *spec);
+
+/** \fn enum nrn_pdata nrn_pdata_semantics(int type, int slot)
+    \brief what the pdata slot of the mechanism type holds, as the generated
+    data sets fill them; the unknown types are indices in _data
+ */
+enum nrn_pdata nrn_pdata_semantics(int type, int slot);
+
+/** \fn int nrnthread_generate(const struct nrn_generator *g, NrnThread *nt)
+    \brief builds a data set laid out as nrnthread_read() does: the trees of
+    _v_parent_index, the nodeindices sorted, the pdata of the channels
+    pointing to the ions of their compartment and the padding
+    \return non-zero if the shape is not valid
+
+    The result should be destroyed with the nrnthread_dealloc() function.
+ */
+int nrnthread_generate(const struct nrn_generator *g, NrnThread *nt);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
@@ -30,6 +30,12 @@
 #include <assert.h>
 #include <stdint.h>
 
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
 #include "coreneuron_1.0/common/memory/memory.h"
 
 /** Independent function to compute the needed chunkding,
@@ -53,13 +59,120 @@ inline int is_aligned(void* pointer, size_t alignment) {
     return (((uintptr_t)(const void *)(pointer)) % (alignment) == 0);
 }
 
+/** \struct nrn_alloc_header
+    \brief stored just before the memory returned to the user, to free it
+ */
+struct nrn_alloc_header {
+    /** start of the allocation, posix_memalign or mmap */
+    void *base;
+    /** length of the mapping, 0 for posix_memalign */
+    size_t length;
+};
+
+static enum nrn_alloc_policy alloc_policy = NRN_ALLOC_DEFAULT;
+
+static const char *alloc_policy_names[] = {"default", "hugepage", "firsttouch", "interleave"};
+
+void nrn_set_alloc_policy(enum nrn_alloc_policy policy) {
+    alloc_policy = policy;
+}
+
+enum nrn_alloc_policy nrn_get_alloc_policy() {
+    return alloc_policy;
+}
+
+int nrn_alloc_policy_from_string(const char *name, enum nrn_alloc_policy *policy) {
+    int i;
+    for (i = 0; i < 4; ++i) {
+        if (strcmp(name, alloc_policy_names[i]) == 0) {
+            *policy = (enum nrn_alloc_policy)i;
+            return 0;
+        }
+    }
+    return 1;
+}
+
+const char *nrn_alloc_policy_name(enum nrn_alloc_policy policy) {
+    return alloc_policy_names[policy];
+}
+
+/** Room for the header in front of the user memory, keeping the alignment. */
+static size_t header_room(size_t alignment) {
+    size_t room = alignment;
+    while (room < sizeof(struct nrn_alloc_header))
+        room += alignment;
+    return room;
+}
+
+#ifdef __linux__
+/** Anonymous mapping of length bytes placed following the policy, NULL if it fails. */
+static void *map_policy(size_t length, enum nrn_alloc_policy policy) {
+    void *base = MAP_FAILED;
+    if (policy == NRN_ALLOC_HUGEPAGE) {
+#ifdef MAP_HUGETLB
+        base = mmap(NULL, length, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+        if (base == MAP_FAILED) {
+            base = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+#ifdef MADV_HUGEPAGE
+            if (base != MAP_FAILED)
+                madvise(base, length, MADV_HUGEPAGE);
+#endif
+        }
+    } else {
+        base = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+#ifdef SYS_mbind
+        if (base != MAP_FAILED && policy == NRN_ALLOC_INTERLEAVE) {
+            /* MPOL_INTERLEAVE over every node, ignored without NUMA support */
+            unsigned long nodemask = ~0UL;
+            syscall(SYS_mbind, base, length, 3 /* MPOL_INTERLEAVE */, &nodemask,
+                    8 * sizeof(nodemask), 0);
+        }
+#endif
+    }
+    return base == MAP_FAILED ? NULL : base;
+}
+#endif
+
+/** Aligned allocation with its header, zeroed if zero is non-zero. */
+static void *alloc_policy_align(size_t size, size_t alignment, int zero) {
+    struct nrn_alloc_header h;
+    size_t room = header_room(alignment);
+    char *p;
+#ifdef __linux__
+    /* the small arrays are not worth a mapping: at least half a huge page
+       of 2 MB, or 16 pages of 4 KB */
+    const size_t page = alloc_policy == NRN_ALLOC_HUGEPAGE ? 2*1024*1024 : 4096;
+    const size_t threshold = alloc_policy == NRN_ALLOC_HUGEPAGE ? page/2 : 16*page;
+    if (alloc_policy != NRN_ALLOC_DEFAULT && room + size >= threshold) {
+        /* the page alignment covers the alignments of the library */
+        h.length = ((room + size + page - 1) / page) * page;
+        h.base = map_policy(h.length, alloc_policy);
+        if (h.base) {
+            /* the pages of the mapping are zero and untouched */
+            p = (char *)h.base + room;
+            memcpy(p - sizeof(h), &h, sizeof(h));
+            return p;
+        }
+    }
+#endif
+    h.length = 0;
+    int b1 = posix_memalign(&h.base, alignment, room + size);
+    /* Debug mode only */
+    assert(b1 == 0);
+    p = (char *)h.base + room;
+    memcpy(p - sizeof(h), &h, sizeof(h));
+    if (zero)
+        memset(p, 0, size);
+    return p;
+}
+
 /** Allocate the aligned memory. */
 inline void* emalloc_align(size_t size, size_t alignment) {
-    void* memptr;
-    int b1 = posix_memalign(&memptr, alignment, size);
+    void* memptr = alloc_policy_align(size, alignment, 0);
     int b2 = is_aligned(memptr, alignment);
     /* Debug mode only */
-    assert(b1 == 0);
     assert(b2 == 1);
     return memptr;
 }
@@ -68,11 +181,23 @@ inline void* emalloc_align(size_t size, size_t alignment) {
 inline void* ecalloc_align(size_t n, size_t alignment, size_t size) {
     void* p;
     if (n == 0) { return (void*)0; }
-    int b1 = posix_memalign( &p, alignment, n*size);
+    p = alloc_policy_align(n*size, alignment, 1);
     int b2 = is_aligned(p, alignment);
     /* Debug mode only */
-    assert(b1 == 0);
     assert(b2 == 1);
-    memset(p, 0, n*size);
     return p;
 }
+
+/** Free the memory of emalloc_align or ecalloc_align. */
+void efree_align(void *p) {
+    struct nrn_alloc_header h;
+    if (!p) return;
+    memcpy(&h, (char *)p - sizeof(h), sizeof(h));
+#ifdef __linux__
+    if (h.length) {
+        munmap(h.base, h.length);
+        return;
+    }
+#endif
+    free(h.base);
+}
@@ -25,9 +25,18 @@
  * \brief declaration function alignement/padding helper functions
  */
 
+#ifndef MAPP_MEMORY_H
+#define MAPP_MEMORY_H
+
+#include <stddef.h>
+
 #define NRN_SOA_PAD 4 // here one AVX
 #define NRN_SOA_BYTE_ALIGN 32
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 /** Independent function to compute the needed chunkding,
     the chunk argument is the number of doubles the chunk is chunkded upon.
 */
@@ -38,8 +47,47 @@ int nrn_soa_padded_size(int cnt, int layout);
 /** Check for the pointer alignment.*/
 int is_aligned(void* pointer, size_t alignment);
     
-/** Allocate the aligned memory. */
+/** \enum nrn_alloc_policy
+    \brief placement of the memory of emalloc_align and ecalloc_align
+ */
+enum nrn_alloc_policy {
+    /** posix_memalign, zeroed by the allocating thread */
+    NRN_ALLOC_DEFAULT,
+    /** mapping in huge pages: explicit (MAP_HUGETLB) if the system has some,
+        else transparent (madvise MADV_HUGEPAGE) */
+    NRN_ALLOC_HUGEPAGE,
+    /** mapping zeroed by the kernel: every page lands on the NUMA node of the
+        thread that writes it first. The data loaded are placed by the loading
+        thread, the kernel and the solver compute on a copy made by the
+        computing thread, and kernel --clone makes one per OMP thread */
+    NRN_ALLOC_FIRSTTOUCH,
+    /** mapping with the pages interleaved round-robin over the NUMA nodes */
+    NRN_ALLOC_INTERLEAVE
+};
+
+/** Set the policy of the following allocations, for all the threads. */
+void nrn_set_alloc_policy(enum nrn_alloc_policy policy);
+
+/** The current allocation policy. */
+enum nrn_alloc_policy nrn_get_alloc_policy();
+
+/** Parse default, hugepage, firsttouch or interleave, return non-zero if unknown. */
+int nrn_alloc_policy_from_string(const char *name, enum nrn_alloc_policy *policy);
+
+/** Name of the policy. */
+const char *nrn_alloc_policy_name(enum nrn_alloc_policy policy);
+
+/** Allocate the aligned memory following the allocation policy. */
 void* emalloc_align(size_t size, size_t alignment);
     
-/** Allocate the aligned memory and set it to 1.*/
-void* ecalloc_align(size_t n, size_t alignment, size_t size);
\ No newline at end of file
+/** Allocate the aligned memory following the allocation policy and set it to 0.*/
+void* ecalloc_align(size_t n, size_t alignment, size_t size);
+
+/** Free the memory of emalloc_align or ecalloc_align, whatever its policy. */
+void efree_align(void *p);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
\ No newline at end of file
@@ -36,58 +36,53 @@
 #include "coreneuron_1.0/common/memory/memory.h"
 #include "utils/error.h"
 
-int nrnthread_dealloc(NrnThread *nt) {
-    int i;
-
-    free(nt->_shadow_d);
-    nt->_shadow_d = NULL;
-
-    free(nt->_shadow_rhs);
-    nt->_shadow_rhs = NULL;
-
-    free(nt->_v_parent_index);
-    nt->_v_parent_index = NULL;
-
-    for (i=nt->nmech-1; i>=0; --i) {
-        Mechanism *ml = &nt->ml[i];
-        free(ml->pdata);
-        ml->pdata = NULL;
-
-        free(ml->nodeindices);
-        ml->nodeindices = NULL;
-    }
-
-    free(nt->ml);
-    nt->ml = NULL;
-
-    free(nt->_data);
-    nt->_data = NULL;
-
-    return MAPP_OK;
+/** \brief Round up to the alignment of the sections of the arena. */
+static size_t arena_align(size_t bytes) {
+    return (bytes + NRN_SOA_BYTE_ALIGN - 1) / NRN_SOA_BYTE_ALIGN * NRN_SOA_BYTE_ALIGN;
 }
 
-static void *memcpy_align(void *s, size_t align, size_t size) {
-    void *d;
-    int b1 = posix_memalign(&d, align, size);
-    assert(b1 == 0);
-    memcpy(d, s, size);
-    return d;
+/** \brief Bytes of the sections the computation writes: reference count,
+ *  ml, _data and the shadow vectors. */
+static size_t arena_mutable_size(const NrnThread *nt) {
+    size_t shadow = arena_align(sizeof(double) * nrn_soa_padded_size(nt->max_nodecount, 0));
+    return arena_align(sizeof(int)) + arena_align(sizeof(Mechanism) * nt->nmech)
+           + arena_align(sizeof(double) * nt->_ndata) + 2 * shadow;
 }
 
-int nrnthread_copy(const NrnThread *p, NrnThread *nt){
+/** \brief Bytes of the read-only sections: _v_parent_index, nodeindices and pdata. */
+static size_t arena_index_size(const NrnThread *nt) {
     int i;
-    long int offset;
-    int ne;
-
-    nt->dt = p->dt;
-    nt->_ndata = p->_ndata;
-
-    nt->_data = memcpy_align(p->_data, 64, sizeof(double) * nt->_ndata);
-
-    nt->end = p->end;
-    nt->end_pad = p->end_pad;
+    size_t size = arena_align(sizeof(int) * nt->end_pad);
+    for (i=0; i<nt->nmech; i++) {
+        const Mechanism *ml = &nt->ml[i];
+        if (!ml->is_art)
+            size += arena_align(sizeof(int) * ml->nodecount_pad);
+        if (ml->szdp)
+            size += arena_align(sizeof(int) * ml->nodecount_pad * ml->szdp);
+    }
+    return size;
+}
 
-    ne = nt->end_pad;
+/** \brief Points nt to the sections of its arena, following the sizes of
+ *  nt->ml which must already be at the start of the arena.
+ *  \param from_data the _data the ml[i].data point into, relocated to nt->_data
+ *  \param with_index if non-zero the arena has the index sections, else
+ *  nodeindices, pdata and _v_parent_index are left as they are
+ */
+static void arena_assign(NrnThread *nt, const double *from_data, int with_index) {
+    int i, ne = nt->end_pad;
+    size_t shadow = arena_align(sizeof(double) * nrn_soa_padded_size(nt->max_nodecount, 0));
+    char *cur = (char *)nt->_arena;
+
+    nt->_shared_count = (int *)cur;
+    cur += arena_align(sizeof(int));
+    cur += arena_align(sizeof(Mechanism) * nt->nmech); /* ml */
+    nt->_data = (double *)cur;
+    cur += arena_align(sizeof(double) * nt->_ndata);
+    nt->_shadow_rhs = (double *)cur;
+    cur += shadow;
+    nt->_shadow_d = (double *)cur;
+    cur += shadow;
 
     nt->_actual_rhs = nt->_data + 0*ne;
     nt->_actual_d = nt->_data + 1*ne;
@@ -96,49 +91,117 @@ int nrnthread_copy(const NrnThread *p, NrnThread *nt){
     nt->_actual_v = nt->_data + 4*ne;
     nt->_actual_area = nt->_data + 5*ne;
 
-    offset = 6*ne;
-    nt->nmech = p->nmech;
+    for (i=0; i<nt->nmech; i++)
+        nt->ml[i].data = nt->_data + (nt->ml[i].data - from_data);
 
-    nt->ml = (Mechanism *)ecalloc_align(nt->nmech, NRN_SOA_BYTE_ALIGN, sizeof(Mechanism));
-    nt->max_nodecount = 0;
+    if (!with_index)
+        return;
 
+    nt->_v_parent_index = (int *)cur;
+    cur += arena_align(sizeof(int) * ne);
     for (i=0; i<nt->nmech; i++) {
         Mechanism *ml = &nt->ml[i];
-        Mechanism const *pml = &p->ml[i];
-
-        ml->type = pml->type;
-        ml->is_art = pml->is_art;
-        ml->nodecount = pml->nodecount;
-        ml->nodecount_pad = pml->nodecount_pad;
-        ml->szp = pml->szp;
-        ml->szdp = pml->szdp;
-        ml->offset = pml->offset;
-        ml->data = nt->_data + offset;
-        offset += ml->nodecount * ml->szp;
+        if (!ml->is_art) {
+            ml->nodeindices = (int *)cur;
+            cur += arena_align(sizeof(int) * ml->nodecount_pad);
+        }
+        if (ml->szdp) {
+            ml->pdata = (int *)cur;
+            cur += arena_align(sizeof(int) * ml->nodecount_pad * ml->szdp);
+        }
+    }
+}
 
-        if ( nt->max_nodecount < ml->nodecount_pad)
-            nt->max_nodecount = ml->nodecount_pad;
+int nrnthread_dealloc(NrnThread *nt) {
+    /* the last owner of the index sections frees their arena */
+    int last = __sync_sub_and_fetch(nt->_shared_count, 1) == 0;
 
-        if (!ml->is_art)
-            ml->nodeindices = memcpy_align(pml->nodeindices, NRN_SOA_BYTE_ALIGN, sizeof(int) *
-                                            ml->nodecount_pad);
+    if (nt->_arena != nt->_index_arena)
+        efree_align(nt->_arena);
+    if (last)
+        efree_align(nt->_index_arena);
 
-        if (ml->szdp)
-            ml->pdata = memcpy_align(pml->pdata, NRN_SOA_BYTE_ALIGN, sizeof(int)
-                                     * ml->nodecount_pad*ml->szdp);
+    nt->_arena = NULL;
+    nt->_index_arena = NULL;
+    nt->_shared_count = NULL;
+    nt->ml = NULL;
+    nt->_data = NULL;
+    nt->_shadow_rhs = NULL;
+    nt->_shadow_d = NULL;
+    nt->_v_parent_index = NULL;
+
+    return MAPP_OK;
+}
 
+/** \brief Packs p in the arena of nt, the index sections are shared if
+ *  share is non-zero */
+static int nrnthread_pack(const NrnThread *p, NrnThread *nt, int share){
+    int i;
+    size_t mutable_size = arena_mutable_size(p);
+    size_t index_size = share ? 0 : arena_index_size(p);
+
+    *nt = *p; /* the sizes, the pointers are set below */
+    nt->_arena_size = mutable_size + index_size;
+    nt->_arena = emalloc_align(nt->_arena_size, NRN_SOA_BYTE_ALIGN);
+    nt->ml = (Mechanism *)((char *)nt->_arena + arena_align(sizeof(int)));
+
+    if (!share && p->_arena && p->_arena == p->_index_arena) {
+        /* same layout: one bulk copy, then the pointers are relocated */
+        memcpy(nt->_arena, p->_arena, nt->_arena_size);
+        arena_assign(nt, p->_data, 1);
+    } else {
+        memcpy(nt->ml, p->ml, sizeof(Mechanism) * p->nmech);
+        arena_assign(nt, p->_data, !share);
+        memcpy(nt->_data, p->_data, sizeof(double) * p->_ndata);
+        if (!share) {
+            memcpy(nt->_v_parent_index, p->_v_parent_index, sizeof(int) * p->end_pad);
+            for (i=0; i<nt->nmech; i++) {
+                Mechanism *ml = &nt->ml[i];
+                if (!ml->is_art)
+                    memcpy(ml->nodeindices, p->ml[i].nodeindices, sizeof(int) * ml->nodecount_pad);
+                if (ml->szdp)
+                    memcpy(ml->pdata, p->ml[i].pdata, sizeof(int) * ml->nodecount_pad * ml->szdp);
+            }
+        }
     }
 
-    /* parent indexes for linear algebra */
-    nt->_v_parent_index=memcpy_align(p->_v_parent_index, NRN_SOA_BYTE_ALIGN, sizeof(int) * ne);
+    /* scratch of the computation, zero as after nrnthread_read() */
+    memset(nt->_shadow_rhs, 0, sizeof(double) * nrn_soa_padded_size(nt->max_nodecount, 0));
+    memset(nt->_shadow_d, 0, sizeof(double) * nrn_soa_padded_size(nt->max_nodecount, 0));
+
+    if (share) {
+        nt->_shared_count = p->_shared_count;
+        nt->_index_arena = p->_index_arena;
+        __sync_add_and_fetch(nt->_shared_count, 1);
+    } else {
+        nt->_index_arena = nt->_arena;
+        *nt->_shared_count = 1;
+    }
 
-    /* no of cells in the dataset */
-    nt->ncell = p->ncell;
+    return MAPP_OK;
+}
 
-    nt->_shadow_rhs = (double*)ecalloc_align(nrn_soa_padded_size(nt->max_nodecount,0),NRN_SOA_BYTE_ALIGN, sizeof(double));
-    nt->_shadow_d = (double*)ecalloc_align(nrn_soa_padded_size(nt->max_nodecount,0),NRN_SOA_BYTE_ALIGN, sizeof(double));
+/** \brief Implements nrnthread_copy() and nrnthread_share() */
+static int nrnthread_clone(const NrnThread *p, NrnThread *nt, int share){
+    int i;
+    long int offset = 6*p->end_pad;
+    int r = nrnthread_pack(p, nt, share);
 
-    return MAPP_OK;
+    /* the mechanism data of a clone follow each other without the padding,
+       the reference solutions of the kernels are computed on this layout */
+    for (i=0; i<nt->nmech; i++) {
+        nt->ml[i].data = nt->_data + offset;
+        offset += nt->ml[i].nodecount * nt->ml[i].szp;
+    }
+    return r;
+}
+
+int nrnthread_copy(const NrnThread *p, NrnThread *nt){
+    return nrnthread_clone(p, nt, 0);
+}
+
+int nrnthread_share(const NrnThread *p, NrnThread *nt){
+    return nrnthread_clone(p, nt, 1);
 }
 
 /** /brief Scan and discard up to and including next newline. */
@@ -149,29 +212,33 @@ static void skip_line(FILE *hFile) {
     } while (c!=EOF && c!='\n');
 }
 
-/** /brief Read NrnThread double vector */
-static void read_nrnthread_darray(FILE *hFile, double *data, int n) {
+/** /brief Read NrnThread double vector, MAPP_BAD_DATA if the file is short */
+static int read_nrnthread_darray(FILE *hFile, double *data, int n) {
     int i;
     for(i=0; i<n; i++) {
-        fscanf(hFile, "%lf\n", &data[i]);
+        if (fscanf(hFile, "%lf\n", &data[i]) != 1)
+            return MAPP_BAD_DATA;
     }
     skip_line(hFile);
+    return MAPP_OK;
 }
 
-/** /brief Read NrnThread int vector */
-static void read_nrnthread_iarray(FILE *hFile, int *data, int n) {
+/** /brief Read NrnThread int vector, MAPP_BAD_DATA if the file is short */
+static int read_nrnthread_iarray(FILE *hFile, int *data, int n) {
     int i;
     for(i=0; i<n; i++) {
-        fscanf(hFile, "%d\n", &data[i]);
+        if (fscanf(hFile, "%d\n", &data[i]) != 1)
+            return MAPP_BAD_DATA;
     }
     skip_line(hFile);
+    return MAPP_OK;
 }
 
-/** /brief Write NrnThread double vector */
+/** /brief Write NrnThread double vector, with the digits to read it back exactly */
 static void write_nrnthread_darray(FILE *hFile, const double *data, int n) {
     int i;
     for(i=0; i<n; i++) {
-        fprintf(hFile, "%lf\n", data[i]);
+        fprintf(hFile, "%.17g\n", data[i]);
     }
     fputs("---\n",hFile);
 }
@@ -185,25 +252,69 @@ static void write_nrnthread_iarray(FILE *hFile, const int *data, int n) {
     fputs("---\n",hFile);
 }
 
-int nrnthread_read(FILE *hFile, NrnThread *nt) {
+static int read_separate(FILE *hFile, NrnThread *nt);
+
+/** \brief Frees the separate arrays of read_separate(). */
+static void dealloc_separate(NrnThread *nt) {
     int i;
-    long int offset;
-    int ne;
+    efree_align(nt->_shadow_d);
+    efree_align(nt->_shadow_rhs);
+    efree_align(nt->_v_parent_index);
+    for (i=nt->nmech-1; i>=0; --i) {
+        efree_align(nt->ml[i].pdata);
+        efree_align(nt->ml[i].nodeindices);
+    }
+    efree_align(nt->ml);
+    efree_align(nt->_data);
+}
+
+int nrnthread_assemble(NrnThread *p, NrnThread *nt) {
+    int r = nrnthread_pack(p, nt, 0);
+    dealloc_separate(p);
+    return r;
+}
+
+int nrnthread_read(FILE *hFile, NrnThread *nt) {
+    NrnThread tmp;
 
     if (!hFile)
         return MAPP_BAD_DATA; // the input does not exists stop;
 
+    /* the sizes of the sections are known once the file is read: the
+       arrays are read separately, then packed in the arena */
+    if (read_separate(hFile, &tmp) != MAPP_OK) {
+        dealloc_separate(&tmp);
+        return MAPP_BAD_DATA;
+    }
+    return nrnthread_assemble(&tmp, nt);
+}
+
+/** \brief Reads the NrnThread with one allocation per array, MAPP_BAD_DATA
+ *  if the file is short or its sizes do not fit in _data. The arrays read
+ *  so far are left in nt for dealloc_separate().
+ */
+static int read_separate(FILE *hFile, NrnThread *nt) {
+    int i;
+    long int offset;
+    int ne;
+
+    /* NULL arrays and no mechanism, dealloc_separate() frees what is read */
+    memset(nt, 0, sizeof(*nt));
     nt->dt = 0.025;
 
-    fscanf(hFile, "%d\n", &nt->_ndata);
+    if (fscanf(hFile, "%d\n", &nt->_ndata) != 1 || nt->_ndata < 0)
+        return MAPP_BAD_DATA;
     nt->_data =  (double*)ecalloc_align(nt->_ndata, NRN_SOA_BYTE_ALIGN, sizeof(double));
 
-    read_nrnthread_darray(hFile, nt->_data, nt->_ndata);
+    if (read_nrnthread_darray(hFile, nt->_data, nt->_ndata) != MAPP_OK)
+        return MAPP_BAD_DATA;
 
-    fscanf(hFile, "%d\n", &nt->end);
-    fscanf(hFile, "%d\n", &nt->end_pad);
+    if (fscanf(hFile, "%d\n", &nt->end) != 1 || fscanf(hFile, "%d\n", &nt->end_pad) != 1)
+        return MAPP_BAD_DATA;
 
     ne = nt->end_pad;
+    if (nt->end < 0 || ne < nt->end || 6L*ne > nt->_ndata)
+        return MAPP_BAD_DATA;
 
     nt->_actual_rhs = nt->_data + 0*ne;
     nt->_actual_d = nt->_data + 1*ne;
@@ -213,7 +324,8 @@ int nrnthread_read(FILE *hFile, NrnThread *nt) {
     nt->_actual_area = nt->_data + 5*ne;
 
     offset = 6*ne;
-    fscanf(hFile, "%d\n", &nt->nmech);
+    if (fscanf(hFile, "%d\n", &nt->nmech) != 1 || nt->nmech < 0)
+        return MAPP_BAD_DATA;
 
     nt->ml = (Mechanism *)ecalloc_align(nt->nmech, NRN_SOA_BYTE_ALIGN, sizeof(Mechanism));
 
@@ -222,8 +334,12 @@ int nrnthread_read(FILE *hFile, NrnThread *nt) {
     for (i=0; i<nt->nmech; i++) {
 
         Mechanism *ml = &nt->ml[i];
-        fscanf(hFile, "%d %d %d %d %d %d %ld\n", &(ml->type), &(ml->is_art),
-               &(ml->nodecount), &(ml->nodecount_pad), &(ml->szp), &(ml->szdp), &(ml->offset));
+        if (fscanf(hFile, "%d %d %d %d %d %d %ld\n", &(ml->type), &(ml->is_art),
+                   &(ml->nodecount), &(ml->nodecount_pad), &(ml->szp), &(ml->szdp), &(ml->offset)) != 7)
+            return MAPP_BAD_DATA;
+        if (ml->nodecount < 0 || ml->nodecount_pad < ml->nodecount || ml->szp < 0 || ml->szdp < 0 ||
+            offset + (long int)ml->nodecount_pad * ml->szp > nt->_ndata)
+            return MAPP_BAD_DATA;
         ml->data = nt->_data + offset;
         offset += ml->nodecount_pad * ml->szp;
 
@@ -234,22 +350,26 @@ int nrnthread_read(FILE *hFile, NrnThread *nt) {
 
         if (!ml->is_art){
             ml->nodeindices = (int*)ecalloc_align(ml->nodecount_pad, NRN_SOA_BYTE_ALIGN, sizeof(int));
-            read_nrnthread_iarray(hFile, ml->nodeindices, ml->nodecount_pad);
+            if (read_nrnthread_iarray(hFile, ml->nodeindices, ml->nodecount_pad) != MAPP_OK)
+                return MAPP_BAD_DATA;
         }
 
         if (ml->szdp){
             ml->pdata = (int*)ecalloc_align(ml->nodecount_pad*ml->szdp, NRN_SOA_BYTE_ALIGN, sizeof(int));
-            read_nrnthread_iarray(hFile, ml->pdata, ml->nodecount_pad*ml->szdp);
+            if (read_nrnthread_iarray(hFile, ml->pdata, ml->nodecount_pad*ml->szdp) != MAPP_OK)
+                return MAPP_BAD_DATA;
         }
 
     }
 
     /* parent indexes for linear algebra */
     nt->_v_parent_index = (int*)ecalloc_align(ne, NRN_SOA_BYTE_ALIGN, sizeof(int));;
-    read_nrnthread_iarray(hFile, nt->_v_parent_index, ne);
+    if (read_nrnthread_iarray(hFile, nt->_v_parent_index, ne) != MAPP_OK)
+        return MAPP_BAD_DATA;
 
     /* no of cells in the dataset */
-    fscanf(hFile, "%d\n", &nt->ncell);
+    if (fscanf(hFile, "%d\n", &nt->ncell) != 1)
+        return MAPP_BAD_DATA;
 
     nt->_shadow_rhs = (double*)ecalloc_align(nrn_soa_padded_size(nt->max_nodecount,0),NRN_SOA_BYTE_ALIGN, sizeof(double));
     nt->_shadow_d = (double*)ecalloc_align(nrn_soa_padded_size(nt->max_nodecount,0),NRN_SOA_BYTE_ALIGN, sizeof(double));
@@ -258,36 +378,42 @@ int nrnthread_read(FILE *hFile, NrnThread *nt) {
 }
 
 int nrnthread_write(FILE *hFile, const NrnThread *nt) {
-    int i;
+    int i, nshadow;
     long int offset;
-    int ne;
 
+    if (!hFile)
+        return MAPP_BAD_DATA;
+
+    /* _data holds the mechanisms at the padded offsets of nrnthread_read() */
     fprintf(hFile, "%d\n", nt->_ndata);
     write_nrnthread_darray(hFile, nt->_data, nt->_ndata);
 
     fprintf(hFile, "%d\n", nt->end);
-    ne = nt->end_pad;
-
-    offset = 6*ne;
+    fprintf(hFile, "%d\n", nt->end_pad);
     fprintf(hFile, "%d\n", nt->nmech);
 
+    /* the offsets of the file follow each other without the padding */
+    offset = 6*nt->end;
     for (i=0; i<nt->nmech; i++) {
-        Mechanism *ml = &nt->ml[i];
-        fprintf(hFile, "%d %d %d %d %d %ld\n", ml->type, ml->is_art, ml->nodecount, ml->szp, ml->szdp, ml->offset);
-        ml->data = nt->_data + offset;
+        const Mechanism *ml = &nt->ml[i];
+        fprintf(hFile, "%d %d %d %d %d %d %ld\n", ml->type, ml->is_art, ml->nodecount,
+                ml->nodecount_pad, ml->szp, ml->szdp, offset);
         offset += ml->nodecount * ml->szp;
 
-        if (!ml->is_art) {
-            write_nrnthread_iarray(hFile, ml->nodeindices, ml->nodecount);
-        }
+        if (!ml->is_art)
+            write_nrnthread_iarray(hFile, ml->nodeindices, ml->nodecount_pad);
 
-        if (ml->szdp) {
-            write_nrnthread_iarray(hFile, ml->pdata, ml->nodecount*ml->szdp);
-        }
+        if (ml->szdp)
+            write_nrnthread_iarray(hFile, ml->pdata, ml->nodecount_pad*ml->szdp);
     }
 
-  fclose(hFile);
-  return MAPP_OK;
-}
+    write_nrnthread_iarray(hFile, nt->_v_parent_index, nt->end_pad);
+    fprintf(hFile, "%d\n", nt->ncell);
 
+    /* the shadow vectors close the file, they are not read back */
+    nshadow = nrn_soa_padded_size(nt->max_nodecount, 0);
+    write_nrnthread_darray(hFile, nt->_shadow_rhs, nshadow);
+    write_nrnthread_darray(hFile, nt->_shadow_d, nshadow);
 
+    return ferror(hFile) ? MAPP_BAD_DATA : MAPP_OK;
+}
@@ -91,6 +91,18 @@ typedef struct NrnThread {
     Mechanism *ml;
     /** indexing of neuroni for linear algebra */
     int* _v_parent_index;
+    /** Reference count of the read-only index arrays (nodeindices, pdata,
+        _v_parent_index), shared with the clones of nrnthread_share() */
+    int* _shared_count;
+    /** Single allocation holding all the arrays above: the reference
+        count, ml, _data and the shadow vectors, then the index arrays
+        unless they are shared */
+    void* _arena;
+    /** Arena holding the index arrays, _arena or the one of the source of
+        nrnthread_share() */
+    void* _index_arena;
+    /** Size of _arena in bytes */
+    size_t _arena_size;
 } NrnThread;
 
 /** \brief Construct NrnThread from file.
@@ -103,8 +115,8 @@ typedef struct NrnThread {
  */
 int nrnthread_read(FILE *fh, NrnThread *nt);
 
-/** \brief Serialise NrnThread to file.
- *  \param fh File handle used for writing.
+/** \brief Serialise NrnThread to file, in the format of nrnthread_read().
+ *  \param fh File handle used for writing, left open.
  *  \param nt NrnThread structure to write.
  *  \return non-zero on error.
  *
@@ -112,6 +124,18 @@ int nrnthread_read(FILE *fh, NrnThread *nt);
  */
 int nrnthread_write(FILE *fh, const NrnThread *nt);
 
+/** \brief Construct NrnThread from arrays allocated one by one.
+ *  \param p The NrnThread built as nrnthread_read() lays it out, with one
+ *  ecalloc_align() per array: _data, ml, nodeindices, pdata,
+ *  _v_parent_index and the shadow vectors.
+ *  \param nt The target NrnThread.
+ *  \return non-zero on error.
+ *
+ *  The arrays of p are moved to the single allocation of nt and freed.
+ *  The result should be destroyed with the nrnthread_dealloc() function.
+ */
+int nrnthread_assemble(NrnThread *p, NrnThread *nt);
+
 /** \brief Copy NrnThread data to new NrnThread.
  *  \param p The NenThread object to copy.
  *  \param nt The target NrnThread.
@@ -123,6 +147,17 @@ int nrnthread_write(FILE *fh, const NrnThread *nt);
  */
 int nrnthread_copy(const NrnThread *p, NrnThread *nt);
 
+/** \brief Copy the mutable NrnThread data to new NrnThread, and share the
+ *  read-only index arrays (nodeindices, pdata, _v_parent_index).
+ *  \param p The NenThread object to clone.
+ *  \param nt The target NrnThread.
+ *  \return non-zero on error.
+ *
+ *  The index arrays are reference counted: they are freed by the last
+ *  nrnthread_dealloc() of p and of its clones, in any order.
+ */
+int nrnthread_share(const NrnThread *p, NrnThread *nt);
+
 /** \brief Deallocate NrnThread data constructed by nrnthread_read() or nrnthread_clone().
  *  \param nt The NenThread object to destroy.
  *  \return non-zero on error.
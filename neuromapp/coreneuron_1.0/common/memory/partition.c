@@ -0,0 +1,354 @@
+/*
+ * Neuromapp - partition.c, Copyright (c), 2015,
+ * Timothee Ewart - Swiss Federal Institute of technology in Lausanne,
+ * Pramod Kumbhar - Swiss Federal Institute of technology in Lausanne,
+ * timothee.ewart@epfl.ch,
+ * paramod.kumbhar@epfl.ch
+ * All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+
+/**
+ * @file neuromapp/coreneuron_1.0/common/memory/partition.c
+ * \brief Split of a NrnThread into independent NrnThreads, by cell
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "coreneuron_1.0/common/memory/partition.h"
+#include "coreneuron_1.0/common/memory/generator.h"
+#include "coreneuron_1.0/common/memory/memory.h"
+#include "utils/error.h"
+
+/** \struct partition_map
+ *  \brief the part and the new index of every compartment and instance
+ */
+struct partition_map {
+    /** part and index in the part of the compartments */
+    int *node_part;
+    int *node_local;
+    /** first instance of every mechanism in inst_part and inst_local */
+    int *inst_base;
+    /** part and index in the part of the mechanism instances */
+    int *inst_part;
+    int *inst_local;
+    /** cells, compartments and instances of every mechanism of every part */
+    int *ncell;
+    int *end;
+    int *nodecount;
+};
+
+/** \struct partition_cell
+ *  \brief a cell and its cost, to sort them
+ */
+struct partition_cell {
+    double cost;
+    int cell;
+};
+
+/** \brief the most expensive first, the ties by index for reproducible parts */
+static int partition_compare(const void *a, const void *b) {
+    const struct partition_cell *x = (const struct partition_cell *)a;
+    const struct partition_cell *y = (const struct partition_cell *)b;
+    if (x->cost != y->cost)
+        return x->cost < y->cost ? 1 : -1;
+    return x->cell - y->cell;
+}
+
+double nrnthread_cost(const NrnThread *nt) {
+    int i;
+    double cost = 6. * nt->end;
+    for (i=0; i<nt->nmech; i++)
+        cost += (double)nt->ml[i].nodecount * nt->ml[i].szp;
+    return cost;
+}
+
+static void partition_free(struct partition_map *map) {
+    free(map->node_part);
+    free(map->node_local);
+    free(map->inst_base);
+    free(map->inst_part);
+    free(map->inst_local);
+    free(map->ncell);
+    free(map->end);
+    free(map->nodecount);
+}
+
+/** \brief Assigns the cells to the parts and numbers the compartments and
+ *  the instances of every part: the roots first, then the other
+ *  compartments in their order, so every one stays after its parent. */
+static int partition_map(const NrnThread *nt, int n, struct partition_map *map) {
+    int i, k, m, p, ninst = 0;
+    int *cell, *count;
+    double *load;
+    struct partition_cell *order;
+
+    memset(map, 0, sizeof(*map));
+    if (n < 1 || n > nt->ncell)
+        return MAPP_BAD_ARG;
+    for (i=nt->ncell; i<nt->end; i++)
+        if (nt->_v_parent_index[i] < 0 || nt->_v_parent_index[i] >= i)
+            return MAPP_BAD_DATA;
+    for (m=0; m<nt->nmech; m++)
+        if (!nt->ml[m].is_art)
+            for (i=0; i<nt->ml[m].nodecount; i++)
+                if (nt->ml[m].nodeindices[i] < 0 || nt->ml[m].nodeindices[i] >= nt->end)
+                    return MAPP_BAD_DATA;
+
+    /* the cell of every compartment and the cost of every cell */
+    cell = (int *)malloc(sizeof(int) * nt->end);
+    order = (struct partition_cell *)malloc(sizeof(struct partition_cell) * nt->ncell);
+    for (i=0; i<nt->end; i++)
+        cell[i] = i < nt->ncell ? i : cell[nt->_v_parent_index[i]];
+    for (i=0; i<nt->ncell; i++) {
+        order[i].cost = 0.;
+        order[i].cell = i;
+    }
+    for (i=0; i<nt->end; i++)
+        order[cell[i]].cost += 6.;
+    for (m=0; m<nt->nmech; m++)
+        if (!nt->ml[m].is_art)
+            for (i=0; i<nt->ml[m].nodecount; i++)
+                order[cell[nt->ml[m].nodeindices[i]]].cost += nt->ml[m].szp;
+
+    /* greedy: the most expensive cell to the least loaded part */
+    qsort(order, nt->ncell, sizeof(struct partition_cell), partition_compare);
+    load = (double *)calloc(n, sizeof(double));
+    map->ncell = (int *)calloc(n, sizeof(int));
+    map->node_part = (int *)malloc(sizeof(int) * nt->end);
+    for (i=0; i<nt->ncell; i++) {
+        int best = 0;
+        for (p=1; p<n; p++)
+            if (load[p] < load[best])
+                best = p;
+        load[best] += order[i].cost;
+        map->node_part[order[i].cell] = best;
+        map->ncell[best]++;
+    }
+    for (i=nt->ncell; i<nt->end; i++)
+        map->node_part[i] = map->node_part[cell[i]];
+    free(load);
+    free(order);
+    free(cell);
+
+    map->end = (int *)malloc(sizeof(int) * n);
+    map->node_local = (int *)malloc(sizeof(int) * nt->end);
+    count = (int *)calloc(n, sizeof(int));
+    for (i=0; i<nt->ncell; i++)
+        map->node_local[i] = count[map->node_part[i]]++;
+    for (i=nt->ncell; i<nt->end; i++)
+        map->node_local[i] = count[map->node_part[i]]++;
+    memcpy(map->end, count, sizeof(int) * n);
+    free(count);
+
+    map->inst_base = (int *)malloc(sizeof(int) * (nt->nmech + 1));
+    for (m=0; m<nt->nmech; m++) {
+        map->inst_base[m] = ninst;
+        ninst += nt->ml[m].nodecount;
+    }
+    map->inst_base[nt->nmech] = ninst;
+    map->inst_part = (int *)malloc(sizeof(int) * (ninst + 1));
+    map->inst_local = (int *)malloc(sizeof(int) * (ninst + 1));
+    map->nodecount = (int *)calloc((size_t)n * nt->nmech, sizeof(int));
+    for (m=0; m<nt->nmech; m++) {
+        const Mechanism *ml = &nt->ml[m];
+        for (i=0; i<ml->nodecount; i++) {
+            k = map->inst_base[m] + i;
+            p = ml->is_art ? (int)((long)i * n / ml->nodecount) : map->node_part[ml->nodeindices[i]];
+            map->inst_part[k] = p;
+            map->inst_local[k] = map->nodecount[p*nt->nmech + m]++;
+        }
+    }
+    return MAPP_OK;
+}
+
+/** \brief New value of a pdata of the part p, of the instance numbered j
+ *  in the part: the same field of the same compartment or instance,
+ *  renumbered, or -1 if it belongs to another part. The fields of the
+ *  instances are decoded nodecount apart, as the kernels index them. */
+static int partition_remap(const NrnThread *nt, const struct partition_map *map, int p,
+                           const NrnThread *part, enum nrn_pdata semantics,
+                           int j, int v, long *outside) {
+    int m, ne = nt->end_pad;
+
+    if (semantics == NRN_PDATA_INSTANCE && v >= 0)
+        return j;
+    if (semantics == NRN_PDATA_VALUE || v < 0 || v >= nt->_ndata)
+        return v;
+    if (v < 6*ne) {
+        int node = v % ne;
+        if (node < nt->end && map->node_part[node] == p)
+            return (v / ne) * part->end_pad + map->node_local[node];
+    } else {
+        for (m=0; m<nt->nmech; m++) {
+            const Mechanism *ml = &nt->ml[m];
+            long off = ml->data - nt->_data;
+            if (v >= off && v < off + (long)ml->nodecount * ml->szp) {
+                int k = map->inst_base[m] + (int)((v - off) % ml->nodecount);
+                if (map->inst_part[k] == p)
+                    return (int)(part->ml[m].data - part->_data)
+                           + (int)((v - off) / ml->nodecount) * part->ml[m].nodecount
+                           + map->inst_local[k];
+                break;
+            }
+        }
+    }
+    ++*outside;
+    return -1;
+}
+
+/** \brief Builds the part p as nrnthread_read() lays it out. */
+static int partition_build(const NrnThread *nt, const struct partition_map *map, int p,
+                           NrnThread *part, long *outside) {
+    int i, j, k, m, ne, ne_src = nt->end_pad;
+    long offset, file_offset;
+    NrnThread tmp;
+
+    memset(&tmp, 0, sizeof(tmp));
+    tmp.end = map->end[p];
+    tmp.end_pad = ne = nrn_soa_padded_size(tmp.end, 0);
+    tmp.ncell = map->ncell[p];
+    tmp.dt = nt->dt;
+    tmp.nmech = nt->nmech;
+    tmp.ml = (Mechanism *)ecalloc_align(tmp.nmech, NRN_SOA_BYTE_ALIGN, sizeof(Mechanism));
+    offset = 6*ne;
+    file_offset = 6*tmp.end;
+    for (m=0; m<tmp.nmech; m++) {
+        Mechanism *ml = &tmp.ml[m];
+        ml->type = nt->ml[m].type;
+        ml->is_art = nt->ml[m].is_art;
+        ml->szp = nt->ml[m].szp;
+        ml->szdp = nt->ml[m].szdp;
+        ml->nodecount = map->nodecount[p*tmp.nmech + m];
+        ml->nodecount_pad = nrn_soa_padded_size(ml->nodecount, 0);
+        ml->offset = file_offset;
+        file_offset += (long)ml->nodecount * ml->szp;
+        offset += (long)ml->nodecount_pad * ml->szp;
+        if (tmp.max_nodecount < ml->nodecount_pad)
+            tmp.max_nodecount = ml->nodecount_pad;
+    }
+    tmp._ndata = nrn_soa_padded_size(offset, 0);
+    tmp._data = (double *)ecalloc_align(tmp._ndata, NRN_SOA_BYTE_ALIGN, sizeof(double));
+    tmp._actual_rhs = tmp._data + 0*ne;
+    tmp._actual_d = tmp._data + 1*ne;
+    tmp._actual_a = tmp._data + 2*ne;
+    tmp._actual_b = tmp._data + 3*ne;
+    tmp._actual_v = tmp._data + 4*ne;
+    tmp._actual_area = tmp._data + 5*ne;
+
+    tmp._v_parent_index = (int *)ecalloc_align(ne, NRN_SOA_BYTE_ALIGN, sizeof(int));
+    for (i=0; i<nt->end; i++) {
+        int l = map->node_local[i];
+        if (map->node_part[i] != p)
+            continue;
+        for (k=0; k<6; k++)
+            tmp._data[k*ne + l] = nt->_data[k*ne_src + i];
+        if (i >= nt->ncell)
+            tmp._v_parent_index[l] = map->node_local[nt->_v_parent_index[i]];
+    }
+
+    /* every mechanism before the pdata, they may point to any of them */
+    offset = 6*ne;
+    for (m=0; m<tmp.nmech; m++) {
+        Mechanism *ml = &tmp.ml[m];
+        ml->data = tmp._data + offset;
+        offset += (long)ml->nodecount_pad * ml->szp;
+        if (!ml->is_art)
+            ml->nodeindices = (int *)ecalloc_align(ml->nodecount_pad, NRN_SOA_BYTE_ALIGN, sizeof(int));
+        if (ml->szdp)
+            ml->pdata = (int *)ecalloc_align(ml->nodecount_pad*ml->szdp, NRN_SOA_BYTE_ALIGN, sizeof(int));
+    }
+
+    /* the fields and the pdata of an instance are nodecount apart */
+    for (m=0; m<tmp.nmech; m++) {
+        const Mechanism *src = &nt->ml[m];
+        Mechanism *ml = &tmp.ml[m];
+        for (i=0; i<src->nodecount; i++) {
+            int b = map->inst_base[m] + i;
+            if (map->inst_part[b] != p)
+                continue;
+            j = map->inst_local[b];
+            for (k=0; k<ml->szp; k++)
+                ml->data[k*ml->nodecount + j] = src->data[k*src->nodecount + i];
+            if (!ml->is_art)
+                ml->nodeindices[j] = map->node_local[src->nodeindices[i]];
+            for (k=0; k<ml->szdp; k++)
+                ml->pdata[k*ml->nodecount + j] = partition_remap(nt, map, p, &tmp,
+                                                                 nrn_pdata_semantics(ml->type, k), j,
+                                                                 src->pdata[k*src->nodecount + i], outside);
+        }
+    }
+
+    tmp._shadow_rhs = (double *)ecalloc_align(nrn_soa_padded_size(tmp.max_nodecount, 0), NRN_SOA_BYTE_ALIGN, sizeof(double));
+    tmp._shadow_d = (double *)ecalloc_align(nrn_soa_padded_size(tmp.max_nodecount, 0), NRN_SOA_BYTE_ALIGN, sizeof(double));
+
+    return nrnthread_assemble(&tmp, part);
+}
+
+int nrnthread_partition(const NrnThread *nt, int n, NrnThread *parts, long *outside) {
+    int p, error;
+    long redirected = 0;
+    struct partition_map map;
+
+    error = partition_map(nt, n, &map);
+    for (p=0; p<n && error == MAPP_OK; p++) {
+        error = partition_build(nt, &map, p, &parts[p], &redirected);
+        if (error != MAPP_OK)
+            while (p--)
+                nrnthread_dealloc(&parts[p]);
+    }
+    /* e.g. bench.101392, its fields and pdata are nodecount_pad apart */
+    if (error == MAPP_OK && redirected > 0) {
+        for (p=0; p<n; p++)
+            nrnthread_dealloc(&parts[p]);
+        error = MAPP_BAD_DATA;
+    }
+    partition_free(&map);
+    if (outside)
+        *outside = redirected;
+    return error;
+}
+
+int nrnthread_gather(const NrnThread *parts, int n, NrnThread *nt) {
+    int i, k, m, p, error;
+    struct partition_map map;
+
+    error = partition_map(nt, n, &map);
+    for (p=0; p<n && error == MAPP_OK; p++)
+        if (parts[p].end != map.end[p] || parts[p].nmech != nt->nmech)
+            error = MAPP_BAD_ARG;
+    if (error != MAPP_OK) {
+        partition_free(&map);
+        return error;
+    }
+
+    for (i=0; i<nt->end; i++) {
+        const NrnThread *part = &parts[map.node_part[i]];
+        for (k=0; k<6; k++)
+            nt->_data[k*nt->end_pad + i] = part->_data[k*part->end_pad + map.node_local[i]];
+    }
+    for (m=0; m<nt->nmech; m++) {
+        Mechanism *ml = &nt->ml[m];
+        for (i=0; i<ml->nodecount; i++) {
+            int b = map.inst_base[m] + i;
+            const Mechanism *src = &parts[map.inst_part[b]].ml[m];
+            for (k=0; k<ml->szp; k++)
+                ml->data[k*ml->nodecount + i] = src->data[k*src->nodecount + map.inst_local[b]];
+        }
+    }
+    partition_free(&map);
+    return MAPP_OK;
+}
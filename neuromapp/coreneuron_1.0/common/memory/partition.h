@@ -0,0 +1,77 @@
+/*
+ * Neuromapp - partition.h, Copyright (c), 2015,
+ * Timothee Ewart - Swiss Federal Institute of technology in Lausanne,
+ * Pramod Kumbhar - Swiss Federal Institute of technology in Lausanne,
+ * timothee.ewart@epfl.ch,
+ * paramod.kumbhar@epfl.ch
+ * All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+
+/**
+ * @file neuromapp/coreneuron_1.0/common/memory/partition.h
+ * \brief Split of a NrnThread into independent NrnThreads, by cell
+ */
+
+#ifndef MAPP_NRNTHREAD_PARTITION_
+#define MAPP_NRNTHREAD_PARTITION_
+
+#include "coreneuron_1.0/common/memory/nrnthread.h"
+
+#ifdef __cplusplus
+     extern "C" {
+#endif
+
+/** \fn double nrnthread_cost(const NrnThread *nt)
+    \brief estimated cost of a time step: the doubles of the compartments
+    (6 each) and of the mechanism instances (szp each)
+ */
+double nrnthread_cost(const NrnThread *nt);
+
+/** \fn int nrnthread_partition(const NrnThread *nt, int n, NrnThread *parts, long *outside)
+    \brief splits nt by cell into n NrnThreads balanced by nrnthread_cost()
+    \param nt the data set, every compartment after its parent
+    \param n the number of parts, between 1 and the number of cells
+    \param parts the n parts, each with its own renumbered compartments,
+    mechanism instances, pdata and _v_parent_index
+    \param outside if not NULL, the number of pdata pointing to the data of
+    another part
+    \return MAPP_BAD_ARG if n or nt is not valid, MAPP_BAD_DATA if a pdata
+    points to the data of another part
+
+    The fields and the pdata of an instance are decoded nodecount apart, as
+    the kernels index them and nrnthread_generate() lays them out. The sets
+    stored nodecount_pad apart, as bench.101392, are refused: the kernels
+    read there the pdata of another instance, maybe of another cell, and no
+    split computes the step of the whole set.
+
+    The cells go to the least loaded part, the most expensive first. The
+    artificial cells, without compartment, are dealt in contiguous blocks.
+    The parts should be destroyed with the nrnthread_dealloc() function.
+ */
+int nrnthread_partition(const NrnThread *nt, int n, NrnThread *parts, long *outside);
+
+/** \fn int nrnthread_gather(const NrnThread *parts, int n, NrnThread *nt)
+    \brief copies the compartment and mechanism data of the parts of
+    nrnthread_partition() back to nt
+    \return non-zero if n or nt is not valid
+ */
+int nrnthread_gather(const NrnThread *parts, int n, NrnThread *nt);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
@@ -0,0 +1,246 @@
+/* Neuromapp - affinity.c, Copyright (c), 2015,
+ * Timothee Ewart - Swiss Federal Institute of technology in Lausanne,
+ * Pramod Kumbhar - Swiss Federal Institute of technology in Lausanne,
+ * timothee.ewart@epfl.ch,
+ * paramod.kumbhar@epfl.ch
+ * All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+
+/**
+ * @file neuromapp/coreneuron_1.0/common/util/affinity.c
+ * \brief placement of the OpenMP threads on the cpus, with sched_setaffinity
+ */
+
+#ifdef __linux__
+#define _GNU_SOURCE
+#include <sched.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "coreneuron_1.0/common/util/affinity.h"
+
+/** \brief socket of the cpu, 0 if the topology is unknown */
+static int cpu_socket(int cpu) {
+    char path[128];
+    int socket = 0;
+    FILE *f;
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/physical_package_id", cpu);
+    f = fopen(path, "r");
+    if (f) {
+        if (fscanf(f, "%d", &socket) != 1)
+            socket = 0;
+        fclose(f);
+    }
+    return socket;
+}
+
+#ifdef __linux__
+
+/** the cpus of the process before any binding, the binding of the master
+    thread would restrict the next placements otherwise */
+static cpu_set_t nrn_bind_allowed;
+static int nrn_bind_allowed_init = 0;
+/** non-zero once threads have been bound */
+static int nrn_bind_done = 0;
+
+static const cpu_set_t *allowed_cpus() {
+    if (!nrn_bind_allowed_init) {
+        if (sched_getaffinity(0, sizeof(cpu_set_t), &nrn_bind_allowed) != 0) {
+            int i;
+            CPU_ZERO(&nrn_bind_allowed);
+            for (i = 0; i < CPU_SETSIZE; ++i)
+                CPU_SET(i, &nrn_bind_allowed);
+        }
+        nrn_bind_allowed_init = 1;
+    }
+    return &nrn_bind_allowed;
+}
+
+/** \brief parses the list "0,2,4-7" in cpus, -1 if invalid */
+static int parse_list(const char *spec, int *cpus, int size) {
+    int n = 0;
+    const char *p = spec;
+    while (*p) {
+        char *end;
+        long first, last, c;
+        if (!isdigit((unsigned char)*p))
+            return -1;
+        first = last = strtol(p, &end, 10);
+        p = end;
+        if (*p == '-') {
+            if (!isdigit((unsigned char)p[1]))
+                return -1;
+            last = strtol(p + 1, &end, 10);
+            p = end;
+        }
+        if (last < first || last >= CPU_SETSIZE)
+            return -1;
+        for (c = first; c <= last; ++c) {
+            if (!CPU_ISSET(c, allowed_cpus()))
+                return -1;
+            if (n < size)
+                cpus[n] = (int)c;
+            ++n;
+        }
+        if (*p == ',' && p[1])
+            ++p;
+        else if (*p)
+            return -1;
+    }
+    return n > size ? size : n;
+}
+
+/** \brief a cpu, its socket and its rank inside the socket */
+struct placed_cpu {
+    int cpu;
+    int socket;
+    int rank;
+};
+
+static int compare_compact(const void *a, const void *b) {
+    const struct placed_cpu *x = (const struct placed_cpu *)a, *y = (const struct placed_cpu *)b;
+    if (x->socket != y->socket)
+        return x->socket - y->socket;
+    return x->cpu - y->cpu;
+}
+
+static int compare_scatter(const void *a, const void *b) {
+    const struct placed_cpu *x = (const struct placed_cpu *)a, *y = (const struct placed_cpu *)b;
+    if (x->rank != y->rank)
+        return x->rank - y->rank;
+    return compare_compact(a, b);
+}
+
+/** \brief the allowed cpus in the order of compact or scatter */
+static int sorted_cpus(int scatter, int *cpus, int size) {
+    int i, j, n = 0;
+    struct placed_cpu *placed = (struct placed_cpu *)malloc(CPU_SETSIZE * sizeof(struct placed_cpu));
+    for (i = 0; i < CPU_SETSIZE; ++i) {
+        if (!CPU_ISSET(i, allowed_cpus()))
+            continue;
+        placed[n].cpu = i;
+        placed[n].socket = cpu_socket(i);
+        placed[n].rank = 0;
+        for (j = 0; j < n; ++j)
+            if (placed[j].socket == placed[n].socket)
+                placed[n].rank++;
+        ++n;
+    }
+    qsort(placed, n, sizeof(struct placed_cpu), scatter ? compare_scatter : compare_compact);
+    if (n > size)
+        n = size;
+    for (i = 0; i < n; ++i)
+        cpus[i] = placed[i].cpu;
+    free(placed);
+    return n;
+}
+
+int nrn_bind_order(const char *spec, int *cpus, int size) {
+    if (!spec || strcmp(spec, "none") == 0)
+        return 0;
+    if (strcmp(spec, "compact") == 0)
+        return sorted_cpus(0, cpus, size);
+    if (strcmp(spec, "scatter") == 0)
+        return sorted_cpus(1, cpus, size);
+    return parse_list(spec, cpus, size);
+}
+
+#else
+
+int nrn_bind_order(const char *spec, int *cpus, int size) {
+    if (!spec || strcmp(spec, "none") == 0)
+        return 0;
+    return -1;
+}
+
+#endif
+
+int nrn_bind_check(const char *spec) {
+    int cpu;
+    return nrn_bind_order(spec, &cpu, 1) < 0;
+}
+
+int nrn_bind_threads(const char *spec) {
+    int i, n, nthreads = 1;
+    int *cpus, *bound;
+#ifdef __linux__
+    int size = CPU_SETSIZE;
+#else
+    int size = 1;
+#endif
+
+    cpus = (int *)malloc(size * sizeof(int));
+    n = nrn_bind_order(spec, cpus, size);
+    if (n <= 0) {
+        free(cpus);
+#ifdef __linux__
+        /* the threads of a previous command of the driver get all the cpus back */
+        if (n == 0 && nrn_bind_done) {
+            #pragma omp parallel
+            sched_setaffinity(0, sizeof(cpu_set_t), allowed_cpus());
+            nrn_bind_done = 0;
+        }
+#endif
+        return n < 0;
+    }
+
+#ifdef _OPENMP
+    nthreads = omp_get_max_threads();
+#endif
+    bound = (int *)malloc(nthreads * sizeof(int));
+
+    #pragma omp parallel
+    {
+        int id = 0;
+#ifdef _OPENMP
+        id = omp_get_thread_num();
+#endif
+        bound[id] = -1;
+#ifdef __linux__
+        {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(cpus[id % n], &set);
+            if (sched_setaffinity(0, sizeof(cpu_set_t), &set) == 0)
+                bound[id] = cpus[id % n];
+        }
+#endif
+    }
+#ifdef __linux__
+    nrn_bind_done = 1;
+#endif
+
+    printf("\n Placement %s:", spec);
+    for (i = 0; i < nthreads; ++i) {
+        if (bound[i] < 0)
+            printf(" thread %d unbound", i);
+        else
+            printf(" thread %d -> cpu %d (socket %d)", i, bound[i], cpu_socket(bound[i]));
+        printf(i + 1 < nthreads ? "," : "\n");
+    }
+
+    free(bound);
+    free(cpus);
+    return 0;
+}
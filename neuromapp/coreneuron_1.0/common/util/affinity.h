@@ -0,0 +1,62 @@
+/* Neuromapp - affinity.h, Copyright (c), 2015,
+ * Timothee Ewart - Swiss Federal Institute of technology in Lausanne,
+ * Pramod Kumbhar - Swiss Federal Institute of technology in Lausanne,
+ * timothee.ewart@epfl.ch,
+ * paramod.kumbhar@epfl.ch
+ * All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+
+/**
+ * @file neuromapp/coreneuron_1.0/common/util/affinity.h
+ * \brief placement of the OpenMP threads on the cpus, with sched_setaffinity
+ */
+
+#ifndef MAPP_AFFINITY_
+#define MAPP_AFFINITY_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** \fn int nrn_bind_order(const char *spec, int *cpus, int size)
+    \brief the cpus of the placement spec, the thread i runs on cpus[i % n]
+    \param spec "none", "compact" (fill a socket first), "scatter" (round robin
+    over the sockets) or a list of cpus as "0,2,4-7"
+    \param cpus receives the cpus in placement order
+    \param size capacity of cpus
+    \return the number n of cpus, 0 for "none", -1 if spec is invalid or names
+    a cpu the process may not run on
+ */
+int nrn_bind_order(const char *spec, int *cpus, int size);
+
+/** \fn int nrn_bind_check(const char *spec)
+    \return non-zero if spec is not a valid placement
+ */
+int nrn_bind_check(const char *spec);
+
+/** \fn int nrn_bind_threads(const char *spec)
+    \brief binds the threads of the OpenMP team of omp_get_max_threads() threads,
+    reused by the next parallel regions of this size, and prints the placement.
+    "none" leaves the threads unbound, and unbinds the ones of a previous call.
+    \return non-zero if spec is invalid
+ */
+int nrn_bind_threads(const char *spec);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -29,6 +29,8 @@
  */
 
 #include "coreneuron_1.0/common/memory/nrnthread.h"
+#include "coreneuron_1.0/common/memory/memory.h"
+#include "coreneuron_1.0/common/memory/generator.h"
 #include "coreneuron_1.0/common/util/nrnthread_handler.h"
 
 void *make_nrnthread(void *filename) {
@@ -48,6 +50,15 @@ void *make_nrnthread(void *filename) {
     return (void *)nt;
 }
 
+void *generate_nrnthread(void *generator) {
+    NrnThread *nt = malloc(sizeof(NrnThread));
+    if (nrnthread_generate((const struct nrn_generator *)generator, nt)) {
+        free(nt);
+        return NULL;
+    }
+    return (void *)nt;
+}
+
 void *clone_nrnthread(void *p) {
     int r;
     if (!p) return NULL;
@@ -63,10 +74,29 @@ void *clone_nrnthread(void *p) {
     return (void *)nt;
 }
 
+void *share_nrnthread(void *p) {
+    int r;
+    if (!p) return NULL;
+
+    NrnThread *nt = malloc(sizeof(NrnThread));
+    r = nrnthread_share((NrnThread *)p, nt);
+
+    if (r) { /* error in copy */
+        free_nrnthread(nt);
+        return NULL;
+    }
+
+    return (void *)nt;
+}
+
 void free_nrnthread(void *p) {
     nrnthread_dealloc((NrnThread *)p);
     free(p);
 }
 
-
-
+size_t size_nrnthread(void *p) {
+    const NrnThread *nt = (const NrnThread *)p;
+    if (!nt) return 0;
+    /* all the arrays are in the arena, the shared index arrays are not counted */
+    return sizeof(NrnThread) + nt->_arena_size;
+}
@@ -49,6 +49,17 @@ extern "C" {
 */
 void *make_nrnthread(void *filename);
 
+/** \fn void *generate_nrnthread(void *generator)
+    \brief Allocate NrnThread object and build a synthetic data set
+    \param generator the shape, a struct nrn_generator * (as void * context variable)
+    \return Pointer to the constructed NrnThread object,
+            or NULL on error.
+
+    Allocated NrnThread objects should be freed with
+    free_nrnthread().
+*/
+void *generate_nrnthread(void *generator);
+
 /** \fn void *clone_nrnthread(void *nrn)
     \brief Allocate a new NrnThread object on the heap and initialise
            with data from the NrnThread object pointed to by nrn.
@@ -62,6 +73,19 @@ void *make_nrnthread(void *filename);
 */
 void *clone_nrnthread(void *p);
 
+/** \fn void *share_nrnthread(void *nrn)
+    \brief As clone_nrnthread(), but the read-only index arrays are shared
+           with nrn instead of copied (see nrnthread_share()).
+
+    \param p pointer to existing NrnThread object (as void * context variable)
+    \return Pointer to the allocated and constructed NrnThread object,
+            or NULL on error.
+
+    Allocated NrnThread objects should be freed with
+    free_nrnthread(), before or after nrn.
+*/
+void *share_nrnthread(void *p);
+
 
 /** \fn void free_nrnthread(void * p);
     \brief Deallocate NrnThread data and free NrnThread object itself.
@@ -69,6 +93,13 @@ void *clone_nrnthread(void *p);
 */
 void free_nrnthread(void *p);
 
+/** \fn size_t size_nrnthread(void * p);
+    \brief Memory held by a NrnThread object, for the memory budget of the storage.
+    \param p Pointer to heap-allocated NrnThread object, may be NULL.
+    \return the size in bytes of the object and of the arrays it owns, 0 for NULL.
+*/
+size_t size_nrnthread(void *p);
+
 #ifdef __cplusplus
 }
 #endif
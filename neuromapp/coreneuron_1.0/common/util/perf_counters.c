@@ -0,0 +1,98 @@
+/* Neuromapp - perf_counters.c, Copyright (c), 2015,
+ * Timothee Ewart - Swiss Federal Institute of technology in Lausanne,
+ * Pramod Kumbhar - Swiss Federal Institute of technology in Lausanne,
+ * timothee.ewart@epfl.ch,
+ * paramod.kumbhar@epfl.ch
+ * All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+
+/**
+ * @file neuromapp/coreneuron_1.0/common/util/perf_counters.c
+ * \brief hardware counters of the memory accesses, with perf_event_open
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+#include "coreneuron_1.0/common/util/perf_counters.h"
+
+static const char *perf_counters_names[PERF_COUNTERS_SIZE] = {"dTLB misses", "remote memory accesses"};
+
+#ifdef __linux__
+/** generic cache event: data TLB read misses, NUMA node read misses (remote) */
+static const unsigned long long perf_counters_events[PERF_COUNTERS_SIZE] = {
+    PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+    PERF_COUNT_HW_CACHE_NODE | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)
+};
+#endif
+
+int perf_counters_start(struct perf_counters *pc) {
+    int i, n = 0;
+    for (i = 0; i < PERF_COUNTERS_SIZE; ++i) {
+        pc->fd[i] = -1;
+        pc->value[i] = -1;
+#ifdef __linux__
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HW_CACHE;
+        attr.config = perf_counters_events[i];
+        attr.disabled = 1;
+        attr.inherit = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        pc->fd[i] = (int) syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+        if (pc->fd[i] >= 0) {
+            ioctl(pc->fd[i], PERF_EVENT_IOC_RESET, 0);
+            ioctl(pc->fd[i], PERF_EVENT_IOC_ENABLE, 0);
+            ++n;
+        }
+#endif
+    }
+    return n;
+}
+
+void perf_counters_stop(struct perf_counters *pc) {
+    int i;
+    for (i = 0; i < PERF_COUNTERS_SIZE; ++i) {
+        if (pc->fd[i] < 0)
+            continue;
+#ifdef __linux__
+        ioctl(pc->fd[i], PERF_EVENT_IOC_DISABLE, 0);
+        if (read(pc->fd[i], &pc->value[i], sizeof(long long)) != sizeof(long long))
+            pc->value[i] = -1;
+#endif
+        close(pc->fd[i]);
+        pc->fd[i] = -1;
+    }
+}
+
+void perf_counters_print(const struct perf_counters *pc) {
+    int i, first = 1;
+    for (i = 0; i < PERF_COUNTERS_SIZE; ++i) {
+        if (pc->value[i] < 0)
+            continue;
+        printf(first ? "\n %s: %lld" : ", %s: %lld", perf_counters_names[i], pc->value[i]);
+        first = 0;
+    }
+}
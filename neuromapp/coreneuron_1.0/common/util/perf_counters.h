@@ -0,0 +1,59 @@
+/* Neuromapp - perf_counters.h, Copyright (c), 2015,
+ * Timothee Ewart - Swiss Federal Institute of technology in Lausanne,
+ * Pramod Kumbhar - Swiss Federal Institute of technology in Lausanne,
+ * timothee.ewart@epfl.ch,
+ * paramod.kumbhar@epfl.ch
+ * All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+
+/**
+ * @file neuromapp/coreneuron_1.0/common/util/perf_counters.h
+ * \brief hardware counters of the memory accesses, with perf_event_open
+ */
+
+#ifndef MAPP_PERF_COUNTERS_
+#define MAPP_PERF_COUNTERS_
+
+/** number of counters: data TLB misses and remote NUMA node accesses */
+#define PERF_COUNTERS_SIZE 2
+
+/** \struct perf_counters
+    \brief the hardware counters of the calling thread and the threads it creates
+ */
+struct perf_counters {
+    /** file descriptors of the events, -1 if not available */
+    int fd[PERF_COUNTERS_SIZE];
+    /** counts between start and stop, -1 if not available */
+    long long value[PERF_COUNTERS_SIZE];
+};
+
+/** \fn int perf_counters_start(struct perf_counters *pc)
+    \brief opens and starts the counters
+    \return the number of counters available, 0 without perf_event support
+ */
+int perf_counters_start(struct perf_counters *pc);
+
+/** \fn void perf_counters_stop(struct perf_counters *pc)
+    \brief stops the counters, reads them in value and closes them
+ */
+void perf_counters_stop(struct perf_counters *pc);
+
+/** \fn void perf_counters_print(const struct perf_counters *pc)
+    \brief prints the available counters on a line, nothing if none is
+ */
+void perf_counters_print(const struct perf_counters *pc);
+
+#endif
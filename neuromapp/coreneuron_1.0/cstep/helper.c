@@ -35,14 +35,17 @@
 #include <unistd.h>
 
 #include "coreneuron_1.0/cstep/helper.h"
+#include "coreneuron_1.0/common/util/affinity.h"
 #include "utils/error.h"
 
 int cstep_print_usage() {
-    printf("Usage: cstep --data <input path> [--numthread int] [--name string]\n");
+    printf("Usage: cstep --data <input path> [--numthread int] [--name string] [--bind string] [--partition int]\n");
     printf("Details: \n");
     printf("                 --data [path to the input]\n");
     printf("                 --numthread <threadnumber>\n");
     printf("                 --name [to internally reference the data, default name coreneuron_1.0_cstep_data] \n");
+    printf("                 --bind [none, compact, scatter or a list of cpus as 0,2,4-7, placement of the threads] \n");
+    printf("                 --partition [number of independent sub-threads the cells are split into, one per OMP thread at best, default 0: not split, the pdata of a cell must stay in the cell as in the generated sets] \n");
     return MAPP_USAGE;
 }
 
@@ -52,6 +55,8 @@ int cstep_help(int argc, char * const argv[], struct input_parameters * p)
   p->d = "";
   p->th = 1; // one omp thread by default
   p->name = "coreneuron_1.0_cstep_data";
+  p->bind = "none";
+  p->partition = 0;
 
   optind = 0;
 
@@ -63,13 +68,15 @@ int cstep_help(int argc, char * const argv[], struct input_parameters * p)
           {"data",  required_argument,     0, 'd'},
           {"numthread",  required_argument,0, 't'},
           {"name",  required_argument,     0, 'n'},
+          {"bind",  required_argument,     0, 'b'},
+          {"partition",  required_argument,0, 'p'},
 
           {0, 0, 0, 0}
       };
       /* getopt_long stores the option index here. */
       int option_index = 0;
 
-      c = getopt_long (argc, argv, "d:t:n:",
+      c = getopt_long (argc, argv, "d:t:n:b:p:",
                        long_options, &option_index);
       /* Detect the end of the options. */
       if (c == -1)
@@ -88,6 +95,16 @@ int cstep_help(int argc, char * const argv[], struct input_parameters * p)
           case 'n':
               p->name = optarg;
               break;
+          case 'b':
+              if(nrn_bind_check(optarg) != 0)
+                  return MAPP_BAD_ARG;
+              p->bind = optarg;
+              break;
+          case 'p':
+              p->partition = atoi(optarg);
+              if(p->partition < 1)
+                  return MAPP_BAD_ARG;
+              break;
           case 'h':
               return cstep_print_usage();
               break;
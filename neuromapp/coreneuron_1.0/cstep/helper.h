@@ -46,6 +46,14 @@ struct input_parameters{
      \warning The default key name is cstep_storage_name_helper
      */
     char * name;
+    /** placement of the OMP threads, none, compact, scatter or a list of cpus
+     \warning The default value is "none"
+     */
+    char * bind;
+    /** number of sub-threads the data are split into by cell, shared by the OMP threads
+     \warning The default value is 0: the data are not split
+     */
+    int partition;
 };
 
 /** \fn cstep_print_usage()
@@ -42,29 +42,22 @@
 #include "coreneuron_1.0/cstep/cstep.h"
 
 #include "coreneuron_1.0/common/memory/nrnthread.h"
+#include "coreneuron_1.0/common/memory/partition.h"
 #include "coreneuron_1.0/common/util/nrnthread_handler.h"
 #include "coreneuron_1.0/common/util/timer.h"
+#include "coreneuron_1.0/common/util/affinity.h"
 
 #include "utils/error.h"
 
-int coreneuron10_cstep_execute(int argc, char * const argv[]) {
-    struct input_parameters p;
-
-    int error = MAPP_OK;
-    error = cstep_help(argc, argv, &p);
-    if(error != MAPP_OK)
-        return error;
-
-    //Gets the data
-    NrnThread * nt = (NrnThread *) storage_get(p.name, make_nrnthread, p.d, free_nrnthread);
-    if(nt == NULL){
-        storage_clear(p.name);
-        return MAPP_BAD_DATA;
-    }
-
-    //Initial mechanisms set-up already done in the input date (no need to call mech_init_Ih, etc)
-    gettimeofday(&tvBegin, NULL);
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
+/** \fn cstep_step(NrnThread *nt)
+    \brief one time step: the currents of the mechanisms, the solver and the states
+    \param nt the data
+ */
+static void cstep_step(NrnThread *nt) {
     //Load mechanisms
     mech_current_NaTs2_t(nt,&(nt->ml[17]));
     mech_current_Ih(nt,&(nt->ml[10]));
@@ -77,10 +70,104 @@ int coreneuron10_cstep_execute(int argc, char * const argv[]) {
     mech_state_NaTs2_t(nt,&(nt->ml[17]));
     mech_state_Ih(nt,&(nt->ml[10]));
     mech_state_ProbAMPANMDA_EMS(nt,&(nt->ml[18]));
+}
+
+/** \fn cstep_partition(NrnThread *nt, int n)
+    \brief the time step on n independent sub-threads of nt, shared by the
+    OMP threads, then the results are gathered in nt
+    \param nt the data
+    \param n the number of sub-threads
+    \return error message from mapp::mapp_error
+ */
+static int cstep_partition(NrnThread *nt, int n) {
+    int i, error;
+    long outside = 0;
+    double *elapsed, cost_max = 0., cost_sum = 0., time_max = 0., time_sum = 0.;
+    NrnThread *parts;
+
+    if(n > nt->ncell)
+        return MAPP_BAD_ARG;
+
+    //Split the cells, not timed
+    parts = (NrnThread *) malloc(sizeof(NrnThread) * n);
+    elapsed = (double *) malloc(sizeof(double) * n);
+    error = nrnthread_partition(nt, n, parts, &outside);
+    if(error == MAPP_BAD_DATA)
+        printf("\n Partition: %ld pdata point to another sub-thread, the data set cannot be split\n", outside);
+    if(error != MAPP_OK){
+        free(elapsed);
+        free(parts);
+        return error;
+    }
 
+    gettimeofday(&tvBegin, NULL);
+    #pragma omp parallel for schedule(static)
+    for(i = 0; i < n; ++i){
+        struct timeval begin, end, diff;
+        gettimeofday(&begin, NULL);
+        cstep_step(&parts[i]);
+        gettimeofday(&end, NULL);
+        timeval_subtract(&diff, &end, &begin);
+        elapsed[i] = diff.tv_sec + 1e-6 * diff.tv_usec;
+    }
     gettimeofday(&tvEnd, NULL);
     timeval_subtract(&tvDiff, &tvEnd, &tvBegin);
-    
-    printf("\nTime for full computational step: %ld [s] %ld [us]\n", tvDiff.tv_sec, (long) tvDiff.tv_usec);
+
+    error = nrnthread_gather(parts, n, nt);
+
+    printf("\n Partition: %d sub-threads\n", n);
+    for(i = 0; i < n; ++i){
+        double cost = nrnthread_cost(&parts[i]);
+        printf("   sub-thread %d: %d cells, %d compartments, cost %.0f, %.0f [us]\n",
+               i, parts[i].ncell, parts[i].end, cost, 1e6 * elapsed[i]);
+        cost_max = cost > cost_max ? cost : cost_max;
+        cost_sum += cost;
+        time_max = elapsed[i] > time_max ? elapsed[i] : time_max;
+        time_sum += elapsed[i];
+        nrnthread_dealloc(&parts[i]);
+    }
+    printf(" Load imbalance (max/mean): estimated %.3f, measured %.3f\n",
+           cost_max * n / cost_sum, time_sum > 0. ? time_max * n / time_sum : 1.);
+
+    free(elapsed);
+    free(parts);
+    return error;
+}
+
+int coreneuron10_cstep_execute(int argc, char * const argv[]) {
+    struct input_parameters p;
+
+    int error = MAPP_OK;
+    error = cstep_help(argc, argv, &p);
+    if(error != MAPP_OK)
+        return error;
+
+#ifdef _OPENMP
+    omp_set_num_threads(p.th);
+#endif
+    nrn_bind_threads(p.bind);
+
+    //Gets the data
+    NrnThread * nt = (NrnThread *) storage_acquire(p.name, make_nrnthread, p.d, free_nrnthread, size_nrnthread);
+    if(nt == NULL){
+        storage_clear(p.name);
+        return MAPP_BAD_DATA;
+    }
+
+    //Initial mechanisms set-up already done in the input date (no need to call mech_init_Ih, etc)
+    if(p.partition > 0){
+        error = cstep_partition(nt, p.partition);
+    } else {
+        gettimeofday(&tvBegin, NULL);
+        cstep_step(nt);
+        gettimeofday(&tvEnd, NULL);
+        timeval_subtract(&tvDiff, &tvEnd, &tvBegin);
+    }
+    if(error == MAPP_OK){
+        storage_put_double(STORAGE_COMPUTE_TIME, tvDiff.tv_sec + 1e-6 * tvDiff.tv_usec);
+        printf("\nTime for full computational step: %ld [s] %ld [us]\n", tvDiff.tv_sec, (long) tvDiff.tv_usec);
+    }
+
+    storage_release(p.name);
     return error;
 }
@@ -0,0 +1,46 @@
+/*
+ * Neuromapp - generate.h, Copyright (c), 2015,
+ * Timothee Ewart - Swiss Federal Institute of technology in Lausanne,
+ * Pramod Kumbhar - Swiss Federal Institute of technology in Lausanne,
+ * timothee.ewart@epfl.ch,
+ * paramod.kumbhar@epfl.ch
+ * All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+
+/**
+ * @file neuromapp/coreneuron_1.0/generate/generate.h
+ * \brief Implements a miniapp generating synthetic data sets of coreneuron 1.0
+ */
+
+#ifndef MAPP_GENERATE_EXECUTE_
+#define MAPP_GENERATE_EXECUTE_
+
+#ifdef __cplusplus
+     extern "C" {
+#endif
+    /** \fn coreneuron10_generate_execute(int argc, char *const argv[])
+        \brief miniapp building a NrnThread data set of any size, in the
+        storage for the other miniapps or in a file
+        \param argc number of argument from the command line
+        \param argv the command line from the driver or external call
+        \return error message from mapp::mapp_error
+    */
+     int coreneuron10_generate_execute(int argc, char *const argv[]);
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,128 @@
+/*
+ * Neuromapp - helper.c, Copyright (c), 2015,
+ * Timothee Ewart - Swiss Federal Institute of technology in Lausanne,
+ * Pramod Kumbhar - Swiss Federal Institute of technology in Lausanne,
+ * timothee.ewart@epfl.ch,
+ * paramod.kumbhar@epfl.ch
+ * All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+
+/**
+ * @file neuromapp/coreneuron_1.0/generate/helper.c
+ * \brief Implements the helper of the generate miniapp
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <getopt.h>
+
+#include "coreneuron_1.0/generate/helper.h"
+#include "utils/error.h"
+
+int generate_print_usage() {
+    printf("Usage: generate [--cells int] [--compartments int] [--section int] [--branching int] [--density string] [--seed int] [--name string] [--output string]\n");
+    printf("Details: \n");
+    printf("                 --cells [number of cells, default 17] \n");
+    printf("                 --compartments [compartments per cell, default 473] \n");
+    printf("                 --section [compartments per unbranched section, default 10] \n");
+    printf("                 --branching [child sections per section, default 2] \n");
+    printf("                 --density [instances per compartment as Na=0.5,Ih=1,ProbAMPANMDA=4, by name or type, default the ones of the provided data set] \n");
+    printf("                 --seed [placement of the mechanisms, default 101392] \n");
+    printf("                 --name [to internally reference the data, default name coreneuron_1.0_generated_data] \n");
+    printf("                 --output [file written in the format of --data of the other miniapps] \n");
+    return MAPP_USAGE;
+}
+
+int generate_help(int argc, char * const argv[], struct input_parameters * p)
+{
+  int c;
+
+  nrn_generator_default(&p->g);
+  p->name = "coreneuron_1.0_generated_data";
+  p->output = NULL;
+
+  optind = 0;
+
+  while (1)
+  {
+      static struct option long_options[] =
+      {
+          {"help", no_argument, 0, 'h'},
+          {"cells",  required_argument,       0, 'c'},
+          {"compartments",  required_argument,0, 'm'},
+          {"section",  required_argument,     0, 's'},
+          {"branching",  required_argument,   0, 'b'},
+          {"density",  required_argument,     0, 'd'},
+          {"seed",  required_argument,        0, 'r'},
+          {"name",  required_argument,        0, 'n'},
+          {"output",  required_argument,      0, 'o'},
+
+          {0, 0, 0, 0}
+      };
+      /* getopt_long stores the option index here. */
+      int option_index = 0;
+
+      c = getopt_long (argc, argv, "c:m:s:b:d:r:n:o:",
+                       long_options, &option_index);
+      /* Detect the end of the options. */
+      if (c == -1)
+        break;
+
+      switch (c)
+      {
+          case 'c':
+              p->g.ncell = atoi(optarg);
+              if(p->g.ncell < 1)
+                  return MAPP_BAD_ARG;
+              break;
+          case 'm':
+              p->g.ncompartment = atoi(optarg);
+              if(p->g.ncompartment < 2)
+                  return MAPP_BAD_ARG;
+              break;
+          case 's':
+              p->g.section = atoi(optarg);
+              if(p->g.section < 1)
+                  return MAPP_BAD_ARG;
+              break;
+          case 'b':
+              p->g.branching = atoi(optarg);
+              if(p->g.branching < 1)
+                  return MAPP_BAD_ARG;
+              break;
+          case 'd':
+              if(nrn_generator_density(&p->g, optarg) != 0)
+                  return MAPP_BAD_ARG;
+              break;
+          case 'r':
+              p->g.seed = (unsigned int) strtoul(optarg, NULL, 10);
+              break;
+          case 'n':
+              p->name = optarg;
+              break;
+          case 'o':
+              p->output = optarg;
+              break;
+          case 'h':
+              return generate_print_usage();
+              break;
+          default:
+              return generate_print_usage ();
+	      break;
+      }
+  }
+  return 0 ;
+}
@@ -0,0 +1,66 @@
+/*
+ * Neuromapp - helper.h, Copyright (c), 2015,
+ * Timothee Ewart - Swiss Federal Institute of technology in Lausanne,
+ * Pramod Kumbhar - Swiss Federal Institute of technology in Lausanne,
+ * timothee.ewart@epfl.ch,
+ * paramod.kumbhar@epfl.ch
+ * All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+
+/**
+ * @file neuromapp/coreneuron_1.0/generate/helper.h
+ * \brief Implements the helper of the generate miniapp
+ */
+
+#ifndef MAPP_GENERATE_HELPER_
+#define MAPP_GENERATE_HELPER_
+
+#include "coreneuron_1.0/common/memory/generator.h"
+
+/** \struct input_parameters
+ *  \brief contains the data provides by the user
+ */
+struct input_parameters{
+    /** shape of the data set
+     \warning The default values are the ones of bench.101392
+     */
+    struct nrn_generator g;
+    /** key for the storage library
+     \warning The default key name is coreneuron_1.0_generated_data
+     */
+    char * name;
+    /** file the data set is written to, in the format of the --data of the other miniapps
+     \warning The default value is NULL: storage only
+     */
+    char * output;
+};
+
+/** \fn generate_print_usage()
+    \brief Print the usage of the generate function
+    \return error code MAPP_USAGE
+ */
+int generate_print_usage();
+
+/** \fn int generate_help(int argc, char * const argv[], struct input_parameters * p)
+    \brief Interpret the command line and extract/set up the needed parameter
+    \param argc The number of argument in the command line
+    \param the command line
+    \param p the structure where the input data are saved
+    \return may return error code MAPP_BAD_ARG if the arguments are wrong
+*/
+int generate_help(int argc, char * const argv[], struct input_parameters * p);
+
+#endif
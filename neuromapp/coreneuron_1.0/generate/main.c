@@ -0,0 +1,85 @@
+/*
+ * Neuromapp - main.c, Copyright (c), 2015,
+ * Timothee Ewart - Swiss Federal Institute of technology in Lausanne,
+ * Pramod Kumbhar - Swiss Federal Institute of technology in Lausanne,
+ * timothee.ewart@epfl.ch,
+ * paramod.kumbhar@epfl.ch
+ * All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+
+/**
+ * @file neuromapp/coreneuron_1.0/generate/main.c
+ * \brief Implements a miniapp generating synthetic data sets of coreneuron 1.0
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "utils/storage/storage.h"
+
+#include "coreneuron_1.0/generate/generate.h"
+#include "coreneuron_1.0/generate/helper.h"
+#include "coreneuron_1.0/common/memory/nrnthread.h"
+#include "coreneuron_1.0/common/util/nrnthread_handler.h"
+#include "coreneuron_1.0/common/util/timer.h"
+#include "utils/error.h"
+
+int coreneuron10_generate_execute(int argc, char * const argv[])
+{
+    struct input_parameters p;
+    int i, error = MAPP_OK;
+    NrnThread *nt;
+
+    error = generate_help(argc, argv, &p);
+    if(error != MAPP_OK)
+        return error;
+
+    /* the other miniapps find it with --name, counted in the memory budget
+       as the data sets they load */
+    storage_clear(p.name);
+    gettimeofday(&tvBegin, NULL);
+    nt = (NrnThread *) storage_acquire(p.name, generate_nrnthread, &p.g, free_nrnthread, size_nrnthread);
+    gettimeofday(&tvEnd, NULL);
+    if(nt == NULL){
+        storage_clear(p.name);
+        return MAPP_BAD_ARG;
+    }
+
+    timeval_subtract(&tvDiff, &tvEnd, &tvBegin);
+    printf("\n Generate: %d cells, %d compartments, %d mechanisms, %.2f MB, %ld [s], %ld [us]\n",
+           nt->ncell, nt->end, nt->nmech, size_nrnthread(nt)/(1024.*1024.),
+           (long) tvDiff.tv_sec, (long) tvDiff.tv_usec);
+    for(i = 0; i < nt->nmech; ++i)
+        printf("   mechanism %2d type %3d: %d instances\n", i, nt->ml[i].type, nt->ml[i].nodecount);
+
+    if(p.output){
+        FILE *f = fopen(p.output, "w");
+        if(f == NULL){
+            storage_clear(p.name);
+            return MAPP_BAD_ARG;
+        }
+        error = nrnthread_write(f, nt);
+        if(fclose(f) != 0)
+            error = MAPP_BAD_DATA;
+        if(error != MAPP_OK){
+            storage_clear(p.name);
+            return error;
+        }
+    }
+
+    storage_release(p.name);
+    return error;
+}
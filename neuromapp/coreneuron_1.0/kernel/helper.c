@@ -34,16 +34,24 @@
 #include <unistd.h>
 
 #include "coreneuron_1.0/kernel/helper.h"
+#include "coreneuron_1.0/kernel/nmodl/registry.h"
+#include "coreneuron_1.0/common/util/affinity.h"
 #include "utils/error.h"
 
 int kernel_print_usage() {
-    printf("Usage: kernel --mechanism [string] --function [string] --data [string] --numthread [int] --name [string]\n");
+    printf("Usage: kernel --mechanism [string] --function [string] --data [string] --numthread [int] --name [string] --clone [string] --alloc [string] --bind [string] --variant [string] --width [int] --isa [string]\n");
     printf("Details: \n");
-    printf("                 --mechanism [Na, ProbAMPANMDA or Ih] \n");
+    printf("                 --mechanism [Na, ProbAMPANMDA or Ih, with --variant nmodl the SUFFIX of a description of kernel/nmodl] \n");
     printf("                 --function [state or current] \n");
     printf("                 --data [path to the input] \n");
     printf("                 --numthread [threadnumber] \n");
     printf("                 --name [to internally reference the data, default name coreneuron_1.0_kernel_data] \n");
+    printf("                 --clone [copy or share, reports the time and resident memory of one clone per thread] \n");
+    printf("                 --alloc [default, hugepage, firsttouch or interleave, for the data loaded or cloned, firsttouch places the copies by the threads that compute on them] \n");
+    printf("                 --bind [none, compact, scatter or a list of cpus as 0,2,4-7, placement of the threads] \n");
+    printf("                 --variant [c, template or nmodl, the C kernels, the C++ ones specialized on the width or the ones generated from NMODL, default c] \n");
+    printf("                 --width [1, 2, 4 or 8, instances per block of the template kernels, default the SIMD width of the mechanism] \n");
+    printf("                 --isa [base, sse4, avx2, avx512 or auto, instruction set of the C kernels, default auto: the best one of the CPU] \n");
     return MAPP_USAGE;
 }
 
@@ -73,6 +81,12 @@ int kernel_help(int argc, char * const argv[], struct input_parameters * p)
   p->d = "";
   p->th = 1; // one omp thread by default
   p->name = "coreneuron_1.0_kernel_data";
+  p->clone = NULL;
+  p->alloc = NRN_ALLOC_DEFAULT;
+  p->bind = "none";
+  p->variant = "c";
+  p->width = 0;
+  p->isa = mech_isa_best();
 
   optind = 0;
 
@@ -86,13 +100,19 @@ int kernel_help(int argc, char * const argv[], struct input_parameters * p)
           {"data",  required_argument,     0, 'd'},
           {"numthread",  required_argument,0, 't'},
           {"name",  required_argument,     0, 'n'},
+          {"clone",  required_argument,    0, 'c'},
+          {"alloc",  required_argument,    0, 'a'},
+          {"bind",  required_argument,     0, 'b'},
+          {"variant",  required_argument,  0, 'v'},
+          {"width",  required_argument,    0, 'w'},
+          {"isa",  required_argument,      0, 'i'},
 
           {0, 0, 0, 0}
       };
       /* getopt_long stores the option index here. */
       int option_index = 0;
 
-      c = getopt_long (argc, argv, "m:f:d:t:n:",
+      c = getopt_long (argc, argv, "m:f:d:t:n:c:a:b:v:w:i:",
                        long_options, &option_index);
       /* Detect the end of the options. */
       if (c == -1)
@@ -101,7 +121,7 @@ int kernel_help(int argc, char * const argv[], struct input_parameters * p)
       switch (c)
       {
           case 'm':
-              if(kernel_help_mechanism(optarg) != MAPP_OK)
+              if(kernel_help_mechanism(optarg) != MAPP_OK && mech_nmodl_find(optarg) == NULL)
                   return MAPP_BAD_ARG;
               p->m = optarg;
               break;
@@ -121,6 +141,34 @@ int kernel_help(int argc, char * const argv[], struct input_parameters * p)
           case 'n':
               p->name = optarg;
               break;
+          case 'c':
+              if((strcmp(optarg,"copy") != 0) && (strcmp(optarg,"share") != 0))
+                  return MAPP_BAD_ARG;
+              p->clone = optarg;
+              break;
+          case 'a':
+              if(nrn_alloc_policy_from_string(optarg, &p->alloc) != 0)
+                  return MAPP_BAD_ARG;
+              break;
+          case 'b':
+              if(nrn_bind_check(optarg) != 0)
+                  return MAPP_BAD_ARG;
+              p->bind = optarg;
+              break;
+          case 'v':
+              if((strcmp(optarg,"c") != 0) && (strcmp(optarg,"template") != 0) && (strcmp(optarg,"nmodl") != 0))
+                  return MAPP_BAD_ARG;
+              p->variant = optarg;
+              break;
+          case 'w':
+              p->width = atoi(optarg);
+              if(p->width != 1 && p->width != 2 && p->width != 4 && p->width != 8)
+                  return MAPP_BAD_ARG;
+              break;
+          case 'i':
+              if(mech_isa_from_string(optarg, &p->isa) != 0)
+                  return MAPP_BAD_ARG;
+              break;
           case 'h':
               return kernel_print_usage();
               break;
@@ -129,5 +177,13 @@ int kernel_help(int argc, char * const argv[], struct input_parameters * p)
 	      break;
       }
   }
+
+  /* the generated kernels are found by the SUFFIX, the others by a prefix */
+  if(strcmp(p->variant,"nmodl") == 0){
+      if(mech_nmodl_find(p->m) == NULL)
+          return MAPP_BAD_ARG;
+  } else if(kernel_help_mechanism(p->m) != MAPP_OK)
+      return MAPP_BAD_ARG;
+
   return 0 ;
 }
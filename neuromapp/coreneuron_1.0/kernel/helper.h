@@ -30,6 +30,9 @@
 #ifndef MAPP_KERNEL_HELPER_
 #define MAPP_KERNEL_HELPER_
 
+#include "coreneuron_1.0/common/memory/memory.h"
+#include "coreneuron_1.0/kernel/mechanism/isa.h"
+
 /** \struct input_parameters
  *  \brief contains the data provides by the user
  */
@@ -52,6 +55,30 @@ struct input_parameters{
      \warning The default key name is coreneuron_1.0_kernel_data
      */
     char * name;
+    /** clone of the dataset for the computation, copy or share
+     \warning The default value is NULL: copy, without clone benchmark
+     */
+    char * clone;
+    /** allocation policy of the data set and of its clones
+     \warning The default value is NRN_ALLOC_DEFAULT
+     */
+    enum nrn_alloc_policy alloc;
+    /** placement of the OMP threads, none, compact, scatter or a list of cpus
+     \warning The default value is "none"
+     */
+    char * bind;
+    /** implementation of the kernels, c, template or nmodl
+     \warning The default value is "c"
+     */
+    char * variant;
+    /** instances per block of the template kernels, 1, 2, 4 or 8
+     \warning The default value is 0: the width of the descriptor of the mechanism
+     */
+    int width;
+    /** instruction set of the C kernels, base, sse4, avx2 or avx512
+     \warning The default value is the best one the CPU supports
+     */
+    enum mech_isa isa;
 };
 
 /** \fn cstep_print_usage()
@@ -28,15 +28,21 @@
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include <unistd.h>
 
 #include "utils/storage/storage.h"
 
 #include "coreneuron_1.0/kernel/helper.h"
 #include "coreneuron_1.0/kernel/kernel.h"
 #include "coreneuron_1.0/kernel/mechanism/mechanism.h"
+#include "coreneuron_1.0/kernel/mechanism/isa.h"
+#include "coreneuron_1.0/kernel/mechanism/template/kernels.h"
+#include "coreneuron_1.0/kernel/nmodl/registry.h"
 #include "coreneuron_1.0/common/memory/nrnthread.h"
 #include "coreneuron_1.0/common/util/nrnthread_handler.h"
 #include "coreneuron_1.0/common/util/timer.h"
+#include "coreneuron_1.0/common/util/perf_counters.h"
+#include "coreneuron_1.0/common/util/affinity.h"
 #include "utils/error.h"
 
 #ifdef _OPENMP
@@ -50,30 +56,73 @@
  */
 void compute_wrapper(NrnThread *nt, struct input_parameters* p);
 
+/** \fn clone_benchmark(NrnThread *nt, struct input_parameters* p, void *(*clone)(void *))
+    \brief Every OMP thread makes a clone of the data, the time and the resident
+    memory of the clones are reported
+    \param nt the data structure to clone
+    \param p input parameters
+    \param clone clone_nrnthread or share_nrnthread
+ */
+void clone_benchmark(NrnThread *nt, struct input_parameters* p, void *(*clone)(void *));
+
 int coreneuron10_kernel_execute(int argc, char *const argv[])
 {
 
     struct input_parameters p;
+    enum mech_isa isa;
+    enum nrn_alloc_policy alloc;
     int error = MAPP_OK;
     error = kernel_help(argc, argv, &p);
     if(error != MAPP_OK)
         return error;
 
+    isa = mech_get_isa();
+    if(mech_set_isa(p.isa) != 0){
+        printf("\n Instruction set %s not supported by this build or CPU\n", mech_isa_name(p.isa));
+        return MAPP_BAD_ARG;
+    }
+    printf("\n Mechanism kernels: %s", mech_isa_name(p.isa));
+
 #ifdef _OPENMP
     omp_set_num_threads(p.th);
 #endif
+    nrn_bind_threads(p.bind);
 
-    NrnThread * nt = (NrnThread *) storage_get (p.name,  make_nrnthread, p.d, free_nrnthread);
+    alloc = nrn_get_alloc_policy();
+    nrn_set_alloc_policy(p.alloc);
+    NrnThread * nt = (NrnThread *) storage_acquire (p.name,  make_nrnthread, p.d, free_nrnthread, size_nrnthread);
     if(nt == NULL){
         storage_clear(p.name);
+        nrn_set_alloc_policy(alloc);
+        mech_set_isa(isa);
         return MAPP_BAD_DATA;
     }
 
+    if(strcmp(p.variant,"nmodl") == 0 && mech_nmodl_data(mech_nmodl_find(p.m), nt) == NULL){
+        printf("\n No instance of %s in the data set with the layout of its description\n", p.m);
+        storage_release(p.name);
+        nrn_set_alloc_policy(alloc);
+        mech_set_isa(isa);
+        return MAPP_BAD_DATA;
+    }
+
+    void *(*clone)(void *) = clone_nrnthread;
+    if(p.clone && strcmp(p.clone,"share") == 0)
+        clone = share_nrnthread;
+    if(p.clone)
+        clone_benchmark(nt, &p, clone);
+
     //#pragma omp parallel
     {
-        NrnThread * ntlocal = (NrnThread *) clone_nrnthread(nt);
+        /* the thread that computes makes its copy: with --alloc firsttouch
+           the pages are on its NUMA node, not on the one of the loading thread */
+        NrnThread * ntlocal = (NrnThread *) clone(nt);
+        struct perf_counters pc;
         #pragma omp barrier
+        perf_counters_start(&pc);
         compute_wrapper(ntlocal,&p);
+        perf_counters_stop(&pc);
+        perf_counters_print(&pc);
         #pragma omp barrier
         #pragma omp single
         {
@@ -82,44 +131,123 @@ int coreneuron10_kernel_execute(int argc, char *const argv[])
         }
         if (ntlocal) free_nrnthread(ntlocal);
     }
+    storage_release(p.name);
+    nrn_set_alloc_policy(alloc);
+    mech_set_isa(isa);
     return error;
 }
 
+/** \fn kernel_call(struct input_parameters *p, mech_kernel c_kernel, const char *f, NrnThread *nt, Mechanism *ml)
+    \brief Calls the C kernel, or the template one of the same mechanism and function
+ */
+static void kernel_call(struct input_parameters *p, mech_kernel c_kernel, const char *f, NrnThread *nt, Mechanism *ml)
+{
+    if(strcmp(p->variant,"template") == 0)
+        mech_template_kernel(p->m, f, p->width)(nt, ml);
+    else
+        c_kernel(nt, ml);
+}
+
+/** \fn nmodl_call(struct input_parameters *p, NrnThread *nt)
+    \brief Calls the generated kernel of the mechanism p->m, its data checked by the caller
+ */
+static void nmodl_call(struct input_parameters *p, NrnThread *nt)
+{
+    const struct mech_nmodl *k = mech_nmodl_find(p->m);
+    Mechanism *ml = mech_nmodl_data(k, nt);
+    gettimeofday(&tvBegin, NULL);
+    if(strncmp(p->f,"state",5) == 0)
+        k->state(nt, ml);
+    if(strncmp(p->f,"current",7) == 0)
+        k->current(nt, ml);
+    gettimeofday(&tvEnd, NULL);
+}
+
 void compute_wrapper(NrnThread *nt, struct input_parameters *p)
 {
-    if(strncmp(p->m,"Na",2) == 0)
+    if(strcmp(p->variant,"nmodl") == 0)
+        nmodl_call(p, nt);
+    else if(strncmp(p->m,"Na",2) == 0)
     {
         const size_t mech_id = 17;
         gettimeofday(&tvBegin, NULL);
         if(strncmp(p->f,"state",5) == 0)
-             mech_state_NaTs2_t(nt, &(nt->ml[mech_id]));
+             kernel_call(p, mech_state_NaTs2_t, "state", nt, &(nt->ml[mech_id]));
         if(strncmp(p->f,"current",7) == 0)
-             mech_current_NaTs2_t(nt, &(nt->ml[mech_id]));
+             kernel_call(p, mech_current_NaTs2_t, "current", nt, &(nt->ml[mech_id]));
         gettimeofday(&tvEnd, NULL);
     }
-
-    if(strncmp(p->m,"Ih",2) == 0)
+    else if(strncmp(p->m,"Ih",2) == 0)
     {
         const size_t mech_id = 10;
         gettimeofday(&tvBegin, NULL);
         if(strncmp(p->f,"state",5) == 0)
-             mech_current_Ih(nt, &(nt->ml[mech_id]));
+             kernel_call(p, mech_current_Ih, "current", nt, &(nt->ml[mech_id]));
         if(strncmp(p->f,"current",7) == 0)
-             mech_state_Ih(nt, &(nt->ml[mech_id]));
+             kernel_call(p, mech_state_Ih, "state", nt, &(nt->ml[mech_id]));
         gettimeofday(&tvEnd, NULL);
     }
-
-    if(strncmp(p->m,"ProbAMPANMDA",12) == 0)
+    else if(strncmp(p->m,"ProbAMPANMDA",12) == 0)
     {
         const size_t mech_id = 18;
         gettimeofday(&tvBegin, NULL);
         if(strncmp(p->f,"state",5) == 0)
-            mech_state_ProbAMPANMDA_EMS(nt, &(nt->ml[mech_id]));
+            kernel_call(p, mech_state_ProbAMPANMDA_EMS, "state", nt, &(nt->ml[mech_id]));
         if(strncmp(p->f,"current",7) == 0)
-            mech_current_ProbAMPANMDA_EMS(nt, &(nt->ml[mech_id]));
+            kernel_call(p, mech_current_ProbAMPANMDA_EMS, "current", nt, &(nt->ml[mech_id]));
         gettimeofday(&tvEnd, NULL);
     }
     timeval_subtract(&tvDiff, &tvEnd, &tvBegin);
     printf("\n CURRENT SOA State Version : %s; %s: %ld [s], %ld [us]",
            p->m, p->f, (long) tvDiff.tv_sec, (long) tvDiff.tv_usec);
+    storage_put_double(STORAGE_COMPUTE_TIME, tvDiff.tv_sec + 1e-6 * tvDiff.tv_usec);
+}
+
+/** \fn size_t resident_memory()
+    \brief Resident memory of the process
+    \return the size in bytes, 0 if /proc/self/statm cannot be read
+ */
+static size_t resident_memory()
+{
+    long pages = 0;
+    FILE *f = fopen("/proc/self/statm", "r");
+    if(!f)
+        return 0;
+    if(fscanf(f, "%*s %ld", &pages) != 1)
+        pages = 0;
+    fclose(f);
+    return (size_t) pages * sysconf(_SC_PAGESIZE);
+}
+
+void clone_benchmark(NrnThread *nt, struct input_parameters* p, void *(*clone)(void *))
+{
+    int i, nthreads = 1;
+    size_t rss_begin, rss_end;
+    NrnThread **clones;
+#ifdef _OPENMP
+    nthreads = omp_get_max_threads();
+#endif
+    clones = (NrnThread **) malloc(nthreads*sizeof(NrnThread *));
+
+    rss_begin = resident_memory();
+    gettimeofday(&tvBegin, NULL);
+    #pragma omp parallel
+    {
+        int id = 0;
+#ifdef _OPENMP
+        id = omp_get_thread_num();
+#endif
+        clones[id] = (NrnThread *) clone(nt);
+    }
+    gettimeofday(&tvEnd, NULL);
+    rss_end = resident_memory();
+
+    timeval_subtract(&tvDiff, &tvEnd, &tvBegin);
+    printf("\n Clone (%s): %d threads, %ld [s], %ld [us], resident memory %.2f MB, clones %.2f MB",
+           p->clone, nthreads, (long) tvDiff.tv_sec, (long) tvDiff.tv_usec,
+           rss_end/(1024.*1024.), ((double)rss_end - (double)rss_begin)/(1024.*1024.));
+
+    for(i = 0; i < nthreads; ++i)
+        free_nrnthread(clones[i]);
+    free(clones);
 }
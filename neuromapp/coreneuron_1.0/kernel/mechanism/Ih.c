@@ -27,6 +27,7 @@
 #include <math.h>
 
 #include "coreneuron_1.0/kernel/mechanism/mechanism.h"
+#include "coreneuron_1.0/kernel/mechanism/isa.h"
 #include "coreneuron_1.0/common/memory/nrnthread.h"
 #include "coreneuron_1.0/common/util/vectorizer.h"
 
@@ -40,7 +41,7 @@
 #define _v_unused _p[4*_STRIDE]
 #define _g_unused _p[5*_STRIDE]
 
-void mech_current_Ih(NrnThread* _nt, Mechanism* _ml) {
+void MECH_ISA(mech_current_Ih)(NrnThread* _nt, Mechanism* _ml) {
     double* _p;
     int* _ni;
     double _rhs, _g, _v;
@@ -69,7 +70,7 @@ void mech_current_Ih(NrnThread* _nt, Mechanism* _ml) {
     }
 }
 
-void mech_state_Ih(NrnThread* _nt, Mechanism* _ml) {
+void MECH_ISA(mech_state_Ih)(NrnThread* _nt, Mechanism* _ml) {
     double* _p;
     int* _ppvar;
     double v, _v = 0.0;
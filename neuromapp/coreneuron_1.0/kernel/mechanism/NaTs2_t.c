@@ -27,6 +27,7 @@
 #include <math.h>
 
 #include "coreneuron_1.0/kernel/mechanism/mechanism.h"
+#include "coreneuron_1.0/kernel/mechanism/isa.h"
 #include "coreneuron_1.0/common/memory/nrnthread.h"
 #include "coreneuron_1.0/common/util/vectorizer.h"
 
@@ -46,7 +47,7 @@
 #define _ion_ina _nt_data[_ppvar[1*_STRIDE]]
 #define _ion_dinadv _nt_data[_ppvar[2*_STRIDE]]
 
-void mech_state_NaTs2_t(NrnThread *_nt, Mechanism *_ml)
+void MECH_ISA(mech_state_NaTs2_t)(NrnThread *_nt, Mechanism *_ml)
 {
     double _v, v;
     int *_ni = _ml->nodeindices;
@@ -90,7 +91,7 @@ void mech_state_NaTs2_t(NrnThread *_nt, Mechanism *_ml)
     }
 }
 
-void mech_current_NaTs2_t(NrnThread *_nt, Mechanism *_ml)
+void MECH_ISA(mech_current_NaTs2_t)(NrnThread *_nt, Mechanism *_ml)
 {
     double* _p = _ml->data;
     int* _ppvar = _ml->pdata;
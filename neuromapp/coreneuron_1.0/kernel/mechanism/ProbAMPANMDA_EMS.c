@@ -27,6 +27,7 @@
 #include <math.h>
 
 #include "coreneuron_1.0/kernel/mechanism/mechanism.h"
+#include "coreneuron_1.0/kernel/mechanism/isa.h"
 #include "coreneuron_1.0/common/memory/nrnthread.h"
 #include "coreneuron_1.0/common/util/vectorizer.h"
 
@@ -77,7 +78,7 @@
 #define _nd_area  _nt_data[_ppvar[0*_STRIDE]]
 #define _p_rng  _nt->_vdata[_ppvar[2*_STRIDE]]
 
-void mech_state_ProbAMPANMDA_EMS(NrnThread *_nt, Mechanism *_ml)
+void MECH_ISA(mech_state_ProbAMPANMDA_EMS)(NrnThread *_nt, Mechanism *_ml)
 {
     int _cntml = _ml->nodecount;
     double * restrict _p = _ml->data;
@@ -93,7 +94,7 @@ void mech_state_ProbAMPANMDA_EMS(NrnThread *_nt, Mechanism *_ml)
     }
 }
 
-void mech_current_ProbAMPANMDA_EMS(NrnThread *_nt, Mechanism *_ml)
+void MECH_ISA(mech_current_ProbAMPANMDA_EMS)(NrnThread *_nt, Mechanism *_ml)
 {
     double _rhs, _g = 0.0;
     int *_ni = _ml->nodeindices;
@@ -0,0 +1,93 @@
+/*
+ * Neuromapp - descriptor.c, Copyright (c), 2015,
+ * Timothee Ewart - Swiss Federal Institute of technology in Lausanne,
+ * Pramod Kumbhar - Swiss Federal Institute of technology in Lausanne,
+ * timothee.ewart@epfl.ch,
+ * paramod.kumbhar@epfl.ch
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+
+/**
+ * @file neuromapp/coreneuron_1.0/kernel/mechanism/descriptor.c
+ * \brief Memory accesses and floating point operations of the kernels, per instance
+ */
+
+#include <string.h>
+
+#include "coreneuron_1.0/kernel/mechanism/mechanism.h"
+#include "coreneuron_1.0/kernel/mechanism/descriptor.h"
+
+/*
+ * The counts follow the loops of NaTs2_t.c, Ih.c and ProbAMPANMDA_EMS.c, the
+ * rare branches (_llv == -32.0 ...) and the negations are not counted.
+ * A rate alpha or beta costs 6 flops and one exp (2 for the beta of Ih),
+ * inf and tau 4 or 5, the cnexp update of a gate 9 flops and one exp.
+ */
+const struct mech_descriptor mech_descriptors[] = {
+    /* m, h read, m, h, ena written, v and ena gathered through _ni and _ppvar[0] */
+    {"Na", "state", 17, mech_state_NaTs2_t, 2, 3, 0, 1, 1, 2, 0, 52, 6},
+    /* gbar, m, h read, ena written, v, ena gathered, ina, dinadv, rhs, d updated */
+    {"Na", "current", 17, mech_current_NaTs2_t, 3, 1, 0, 1, 3, 2, 4, 10, 0},
+    /* m read and written, v gathered */
+    {"Ih", "state", 10, mech_state_Ih, 1, 1, 0, 1, 0, 1, 0, 21, 3},
+    /* gbar, m read, v gathered, rhs and d updated */
+    {"Ih", "current", 10, mech_current_Ih, 2, 0, 0, 1, 0, 1, 2, 5, 0},
+    /* A, B of AMPA and NMDA and their steps read, A and B written */
+    {"ProbAMPANMDA", "state", 18, mech_state_ProbAMPANMDA_EMS, 8, 4, 0, 0, 0, 0, 0, 4, 0},
+    /* mg, e, A, B read, rhs and d through the shadows, _ni read by both loops,
+       v and area gathered, rhs and d updated */
+    {"ProbAMPANMDA", "current", 18, mech_current_ProbAMPANMDA_EMS, 6, 0, 2, 2, 1, 2, 2, 20, 1}
+};
+
+const int mech_ndescriptors = sizeof(mech_descriptors)/sizeof(mech_descriptors[0]);
+
+const struct mech_descriptor* mech_descriptor_find(const char *mechanism, const char *function)
+{
+    int i;
+    for(i = 0; i < mech_ndescriptors; ++i)
+        if(strcmp(mech_descriptors[i].mechanism, mechanism) == 0 &&
+           strcmp(mech_descriptors[i].function, function) == 0)
+            return &mech_descriptors[i];
+    return NULL;
+}
+
+int mech_descriptor_check(const struct mech_descriptor *d, const Mechanism *ml)
+{
+    if(d->reads > ml->szp || d->writes > ml->szp || d->pdata > ml->szdp)
+        return -1;
+    return 0;
+}
+
+double mech_stream_bytes(const struct mech_descriptor *d, const Mechanism *ml)
+{
+    int doubles = d->reads + d->writes + 2 * d->shadows;
+    int ints = d->nodeindices + d->pdata;
+    return (double) ml->nodecount * (doubles * sizeof(double) + ints * sizeof(int));
+}
+
+double mech_gather_bytes(const struct mech_descriptor *d, const Mechanism *ml)
+{
+    return (double) ml->nodecount * d->gathers * sizeof(double);
+}
+
+double mech_scatter_bytes(const struct mech_descriptor *d, const Mechanism *ml)
+{
+    return (double) ml->nodecount * d->scatters * 2 * sizeof(double);
+}
+
+double mech_flops(const struct mech_descriptor *d, const Mechanism *ml)
+{
+    return (double) ml->nodecount * (d->flops + MECH_EXP_FLOPS * d->exps);
+}
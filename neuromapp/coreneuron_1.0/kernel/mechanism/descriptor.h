@@ -0,0 +1,109 @@
+/*
+ * Neuromapp - descriptor.h, Copyright (c), 2015,
+ * Timothee Ewart - Swiss Federal Institute of technology in Lausanne,
+ * Pramod Kumbhar - Swiss Federal Institute of technology in Lausanne,
+ * timothee.ewart@epfl.ch,
+ * paramod.kumbhar@epfl.ch
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+
+/**
+ * @file neuromapp/coreneuron_1.0/kernel/mechanism/descriptor.h
+ * \brief Memory accesses and floating point operations of the kernels, per instance
+*/
+
+#ifndef MAPP_KERNEL_DESCRIPTOR_
+#define MAPP_KERNEL_DESCRIPTOR_
+
+#include "coreneuron_1.0/common/memory/nrnthread.h"
+
+#ifdef __cplusplus
+     extern "C" {
+#endif
+
+/** floating point operations counted for one exp(), the order of a
+    vectorised polynomial implementation */
+#define MECH_EXP_FLOPS 20
+
+/** \struct mech_descriptor
+    \brief what one instance of a kernel reads, writes and computes, counted
+    in the sources of the mechanism
+ */
+struct mech_descriptor {
+    /** mechanism and function, as --mechanism and --function of the kernel miniapp */
+    const char *mechanism;
+    const char *function;
+    /** index of the mechanism in the data set */
+    int mech_id;
+    void (*f)(NrnThread *, Mechanism *);
+    /** fields of the data read and written, at most szp */
+    int reads;
+    int writes;
+    /** doubles written to the shadow arrays, then read back */
+    int shadows;
+    /** loops reading the nodeindices */
+    int nodeindices;
+    /** entries of pdata read, at most szdp */
+    int pdata;
+    /** doubles read through an index: the voltage, the ions, the area */
+    int gathers;
+    /** doubles read and written through an index: the ion currents, rhs and d */
+    int scatters;
+    /** additions, multiplications and divisions */
+    int flops;
+    /** calls to exp() */
+    int exps;
+};
+
+/** the kernels of mechanism.h */
+extern const struct mech_descriptor mech_descriptors[];
+extern const int mech_ndescriptors;
+
+/** \fn const struct mech_descriptor* mech_descriptor_find(const char *mechanism, const char *function)
+    \return the descriptor of the kernel, NULL if it does not exist
+ */
+const struct mech_descriptor* mech_descriptor_find(const char *mechanism, const char *function);
+
+/** \fn int mech_descriptor_check(const struct mech_descriptor *d, const Mechanism *ml)
+    \brief the descriptor must fit in the layout of the mechanism in the data set
+    \return 0 if the fields read and written fit in szp and the entries of pdata in szdp, else -1
+ */
+int mech_descriptor_check(const struct mech_descriptor *d, const Mechanism *ml);
+
+/** \fn double mech_stream_bytes(const struct mech_descriptor *d, const Mechanism *ml)
+    \return bytes of the data, the shadows and the indices streamed by the kernel on ml
+ */
+double mech_stream_bytes(const struct mech_descriptor *d, const Mechanism *ml);
+
+/** \fn double mech_gather_bytes(const struct mech_descriptor *d, const Mechanism *ml)
+    \return bytes read through an index by the kernel on ml
+ */
+double mech_gather_bytes(const struct mech_descriptor *d, const Mechanism *ml);
+
+/** \fn double mech_scatter_bytes(const struct mech_descriptor *d, const Mechanism *ml)
+    \return bytes read and written through an index by the kernel on ml
+ */
+double mech_scatter_bytes(const struct mech_descriptor *d, const Mechanism *ml);
+
+/** \fn double mech_flops(const struct mech_descriptor *d, const Mechanism *ml)
+    \return floating point operations of the kernel on ml, exp() counted MECH_EXP_FLOPS
+ */
+double mech_flops(const struct mech_descriptor *d, const Mechanism *ml);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
@@ -0,0 +1,223 @@
+/*
+ * Neuromapp - isa.c, Copyright (c), 2015,
+ * Timothee Ewart - Swiss Federal Institute of technology in Lausanne,
+ * Pramod Kumbhar - Swiss Federal Institute of technology in Lausanne,
+ * timothee.ewart@epfl.ch,
+ * paramod.kumbhar@epfl.ch
+ * All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+
+/**
+ * @file neuromapp/coreneuron_1.0/kernel/mechanism/isa.c
+ * \brief Implements the dispatch of the mechanism kernels on the instruction set
+ */
+
+#include <stddef.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+#include "coreneuron_1.0/kernel/mechanism/mechanism.h"
+#include "coreneuron_1.0/kernel/mechanism/isa.h"
+
+/** \struct mech_isa_kernels
+    \brief the kernels of mechanism.h for one instruction set
+ */
+struct mech_isa_kernels {
+    void (*state_NaTs2_t)(NrnThread *nt, Mechanism *ml);
+    void (*current_NaTs2_t)(NrnThread *nt, Mechanism *ml);
+    void (*state_Ih)(NrnThread *nt, Mechanism *ml);
+    void (*current_Ih)(NrnThread *nt, Mechanism *ml);
+    void (*state_ProbAMPANMDA_EMS)(NrnThread *nt, Mechanism *ml);
+    void (*current_ProbAMPANMDA_EMS)(NrnThread *nt, Mechanism *ml);
+};
+
+/* the kernels of an instruction set, and their table */
+#define MECH_ISA_KERNELS(s) \
+    void mech_state_NaTs2_t##s(NrnThread *nt, Mechanism *ml); \
+    void mech_current_NaTs2_t##s(NrnThread *nt, Mechanism *ml); \
+    void mech_state_Ih##s(NrnThread *nt, Mechanism *ml); \
+    void mech_current_Ih##s(NrnThread *nt, Mechanism *ml); \
+    void mech_state_ProbAMPANMDA_EMS##s(NrnThread *nt, Mechanism *ml); \
+    void mech_current_ProbAMPANMDA_EMS##s(NrnThread *nt, Mechanism *ml); \
+    static const struct mech_isa_kernels mech_kernels##s = { \
+        mech_state_NaTs2_t##s, mech_current_NaTs2_t##s, \
+        mech_state_Ih##s, mech_current_Ih##s, \
+        mech_state_ProbAMPANMDA_EMS##s, mech_current_ProbAMPANMDA_EMS##s };
+
+MECH_ISA_KERNELS(_base)
+#ifdef MECH_ISA_HAVE_sse4
+MECH_ISA_KERNELS(_sse4)
+#endif
+#ifdef MECH_ISA_HAVE_avx2
+MECH_ISA_KERNELS(_avx2)
+#endif
+#ifdef MECH_ISA_HAVE_avx512
+MECH_ISA_KERNELS(_avx512)
+#endif
+
+/** the kernels of every instruction set, NULL if not built */
+static const struct mech_isa_kernels *mech_isa_table[MECH_ISA_COUNT] = {
+    &mech_kernels_base,
+#ifdef MECH_ISA_HAVE_sse4
+    &mech_kernels_sse4,
+#else
+    NULL,
+#endif
+#ifdef MECH_ISA_HAVE_avx2
+    &mech_kernels_avx2,
+#else
+    NULL,
+#endif
+#ifdef MECH_ISA_HAVE_avx512
+    &mech_kernels_avx512
+#else
+    NULL
+#endif
+};
+
+static const char *mech_isa_names[MECH_ISA_COUNT] = {"base", "sse4", "avx2", "avx512"};
+
+/** the instruction set selected, -1 until the first kernel or mech_set_isa */
+static int mech_isa_selected = -1;
+
+/** \fn int mech_isa_cpu(enum mech_isa isa)
+    \brief Non-zero if cpuid reports the instruction set, and xgetbv the
+    saving of its registers by the OS
+ */
+static int mech_isa_cpu(enum mech_isa isa)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    unsigned int eax, ebx, ecx, edx, xcr0_low, xcr0_high;
+    unsigned int leaf1_ecx, leaf7_ebx = 0;
+
+    if(isa == MECH_ISA_BASE)
+        return 1;
+    if(!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+        return 0;
+    leaf1_ecx = ecx;
+    /* SSE4.1 and SSE4.2 */
+    if(isa == MECH_ISA_SSE4)
+        return (leaf1_ecx & (1u << 19)) && (leaf1_ecx & (1u << 20));
+
+    /* AVX, FMA and the xgetbv instruction */
+    if(!(leaf1_ecx & (1u << 28)) || !(leaf1_ecx & (1u << 12)) || !(leaf1_ecx & (1u << 27)))
+        return 0;
+    if(__get_cpuid_max(0, NULL) >= 7){
+        __cpuid_count(7, 0, eax, ebx, ecx, edx);
+        leaf7_ebx = ebx;
+    }
+    __asm__ __volatile__("xgetbv" : "=a"(xcr0_low), "=d"(xcr0_high) : "c"(0));
+    (void) xcr0_high;
+
+    /* the OS saves the SSE and AVX registers */
+    if((xcr0_low & 0x6) != 0x6 || !(leaf7_ebx & (1u << 5)))
+        return 0;
+    if(isa == MECH_ISA_AVX2)
+        return 1;
+
+    /* AVX-512F, and the OS saves the opmask and ZMM registers */
+    return isa == MECH_ISA_AVX512 && (leaf7_ebx & (1u << 16)) && (xcr0_low & 0xe6) == 0xe6;
+#else
+    return isa == MECH_ISA_BASE;
+#endif
+}
+
+int mech_isa_supported(enum mech_isa isa)
+{
+    if((int) isa < 0 || isa >= MECH_ISA_COUNT || mech_isa_table[isa] == NULL)
+        return 0;
+    return mech_isa_cpu(isa);
+}
+
+enum mech_isa mech_isa_best()
+{
+    int isa;
+    for(isa = MECH_ISA_COUNT - 1; isa > MECH_ISA_BASE; --isa)
+        if(mech_isa_supported((enum mech_isa) isa))
+            break;
+    return (enum mech_isa) isa;
+}
+
+int mech_set_isa(enum mech_isa isa)
+{
+    if(!mech_isa_supported(isa))
+        return 1;
+    mech_isa_selected = isa;
+    return 0;
+}
+
+enum mech_isa mech_get_isa()
+{
+    /* the threads that race here all store the same value */
+    if(mech_isa_selected < 0)
+        mech_isa_selected = mech_isa_best();
+    return (enum mech_isa) mech_isa_selected;
+}
+
+int mech_isa_from_string(const char *name, enum mech_isa *isa)
+{
+    int i;
+    if(strcmp(name, "auto") == 0){
+        *isa = mech_isa_best();
+        return 0;
+    }
+    for(i = 0; i < MECH_ISA_COUNT; ++i)
+        if(strcmp(name, mech_isa_names[i]) == 0){
+            *isa = (enum mech_isa) i;
+            return 0;
+        }
+    return 1;
+}
+
+const char *mech_isa_name(enum mech_isa isa)
+{
+    if((int) isa < 0 || isa >= MECH_ISA_COUNT)
+        return "unknown";
+    return mech_isa_names[isa];
+}
+
+void mech_state_NaTs2_t(NrnThread *nt, Mechanism *ml)
+{
+    mech_isa_table[mech_get_isa()]->state_NaTs2_t(nt, ml);
+}
+
+void mech_current_NaTs2_t(NrnThread *nt, Mechanism *ml)
+{
+    mech_isa_table[mech_get_isa()]->current_NaTs2_t(nt, ml);
+}
+
+void mech_state_Ih(NrnThread *nt, Mechanism *ml)
+{
+    mech_isa_table[mech_get_isa()]->state_Ih(nt, ml);
+}
+
+void mech_current_Ih(NrnThread *nt, Mechanism *ml)
+{
+    mech_isa_table[mech_get_isa()]->current_Ih(nt, ml);
+}
+
+void mech_state_ProbAMPANMDA_EMS(NrnThread *nt, Mechanism *ml)
+{
+    mech_isa_table[mech_get_isa()]->state_ProbAMPANMDA_EMS(nt, ml);
+}
+
+void mech_current_ProbAMPANMDA_EMS(NrnThread *nt, Mechanism *ml)
+{
+    mech_isa_table[mech_get_isa()]->current_ProbAMPANMDA_EMS(nt, ml);
+}
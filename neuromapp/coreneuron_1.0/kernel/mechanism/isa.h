@@ -0,0 +1,91 @@
+/*
+ * Neuromapp - isa.h, Copyright (c), 2015,
+ * Timothee Ewart - Swiss Federal Institute of technology in Lausanne,
+ * Pramod Kumbhar - Swiss Federal Institute of technology in Lausanne,
+ * timothee.ewart@epfl.ch,
+ * paramod.kumbhar@epfl.ch
+ * All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+
+/**
+ * @file neuromapp/coreneuron_1.0/kernel/mechanism/isa.h
+ * \brief Selection of the instruction set of the mechanism kernels
+ *
+ * The kernels of NaTs2_t.c, Ih.c and ProbAMPANMDA_EMS.c are compiled once
+ * per instruction set the compiler knows, the symbols suffixed by the
+ * instruction set (MECH_ISA_SUFFIX). The functions of mechanism.h call
+ * the kernels of the instruction set selected, by default the best one
+ * the CPU supports.
+ */
+
+#ifndef MAPP_KERNEL_MECHANISM_ISA_
+#define MAPP_KERNEL_MECHANISM_ISA_
+
+#include "coreneuron_1.0/common/memory/nrnthread.h"
+
+#ifdef __cplusplus
+     extern "C" {
+#endif
+
+/* name of a kernel for the instruction set of the translation unit */
+#ifdef MECH_ISA_SUFFIX
+#define MECH_ISA_CAT_(f, s) f##s
+#define MECH_ISA_CAT(f, s) MECH_ISA_CAT_(f, s)
+#define MECH_ISA(f) MECH_ISA_CAT(f, MECH_ISA_SUFFIX)
+#else
+#define MECH_ISA(f) f
+#endif
+
+/** \enum mech_isa
+    \brief instruction sets of the kernels, from the oldest
+ */
+enum mech_isa {
+    /** the flags of the build */
+    MECH_ISA_BASE,
+    /** SSE4.2 */
+    MECH_ISA_SSE4,
+    /** AVX2 and FMA */
+    MECH_ISA_AVX2,
+    /** AVX-512F */
+    MECH_ISA_AVX512,
+    MECH_ISA_COUNT
+};
+
+/** Non-zero if the kernels are built for the instruction set and the CPU
+    and the OS support it. */
+int mech_isa_supported(enum mech_isa isa);
+
+/** The newest instruction set supported. */
+enum mech_isa mech_isa_best();
+
+/** Select the kernels of an instruction set, return non-zero if it is not
+    supported. */
+int mech_set_isa(enum mech_isa isa);
+
+/** The instruction set of the kernels, mech_isa_best() until mech_set_isa(). */
+enum mech_isa mech_get_isa();
+
+/** Parse base, sse4, avx2, avx512 or auto (the best), return non-zero if unknown. */
+int mech_isa_from_string(const char *name, enum mech_isa *isa);
+
+/** Name of the instruction set. */
+const char *mech_isa_name(enum mech_isa isa);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
@@ -0,0 +1,81 @@
+/*
+ * Neuromapp - Ih.h, Copyright (c), 2015,
+ * Timothee Ewart - Swiss Federal Institute of technology in Lausanne,
+ * Pramod Kumbhar - Swiss Federal Institute of technology in Lausanne,
+ * timothee.ewart@epfl.ch,
+ * paramod.kumbhar@epfl.ch
+ * All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+
+/**
+ * @file neuromapp/coreneuron_1.0/kernel/mechanism/template/Ih.h
+ * \brief Templated kernels of the Ih channel, the computation of Ih.c
+ */
+
+#ifndef MAPP_MECHANISM_IH_H_
+#define MAPP_MECHANISM_IH_H_
+
+#include <cmath>
+
+#include "coreneuron_1.0/kernel/mechanism/template/framework.h"
+
+namespace mechanism {
+
+/** \struct Ih
+    \brief descriptor of the Ih channel: sizes and fields, no pdata
+ */
+struct Ih {
+    enum { type = 69, szp = 6, szdp = 0, width = NRN_SOA_PAD };
+    enum field { gIhbar, m, gIh, Dm, v_unused, g_unused };
+    struct state;
+    struct current;
+};
+
+struct Ih::state {
+    typedef Ih descriptor;
+    typedef none next;
+    static void body(const view &x, int i) {
+        const double dt = 0.1;
+        double &m = x.field<Ih::m>(i);
+        double lv = x.v[x.ni[i]];
+
+        if(lv == - 154.9)
+            lv = lv + 0.0001;
+
+        double mAlpha = 0.001 * 6.43 * (lv + 154.9) / (std::exp((lv + 154.9) / 11.9) - 1.0);
+        double mBeta = 0.001 * 193.0 * std::exp(lv / 33.1);
+        double mInf = mAlpha / (mAlpha + mBeta);
+        double mTau = 1.0 / (mAlpha + mBeta);
+        m = m + (1.-std::exp(dt*((-1.0)/mTau)))*(-(mInf/mTau)/((-1.0)/mTau)-m);
+    }
+};
+
+struct Ih::current {
+    typedef Ih descriptor;
+    typedef none next;
+    static void body(const view &x, int i) {
+        const double ehcn = -45;
+        int nd = x.ni[i];
+        double g = x.field<Ih::gIhbar>(i) * x.field<Ih::m>(i);
+        double ihcn = g * (x.v[nd] - ehcn);
+        x.rhs[nd] -= ihcn;
+        x.d[nd] += g;
+    }
+};
+
+} // end namespace
+
+#endif
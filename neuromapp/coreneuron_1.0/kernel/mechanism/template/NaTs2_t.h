@@ -0,0 +1,99 @@
+/*
+ * Neuromapp - NaTs2_t.h, Copyright (c), 2015,
+ * Timothee Ewart - Swiss Federal Institute of technology in Lausanne,
+ * Pramod Kumbhar - Swiss Federal Institute of technology in Lausanne,
+ * timothee.ewart@epfl.ch,
+ * paramod.kumbhar@epfl.ch
+ * All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+
+/**
+ * @file neuromapp/coreneuron_1.0/kernel/mechanism/template/NaTs2_t.h
+ * \brief Templated kernels of the NaTs2_t channel, the computation of NaTs2_t.c
+ */
+
+#ifndef MAPP_MECHANISM_NATS2_T_H_
+#define MAPP_MECHANISM_NATS2_T_H_
+
+#include <cmath>
+
+#include "coreneuron_1.0/kernel/mechanism/template/framework.h"
+
+namespace mechanism {
+
+/** \struct NaTs2_t
+    \brief descriptor of the NaTs2_t channel: sizes, fields and pdata
+ */
+struct NaTs2_t {
+    enum { type = 125, szp = 8, szdp = 3, width = NRN_SOA_PAD };
+    enum field { gNaTs2_tbar, m, h, ena, Dm, Dh, v_unused, g_unused };
+    enum pdata { ion_ena, ion_ina, ion_dinadv };
+    struct state;
+    struct current;
+};
+
+struct NaTs2_t::state {
+    typedef NaTs2_t descriptor;
+    typedef none next;
+    static void body(const view &x, int i) {
+        const double dt = 0.001;
+        double &m = x.field<NaTs2_t::m>(i);
+        double &h = x.field<NaTs2_t::h>(i);
+        double lqt = 2.952882641412121;
+        double lv = x.v[x.ni[i]];
+        x.field<NaTs2_t::ena>(i) = x.pointer<NaTs2_t::ion_ena>(i);
+
+        if(lv == - 32.0)
+            lv = lv + 0.0001;
+
+        double mAlpha = (0.182 * (lv - - 32.0)) / (1.0 - (std::exp(- (lv - - 32.0) / 6.0)));
+        double mBeta = (0.124 * (- lv - 32.0)) / (1.0 - (std::exp(- (- lv - 32.0) / 6.0)));
+        double mInf = mAlpha / (mAlpha + mBeta);
+        double mTau = (1.0 / (mAlpha + mBeta)) / lqt;
+        m = m + (1. - std::exp(dt*((- 1.0) / mTau)))*(- (mInf / mTau) / ((- 1.0) / mTau) - m);
+
+        if(lv == - 60.0)
+            lv = lv + 0.0001;
+
+        double hAlpha = (- 0.015 * (lv - - 60.0)) / (1.0 - (std::exp((lv - - 60.0) / 6.0)));
+        double hBeta = (- 0.015 * (- lv - 60.0)) / (1.0 - (std::exp((- lv - 60.0) / 6.0)));
+        double hInf = hAlpha / (hAlpha + hBeta);
+        double hTau = (1.0 / (hAlpha + hBeta)) / lqt;
+        h = h + (1. - std::exp(dt*((- 1.0) / hTau)))*(- (hInf / hTau) / ((- 1.0) / hTau) - h);
+    }
+};
+
+struct NaTs2_t::current {
+    typedef NaTs2_t descriptor;
+    typedef none next;
+    static void body(const view &x, int i) {
+        int nd = x.ni[i];
+        double v = x.v[nd];
+        double m = x.field<NaTs2_t::m>(i);
+        double &ena = x.field<NaTs2_t::ena>(i);
+        ena = x.pointer<NaTs2_t::ion_ena>(i);
+        double g = x.field<NaTs2_t::gNaTs2_tbar>(i) * m * m * m * x.field<NaTs2_t::h>(i);
+        double ina = g * (v - ena);
+        x.pointer<NaTs2_t::ion_dinadv>(i) += g;
+        x.pointer<NaTs2_t::ion_ina>(i) += ina;
+        x.rhs[nd] -= ina;
+        x.d[nd] += g;
+    }
+};
+
+} // end namespace
+
+#endif
@@ -0,0 +1,86 @@
+/*
+ * Neuromapp - ProbAMPANMDA_EMS.h, Copyright (c), 2015,
+ * Timothee Ewart - Swiss Federal Institute of technology in Lausanne,
+ * Pramod Kumbhar - Swiss Federal Institute of technology in Lausanne,
+ * timothee.ewart@epfl.ch,
+ * paramod.kumbhar@epfl.ch
+ * All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+
+/**
+ * @file neuromapp/coreneuron_1.0/kernel/mechanism/template/ProbAMPANMDA_EMS.h
+ * \brief Templated kernels of the ProbAMPANMDA_EMS synapse, the computation
+ * of ProbAMPANMDA_EMS.c
+ */
+
+#ifndef MAPP_MECHANISM_PROBAMPANMDA_EMS_H_
+#define MAPP_MECHANISM_PROBAMPANMDA_EMS_H_
+
+#include <cmath>
+
+#include "coreneuron_1.0/kernel/mechanism/template/framework.h"
+
+namespace mechanism {
+
+/** \struct ProbAMPANMDA_EMS
+    \brief descriptor of the ProbAMPANMDA_EMS synapse: sizes, fields and pdata
+ */
+struct ProbAMPANMDA_EMS {
+    enum { type = 134, szp = 37, szdp = 3, width = NRN_SOA_PAD };
+    enum field { tau_r_AMPA, tau_d_AMPA, tau_r_NMDA, tau_d_NMDA, Use, Dep, Fac, e, mg, u0,
+                 synapseID, verboseLevel, NMDA_ratio, A_AMPA_step, B_AMPA_step, A_NMDA_step,
+                 B_NMDA_step, Rstate, tsyn_fac, u, A_AMPA, B_AMPA, A_NMDA, B_NMDA, i_AMPA,
+                 i_NMDA, g_NMDA, factor_AMPA, factor_NMDA, mggate, DA_AMPA, DB_AMPA, DA_NMDA,
+                 DB_NMDA, v_unused, g_unused, tsav };
+    enum pdata { nd_area, pnt, rng };
+    struct state;
+    struct current;
+};
+
+struct ProbAMPANMDA_EMS::state {
+    typedef ProbAMPANMDA_EMS descriptor;
+    typedef none next;
+    static void body(const view &x, int i) {
+        x.field<ProbAMPANMDA_EMS::A_AMPA>(i) *= x.field<ProbAMPANMDA_EMS::A_AMPA_step>(i);
+        x.field<ProbAMPANMDA_EMS::B_AMPA>(i) *= x.field<ProbAMPANMDA_EMS::B_AMPA_step>(i);
+        x.field<ProbAMPANMDA_EMS::A_NMDA>(i) *= x.field<ProbAMPANMDA_EMS::A_NMDA_step>(i);
+        x.field<ProbAMPANMDA_EMS::B_NMDA>(i) *= x.field<ProbAMPANMDA_EMS::B_NMDA_step>(i);
+    }
+};
+
+/** the currents go to the shadow vectors, then to the matrix */
+struct ProbAMPANMDA_EMS::current {
+    typedef ProbAMPANMDA_EMS descriptor;
+    typedef shadow_scatter next;
+    static void body(const view &x, int i) {
+        typedef ProbAMPANMDA_EMS P;
+        const double gmax = 0.001;
+        double mfact = 1.e2/(x.pointer<P::nd_area>(i));
+        double vv = x.v[x.ni[i]];
+        double mggate = 1.0 / (1.0 + std::exp(0.062 * - (vv)) * (x.field<P::mg>(i) / 3.57));
+        double g_AMPA = gmax * (x.field<P::B_AMPA>(i) - x.field<P::A_AMPA>(i));
+        double g_NMDA = gmax * (x.field<P::B_NMDA>(i) - x.field<P::A_NMDA>(i)) * mggate;
+        double vve = (vv - x.field<P::e>(i));
+        double li = g_AMPA * vve + g_NMDA * vve;
+        /* as the C kernel, the conductance is not added to d */
+        x.shadow_rhs[i] = li * mfact;
+        x.shadow_d[i] = 0.0 * mfact;
+    }
+};
+
+} // end namespace
+
+#endif
@@ -0,0 +1,155 @@
+/*
+ * Neuromapp - framework.h, Copyright (c), 2015,
+ * Timothee Ewart - Swiss Federal Institute of technology in Lausanne,
+ * Pramod Kumbhar - Swiss Federal Institute of technology in Lausanne,
+ * timothee.ewart@epfl.ch,
+ * paramod.kumbhar@epfl.ch
+ * All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+
+/**
+ * @file neuromapp/coreneuron_1.0/kernel/mechanism/template/framework.h
+ * \brief Loops of the templated mechanism kernels, in blocks of a
+ * compile-time width
+ */
+
+#ifndef MAPP_MECHANISM_FRAMEWORK_H_
+#define MAPP_MECHANISM_FRAMEWORK_H_
+
+extern "C" {
+#include "coreneuron_1.0/common/memory/nrnthread.h"
+#include "coreneuron_1.0/common/memory/memory.h"
+}
+#include "coreneuron_1.0/common/util/vectorizer.h"
+
+namespace mechanism {
+
+/** \struct view
+    \brief the arrays a kernel works on, the fields and the pdata of an
+    instance are nodecount apart
+ */
+struct view {
+    double *p;
+    int *ppvar;
+    const int *ni;
+    int cnt;
+    double *v;
+    double *rhs;
+    double *d;
+    double *data;
+    double *shadow_rhs;
+    double *shadow_d;
+
+    view(NrnThread *nt, Mechanism *ml) : p(ml->data), ppvar(ml->pdata), ni(ml->nodeindices),
+        cnt(ml->nodecount), v(nt->_actual_v), rhs(nt->_actual_rhs), d(nt->_actual_d),
+        data(nt->_data), shadow_rhs(nt->_shadow_rhs), shadow_d(nt->_shadow_d) {}
+
+    /** the field F of the instance i, F the enum of the descriptor */
+    template<int F>
+    double &field(int i) const { return p[F*cnt + i]; }
+
+    /** the double the pdata S of the instance i points to */
+    template<int S>
+    double &pointer(int i) const { return data[ppvar[S*cnt + i]]; }
+};
+
+/** \struct none
+    \brief no kernel, ends the phases of a kernel
+ */
+struct none {};
+
+/** \struct block
+    \brief W instances from i, a loop of compile-time trip count
+ */
+template<class K, int W>
+struct block {
+    static void run(const view &x, int i) {
+        _PRAGMA_FOR_VECTOR_LOOP_
+        for(int j = 0; j < W; ++j)
+            K::body(x, i + j);
+    }
+};
+
+/** \struct tail
+    \brief the last r < 2W instances from i: one block of every power of
+    two of r, all unrolled
+ */
+template<class K, int W>
+struct tail {
+    static void run(const view &x, int i, int r) {
+        if(r >= W){
+            block<K, W>::run(x, i);
+            i += W;
+            r -= W;
+        }
+        tail<K, W/2>::run(x, i, r);
+    }
+};
+
+template<class K>
+struct tail<K, 0> {
+    static void run(const view &, int, int) {}
+};
+
+/** \fn void loop(const view &x)
+    \brief every instance, in blocks of W, W a power of two
+ */
+template<class K, int W>
+inline void loop(const view &x) {
+    int i = 0;
+    for(; i + W <= x.cnt; i += W)
+        block<K, W>::run(x, i);
+    tail<K, W/2>::run(x, i, x.cnt - i);
+}
+
+/** \struct phase
+    \brief a kernel, then the kernel K::next after all the instances
+ */
+template<class K, int W>
+struct phase {
+    static void run(const view &x) {
+        loop<K, W>(x);
+        phase<typename K::next, W>::run(x);
+    }
+};
+
+template<int W>
+struct phase<none, W> {
+    static void run(const view &) {}
+};
+
+/** \struct shadow_scatter
+    \brief adds the shadow vectors to the matrix, in the order of the
+    instances as several may share a compartment
+ */
+struct shadow_scatter {
+    typedef none next;
+    static void body(const view &x, int i) {
+        x.rhs[x.ni[i]] -= x.shadow_rhs[i];
+        x.d[x.ni[i]] += x.shadow_d[i];
+    }
+};
+
+/** \fn void compute(NrnThread *nt, Mechanism *ml)
+    \brief the kernel K on blocks of W instances, instantiated in kernels.cpp
+    for the widths 1, 2, 4 and 8
+ */
+template<class K, int W>
+void compute(NrnThread *nt, Mechanism *ml);
+
+} // end namespace
+
+#endif
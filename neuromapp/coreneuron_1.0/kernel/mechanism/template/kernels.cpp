@@ -0,0 +1,87 @@
+/*
+ * Neuromapp - kernels.cpp, Copyright (c), 2015,
+ * Timothee Ewart - Swiss Federal Institute of technology in Lausanne,
+ * Pramod Kumbhar - Swiss Federal Institute of technology in Lausanne,
+ * timothee.ewart@epfl.ch,
+ * paramod.kumbhar@epfl.ch
+ * All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+
+/**
+ * @file neuromapp/coreneuron_1.0/kernel/mechanism/template/kernels.cpp
+ * \brief Instantiations of the templated mechanism kernels
+ */
+
+#include <cstring>
+
+#include "coreneuron_1.0/kernel/mechanism/template/kernels.h"
+#include "coreneuron_1.0/kernel/mechanism/template/NaTs2_t.h"
+#include "coreneuron_1.0/kernel/mechanism/template/Ih.h"
+#include "coreneuron_1.0/kernel/mechanism/template/ProbAMPANMDA_EMS.h"
+
+namespace mechanism {
+
+template<class K, int W>
+void compute(NrnThread *nt, Mechanism *ml) {
+    phase<K, W>::run(view(nt, ml));
+}
+
+/** \fn mech_kernel select(int width)
+    \brief the instantiation of K for the width, 0 for the one of its descriptor
+ */
+template<class K>
+mech_kernel select(int width) {
+    switch(width == 0 ? (int) K::descriptor::width : width){
+        case 1: return compute<K, 1>;
+        case 2: return compute<K, 2>;
+        case 4: return compute<K, 4>;
+        case 8: return compute<K, 8>;
+        default: return NULL;
+    }
+}
+
+} // end namespace
+
+#define MECH_INSTANTIATE(K) \
+    template void mechanism::compute<K, 1>(NrnThread *, Mechanism *); \
+    template void mechanism::compute<K, 2>(NrnThread *, Mechanism *); \
+    template void mechanism::compute<K, 4>(NrnThread *, Mechanism *); \
+    template void mechanism::compute<K, 8>(NrnThread *, Mechanism *);
+
+MECH_INSTANTIATE(mechanism::NaTs2_t::state)
+MECH_INSTANTIATE(mechanism::NaTs2_t::current)
+MECH_INSTANTIATE(mechanism::Ih::state)
+MECH_INSTANTIATE(mechanism::Ih::current)
+MECH_INSTANTIATE(mechanism::ProbAMPANMDA_EMS::state)
+MECH_INSTANTIATE(mechanism::ProbAMPANMDA_EMS::current)
+
+#undef MECH_INSTANTIATE
+
+mech_kernel mech_template_kernel(const char *m, const char *f, int width) {
+    bool state = std::strncmp(f, "state", 5) == 0;
+    if(!state && std::strncmp(f, "current", 7) != 0)
+        return NULL;
+    if(std::strncmp(m, "Na", 2) == 0)
+        return state ? mechanism::select<mechanism::NaTs2_t::state>(width)
+                     : mechanism::select<mechanism::NaTs2_t::current>(width);
+    if(std::strncmp(m, "Ih", 3) == 0)
+        return state ? mechanism::select<mechanism::Ih::state>(width)
+                     : mechanism::select<mechanism::Ih::current>(width);
+    if(std::strncmp(m, "ProbAMPANMDA", 12) == 0)
+        return state ? mechanism::select<mechanism::ProbAMPANMDA_EMS::state>(width)
+                     : mechanism::select<mechanism::ProbAMPANMDA_EMS::current>(width);
+    return NULL;
+}
@@ -0,0 +1,54 @@
+/*
+ * Neuromapp - kernels.h, Copyright (c), 2015,
+ * Timothee Ewart - Swiss Federal Institute of technology in Lausanne,
+ * Pramod Kumbhar - Swiss Federal Institute of technology in Lausanne,
+ * timothee.ewart@epfl.ch,
+ * paramod.kumbhar@epfl.ch
+ * All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+
+/**
+ * @file neuromapp/coreneuron_1.0/kernel/mechanism/template/kernels.h
+ * \brief C interface of the templated mechanism kernels
+ */
+
+#ifndef MAPP_MECHANISM_KERNELS_
+#define MAPP_MECHANISM_KERNELS_
+
+#include "coreneuron_1.0/common/memory/nrnthread.h"
+
+#ifdef __cplusplus
+     extern "C" {
+#endif
+
+/** signature of the kernels, the C ones of mechanism.h and the templated ones */
+typedef void (*mech_kernel)(NrnThread *nt, Mechanism *ml);
+
+/** \fn mech_kernel mech_template_kernel(const char *mechanism, const char *function, int width)
+    \brief the templated kernel of a mechanism
+    \param mechanism Na, Ih or ProbAMPANMDA
+    \param function state or current
+    \param width instances per block, 1, 2, 4 or 8, 0 for the width of the
+    descriptor of the mechanism
+    \return NULL if the mechanism, the function or the width is unknown
+ */
+mech_kernel mech_template_kernel(const char *mechanism, const char *function, int width);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
@@ -0,0 +1,104 @@
+/*
+ * Neuromapp - main.cpp, Copyright (c), 2015,
+ * Timothee Ewart - Swiss Federal Institute of technology in Lausanne,
+ * Pramod Kumbhar - Swiss Federal Institute of technology in Lausanne,
+ * timothee.ewart@epfl.ch,
+ * paramod.kumbhar@epfl.ch
+ * All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+
+/**
+ * @file neuromapp/coreneuron_1.0/kernel/nmodl/main.cpp
+ * \brief The generator run by the build:
+ *
+ *     coreneuron10_nmodl kernel file.mod file.c
+ *     coreneuron10_nmodl registry registry.c [file.mod type]...
+ */
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#include "coreneuron_1.0/kernel/nmodl/nmodl.h"
+
+namespace {
+
+int usage() {
+    std::cerr << "Usage: coreneuron10_nmodl kernel [file.mod] [file.c]\n"
+              << "       coreneuron10_nmodl registry [file.c] [file.mod] [type] ...\n"
+              << "Details: \n"
+              << "                 kernel [the kernels of the mechanism of file.mod, to file.c] \n"
+              << "                 registry [the table of the mechanisms of registry.h, type their type in the data sets] \n";
+    return 1;
+}
+
+nmodl::model read(const std::string &path) {
+    std::ifstream in(path.c_str());
+    if (!in)
+        throw nmodl::error(0, "cannot be read");
+    return nmodl::parse(in);
+}
+
+/** writes the file only once it is complete, the build does not see half a file */
+bool write(const std::string &path, const std::string &text) {
+    std::ofstream out(path.c_str());
+    out << text;
+    return !out.fail();
+}
+
+} // end namespace
+
+int main(int argc, char *argv[]) {
+    if (argc < 3)
+        return usage();
+
+    std::string command(argv[1]);
+    std::string source;
+    try {
+        std::ostringstream out;
+        if (command == "kernel" && argc == 4) {
+            source = argv[2];
+            std::string name = source.substr(source.find_last_of('/') + 1);
+            nmodl::write_kernels(out, read(source), name);
+            if (!write(argv[3], out.str())) {
+                std::cerr << argv[3] << ": cannot be written\n";
+                return 1;
+            }
+        } else if (command == "registry" && argc % 2 == 1) {
+            std::vector<nmodl::model> models;
+            std::vector<int> types;
+            for (int i = 3; i < argc; i += 2) {
+                source = argv[i];
+                models.push_back(read(source));
+                types.push_back(std::atoi(argv[i + 1]));
+            }
+            source = argv[2];
+            nmodl::write_registry(out, models, types);
+            if (!write(argv[2], out.str())) {
+                std::cerr << argv[2] << ": cannot be written\n";
+                return 1;
+            }
+        } else {
+            return usage();
+        }
+    } catch (nmodl::error &e) {
+        std::cerr << source << ":" << e.line() << ": " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
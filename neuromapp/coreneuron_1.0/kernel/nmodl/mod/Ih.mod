@@ -0,0 +1,51 @@
+TITLE Ih, the hyperpolarization activated cation current of kernel/mechanism/Ih.c
+
+NEURON {
+    SUFFIX Ih
+    NONSPECIFIC_CURRENT ihcn
+    RANGE gIhbar, gIh
+}
+
+UNITS {
+    (S) = (siemens)
+    (mV) = (millivolt)
+    (mA) = (milliamp)
+}
+
+PARAMETER {
+    gIhbar = 0.00001 (S/cm2)
+    ehcn = -45.0 (mV)
+}
+
+ASSIGNED {
+    v (mV)
+    ihcn (mA/cm2)
+    gIh (S/cm2)
+    mInf
+    mTau
+    mAlpha
+    mBeta
+}
+
+STATE {
+    m
+}
+
+BREAKPOINT {
+    SOLVE states METHOD cnexp
+    gIh = gIhbar*m
+    ihcn = gIh*(v-ehcn)
+}
+
+DERIVATIVE states {
+    LOCAL lv
+    lv = v
+    if (lv == -154.9) {
+        lv = lv + 0.0001
+    }
+    mAlpha = 0.001*6.43*(lv+154.9)/(exp((lv+154.9)/11.9)-1)
+    mBeta = 0.001*193*exp(lv/33.1)
+    mInf = mAlpha/(mAlpha+mBeta)
+    mTau = 1/(mAlpha+mBeta)
+    m' = (mInf-m)/mTau
+}
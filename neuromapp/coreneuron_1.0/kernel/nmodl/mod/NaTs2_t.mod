@@ -0,0 +1,66 @@
+TITLE NaTs2_t, the fast inactivating sodium current of kernel/mechanism/NaTs2_t.c
+
+NEURON {
+    SUFFIX NaTs2_t
+    USEION na READ ena WRITE ina
+    RANGE gNaTs2_tbar
+}
+
+UNITS {
+    (S) = (siemens)
+    (mV) = (millivolt)
+    (mA) = (milliamp)
+}
+
+PARAMETER {
+    gNaTs2_tbar = 0.00001 (S/cm2)
+}
+
+ASSIGNED {
+    v (mV)
+    ena (mV)
+    ina (mA/cm2)
+    gNaTs2_t (S/cm2)
+    mInf
+    mTau
+    mAlpha
+    mBeta
+    hInf
+    hTau
+    hAlpha
+    hBeta
+}
+
+STATE {
+    m
+    h
+}
+
+BREAKPOINT {
+    SOLVE states METHOD cnexp
+    gNaTs2_t = gNaTs2_tbar*m*m*m*h
+    ina = gNaTs2_t*(v-ena)
+}
+
+DERIVATIVE states {
+    LOCAL qt, lv
+    qt = 2.952882641412121  : 2.3^((34-21)/10)
+    lv = v
+    if (lv == -32) {
+        lv = lv + 0.0001
+    }
+    mAlpha = (0.182*(lv- -32))/(1-(exp(-(lv- -32)/6)))
+    mBeta = (0.124*(-lv-32))/(1-(exp(-(-lv-32)/6)))
+    mInf = mAlpha/(mAlpha+mBeta)
+    mTau = (1/(mAlpha+mBeta))/qt
+    m' = (mInf-m)/mTau
+
+    if (lv == -60) {
+        lv = lv + 0.0001
+    }
+    hAlpha = (-0.015*(lv- -60))/(1-(exp((lv- -60)/6)))
+    hBeta = (-0.015*(-lv-60))/(1-(exp((-lv-60)/6)))
+    hInf = hAlpha/(hAlpha+hBeta)
+    hTau = (1/(hAlpha+hBeta))/qt
+    h' = (hInf-h)/hTau
+}
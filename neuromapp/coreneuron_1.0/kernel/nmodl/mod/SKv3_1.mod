@@ -0,0 +1,47 @@
+TITLE SKv3_1, a fast non inactivating potassium current, the type 71 of bench.101392
+
+COMMENT
+Layout of the data sets: gSKv3_1bar, m, ek, Dm, v and g, the pdata ek, ik
+and dik/dv of the k ion. The conductance and the current are not stored.
+ENDCOMMENT
+
+NEURON {
+    SUFFIX SKv3_1
+    USEION k READ ek WRITE ik
+    RANGE gSKv3_1bar
+}
+
+UNITS {
+    (S) = (siemens)
+    (mV) = (millivolt)
+    (mA) = (milliamp)
+}
+
+PARAMETER {
+    gSKv3_1bar = 0.00001 (S/cm2)
+}
+
+ASSIGNED {
+    v (mV)
+    ek (mV)
+    ik (mA/cm2)
+    gSKv3_1 (S/cm2)
+    mInf
+    mTau (ms)
+}
+
+STATE {
+    m
+}
+
+BREAKPOINT {
+    SOLVE states METHOD cnexp
+    gSKv3_1 = gSKv3_1bar*m
+    ik = gSKv3_1*(v-ek)
+}
+
+DERIVATIVE states {
+    mInf = 1/(1+exp(((v-(18.700))/(-9.700))))
+    mTau = 0.2*20.000/(1+exp(((v-(-46.560))/(-44.140))))
+    m' = (mInf-m)/mTau
+}
@@ -0,0 +1,885 @@
+/*
+ * Neuromapp - nmodl.cpp, Copyright (c), 2015,
+ * Timothee Ewart - Swiss Federal Institute of technology in Lausanne,
+ * Pramod Kumbhar - Swiss Federal Institute of technology in Lausanne,
+ * timothee.ewart@epfl.ch,
+ * paramod.kumbhar@epfl.ch
+ * All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+
+/**
+ * @file neuromapp/coreneuron_1.0/kernel/nmodl/nmodl.cpp
+ * \brief Implements the parser of the NMODL subset and the writers of the
+ * kernels and of the registry
+ */
+
+#include <algorithm>
+#include <cctype>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <sstream>
+
+#include "coreneuron_1.0/kernel/nmodl/nmodl.h"
+
+namespace nmodl {
+
+namespace {
+
+bool contains(const std::vector<std::string> &v, const std::string &s) {
+    return std::find(v.begin(), v.end(), s) != v.end();
+}
+
+/** \fn std::vector<token> tokenize(std::istream &in)
+    \brief the tokens of the description, without the comments (: ? and
+    COMMENT ... ENDCOMMENT), the TITLE line, UNITSOFF and UNITSON
+ */
+std::vector<token> tokenize(std::istream &in) {
+    std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    std::vector<token> tokens;
+    std::size_t i = 0, n = text.size();
+    int line = 1;
+
+    while (i < n) {
+        char c = text[i];
+        if (c == '\n') {
+            ++line;
+            ++i;
+        } else if (std::isspace((unsigned char) c)) {
+            ++i;
+        } else if (c == ':' || c == '?') {
+            while (i < n && text[i] != '\n')
+                ++i;
+        } else if (std::isalpha((unsigned char) c) || c == '_') {
+            std::size_t b = i;
+            while (i < n && (std::isalnum((unsigned char) text[i]) || text[i] == '_'))
+                ++i;
+            std::string word = text.substr(b, i - b);
+            if (word == "COMMENT") {
+                std::size_t e = text.find("ENDCOMMENT", i);
+                if (e == std::string::npos)
+                    throw error(line, "COMMENT without ENDCOMMENT");
+                line += std::count(text.begin() + i, text.begin() + e, '\n');
+                i = e + 10;
+            } else if (word == "TITLE") {
+                while (i < n && text[i] != '\n')
+                    ++i;
+            } else if (word != "UNITSOFF" && word != "UNITSON") {
+                tokens.push_back(token(token::name, word, line));
+            }
+        } else if (std::isdigit((unsigned char) c) || (c == '.' && i + 1 < n && std::isdigit((unsigned char) text[i + 1]))) {
+            std::size_t b = i;
+            while (i < n && (std::isdigit((unsigned char) text[i]) || text[i] == '.'))
+                ++i;
+            if (i < n && (text[i] == 'e' || text[i] == 'E')) {
+                std::size_t j = i + 1;
+                if (j < n && (text[j] == '+' || text[j] == '-'))
+                    ++j;
+                if (j < n && std::isdigit((unsigned char) text[j])) {
+                    i = j;
+                    while (i < n && std::isdigit((unsigned char) text[i]))
+                        ++i;
+                }
+            }
+            tokens.push_back(token(token::number, text.substr(b, i - b), line));
+        } else {
+            std::string two = text.substr(i, 2);
+            if (two == "==" || two == "!=" || two == "<=" || two == ">=" || two == "&&" || two == "||") {
+                tokens.push_back(token(token::punct, two, line));
+                i += 2;
+            } else {
+                tokens.push_back(token(token::punct, std::string(1, c), line));
+                ++i;
+            }
+        }
+    }
+    return tokens;
+}
+
+/** \class parser
+    \brief reads the tokens one by one
+ */
+class parser {
+public:
+    explicit parser(const std::vector<token> &tokens) : tokens_(tokens), i_(0) {}
+
+    bool done() const { return i_ >= tokens_.size(); }
+
+    /** the next token, an empty punctuation at the end */
+    token peek() const {
+        if (done())
+            return token(token::punct, "", line());
+        return tokens_[i_];
+    }
+
+    token next() {
+        token t = peek();
+        if (done())
+            throw error(t.line, "unexpected end of the description");
+        ++i_;
+        return t;
+    }
+
+    /** skips the next token if it is s */
+    bool accept(const std::string &s) {
+        if (done() || tokens_[i_].text != s)
+            return false;
+        ++i_;
+        return true;
+    }
+
+    void expect(const std::string &s) {
+        token t = peek();
+        if (!accept(s))
+            throw error(t.line, "expected '" + s + "' instead of '" + t.text + "'");
+    }
+
+    std::string name() {
+        token t = next();
+        if (t.k != token::name)
+            throw error(t.line, "expected a name instead of '" + t.text + "'");
+        return t.text;
+    }
+
+    /** name (, name)* */
+    std::vector<std::string> names() {
+        std::vector<std::string> v(1, name());
+        while (accept(","))
+            v.push_back(name());
+        return v;
+    }
+
+    /** skips the tokens up to the close matching the open just read */
+    void skip(const std::string &open, const std::string &close) {
+        int depth = 1;
+        while (depth > 0) {
+            token t = next();
+            if (t.text == open)
+                ++depth;
+            else if (t.text == close)
+                --depth;
+        }
+    }
+
+    int line() const {
+        if (tokens_.empty())
+            return 1;
+        return i_ < tokens_.size() ? tokens_[i_].line : tokens_.back().line;
+    }
+
+private:
+    std::vector<token> tokens_;
+    std::size_t i_;
+};
+
+void neuron_block(parser &p, model &m) {
+    p.expect("{");
+    while (!p.accept("}")) {
+        token t = p.next();
+        if (t.text == "SUFFIX") {
+            m.suffix = p.name();
+        } else if (t.text == "USEION") {
+            ion x;
+            x.name = p.name();
+            for (;;) {
+                if (p.accept("READ")) {
+                    std::vector<std::string> v = p.names();
+                    x.read.insert(x.read.end(), v.begin(), v.end());
+                } else if (p.accept("WRITE")) {
+                    std::vector<std::string> v = p.names();
+                    x.write.insert(x.write.end(), v.begin(), v.end());
+                } else if (p.accept("VALENCE")) {
+                    p.accept("-");
+                    p.next();
+                } else {
+                    break;
+                }
+            }
+            for (std::size_t i = 0; i < x.write.size(); ++i)
+                if (x.write[i] != "i" + x.name)
+                    throw error(t.line, "only the current i" + x.name + " can be written to the ion " + x.name);
+            m.ions.push_back(x);
+        } else if (t.text == "NONSPECIFIC_CURRENT") {
+            std::vector<std::string> v = p.names();
+            m.nonspecific.insert(m.nonspecific.end(), v.begin(), v.end());
+        } else if (t.text == "RANGE") {
+            std::vector<std::string> v = p.names();
+            m.range.insert(v.begin(), v.end());
+        } else if (t.text == "GLOBAL") {
+            p.names();
+        } else if (t.text == "THREADSAFE") {
+        } else if (t.text == "POINT_PROCESS" || t.text == "ARTIFICIAL_CELL") {
+            throw error(t.line, t.text + " is not supported, only the density mechanisms (SUFFIX)");
+        } else {
+            throw error(t.line, t.text + " is not supported in the NEURON block");
+        }
+    }
+}
+
+/** PARAMETER, ASSIGNED or STATE: names, values, units and limits */
+void declarations(parser &p, model &m, std::vector<std::string> *names, std::vector<parameter> *parameters) {
+    p.expect("{");
+    while (!p.accept("}")) {
+        token t = p.peek();
+        parameter x;
+        x.name = p.name();
+        if (p.accept("=")) {
+            if (p.accept("-"))
+                x.value = "-";
+            token value = p.next();
+            if (value.k != token::number)
+                throw error(value.line, "the value of " + x.name + " is not a number");
+            x.value += value.text;
+        }
+        if (p.accept("("))
+            p.skip("(", ")");
+        if (p.accept("<"))
+            p.skip("<", ">");
+        if (x.name == "v" || x.name == "dt")
+            continue;
+        if (contains(m.assigned, x.name) || contains(m.states, x.name))
+            throw error(t.line, x.name + " is declared twice");
+        for (std::size_t i = 0; i < m.parameters.size(); ++i)
+            if (m.parameters[i].name == x.name)
+                throw error(t.line, x.name + " is declared twice");
+        if (parameters) {
+            if (x.value.empty())
+                x.value = "0";
+            parameters->push_back(x);
+        } else {
+            names->push_back(x.name);
+        }
+    }
+}
+
+/** if ( condition ) {, the if already read */
+statement condition(parser &p, statement::kind k, int line) {
+    statement s;
+    s.k = k;
+    s.line = line;
+    p.expect("(");
+    int depth = 1;
+    for (;;) {
+        token t = p.next();
+        if (t.text == "(")
+            ++depth;
+        else if (t.text == ")" && --depth == 0)
+            break;
+        s.expression.push_back(t);
+    }
+    p.expect("{");
+    return s;
+}
+
+/** the right hand side, up to the end of the line out of the parentheses */
+std::vector<token> expression(parser &p, int line) {
+    std::vector<token> e;
+    int depth = 0;
+    while (!p.done()) {
+        token t = p.peek();
+        if (depth == 0 && (t.line != line || t.text == "}"))
+            break;
+        if (t.text == "(")
+            ++depth;
+        else if (t.text == ")")
+            --depth;
+        e.push_back(p.next());
+    }
+    if (e.empty())
+        throw error(line, "empty expression");
+    return e;
+}
+
+/** the statements of a block up to its }, solve is the block of SOLVE, NULL out of BREAKPOINT */
+void statements(parser &p, std::vector<statement> &s, std::string *solve) {
+    int depth = 0;
+    p.expect("{");
+    for (;;) {
+        token t = p.next();
+        if (t.text == "}") {
+            if (depth == 0)
+                return;
+            statement st;
+            st.line = t.line;
+            if (p.accept("else")) {
+                if (p.accept("if")) {
+                    st = condition(p, statement::else_if, t.line);
+                } else {
+                    p.expect("{");
+                    st.k = statement::else_;
+                }
+            } else {
+                st.k = statement::end;
+                --depth;
+            }
+            s.push_back(st);
+            continue;
+        }
+        if (t.k != token::name)
+            throw error(t.line, "unexpected '" + t.text + "'");
+        if (t.text == "LOCAL") {
+            std::vector<std::string> v = p.names();
+            for (std::size_t i = 0; i < v.size(); ++i) {
+                statement st;
+                st.k = statement::local;
+                st.name = v[i];
+                st.line = t.line;
+                s.push_back(st);
+            }
+        } else if (t.text == "SOLVE") {
+            if (!solve)
+                throw error(t.line, "SOLVE out of the BREAKPOINT block");
+            *solve = p.name();
+            p.expect("METHOD");
+            std::string method = p.name();
+            if (method != "cnexp")
+                throw error(t.line, "METHOD " + method + " is not supported, only cnexp");
+        } else if (t.text == "if") {
+            s.push_back(condition(p, statement::if_, t.line));
+            ++depth;
+        } else {
+            statement st;
+            st.line = t.line;
+            st.name = t.text;
+            st.k = p.accept("'") ? statement::ode : statement::assign;
+            if (p.peek().text != "=")
+                throw error(t.line, t.text + " is not supported");
+            p.expect("=");
+            st.expression = expression(p, t.line);
+            s.push_back(st);
+        }
+    }
+}
+
+/** \class translator
+    \brief the C of the names and of the expressions of a block
+ */
+class translator {
+public:
+    translator(const model &m, const std::vector<statement> &block) : m_(m), fields_(m.fields()) {
+        for (std::size_t i = 0; i < m.parameters.size(); ++i)
+            if (!m.range.count(m.parameters[i].name))
+                constants_[m.parameters[i].name] = m.parameters[i].value;
+        for (std::size_t i = 0; i < m.assigned.size(); ++i)
+            if (!contains(fields_, m.assigned[i]))
+                locals_.insert(m.assigned[i]);
+        for (std::size_t i = 0; i < block.size(); ++i)
+            if (block[i].k == statement::local) {
+                if (contains(fields_, block[i].name) || constants_.count(block[i].name))
+                    throw error(block[i].line, "LOCAL " + block[i].name + " hides a declaration");
+                locals_.insert(block[i].name);
+            }
+    }
+
+    std::string name(const std::string &n, int line) {
+        if (n == "v") {
+            used_.insert("v");
+            return "v";
+        }
+        if (n == "dt") {
+            used_.insert("dt");
+            return "_dt";
+        }
+        if (contains(fields_, n))
+            return n;
+        if (constants_.count(n) || locals_.count(n)) {
+            used_.insert(n);
+            return constants_.count(n) ? n : "_l" + n;
+        }
+        throw error(line, n + " is not declared");
+    }
+
+    /** the variable of an assignment or of an ODE */
+    std::string target(const statement &s) {
+        if (s.k == statement::ode && !contains(m_.states, s.name))
+            throw error(s.line, s.name + "' but " + s.name + " is not a STATE");
+        if (s.name == "v" || s.name == "dt" || constants_.count(s.name))
+            throw error(s.line, s.name + " cannot be assigned");
+        return name(s.name, s.line);
+    }
+
+    /** the expression, the state x replaced by value if x is not empty */
+    std::string expression(const std::vector<token> &e, const std::string &x = "", const std::string &value = "") {
+        std::ostringstream out;
+        for (std::size_t i = 0; i < e.size(); ++i) {
+            const token &t = e[i];
+            if (i > 0)
+                out << " ";
+            if (t.k == token::number) {
+                out << t.text;
+                if (t.text.find_first_of(".eE") == std::string::npos)
+                    out << ".0";
+            } else if (t.k == token::name && i + 1 < e.size() && e[i + 1].text == "(") {
+                static const char *functions[] = {"exp", "log", "log10", "sqrt", "fabs", "pow", "sin", "cos", "tanh"};
+                if (std::find(functions, functions + 9, t.text) == functions + 9)
+                    throw error(t.line, "the function " + t.text + " is not supported");
+                out << t.text;
+            } else if (t.k == token::name) {
+                out << (t.text == x ? value : name(t.text, t.line));
+            } else if (t.text == "^") {
+                throw error(t.line, "^ is not supported, use pow()");
+            } else {
+                out << t.text;
+            }
+        }
+        return out.str();
+    }
+
+    bool uses(const std::string &n) const { return used_.count(n) != 0; }
+
+    const std::vector<std::string> &states() const { return m_.states; }
+
+    /** the constants and locals used, as C declarations */
+    std::string constants(const std::string &indent) const {
+        std::ostringstream out;
+        for (std::map<std::string, std::string>::const_iterator it = constants_.begin(); it != constants_.end(); ++it)
+            if (used_.count(it->first))
+                out << indent << "const double " << it->first << " = " << it->second << ";\n";
+        if (used_.count("dt"))
+            out << indent << "const double _dt = _nt->dt;\n";
+        return out.str();
+    }
+
+    std::string locals(const std::string &indent) const {
+        std::ostringstream out;
+        std::string sep = "double ";
+        for (std::set<std::string>::const_iterator it = locals_.begin(); it != locals_.end(); ++it)
+            if (used_.count(*it)) {
+                out << sep << "_l" << *it;
+                sep = ", ";
+            }
+        return out.str().empty() ? "" : indent + out.str() + ";\n";
+    }
+
+private:
+    const model &m_;
+    std::vector<std::string> fields_;
+    std::map<std::string, std::string> constants_;
+    std::set<std::string> locals_;
+    std::set<std::string> used_;
+};
+
+/** \class degree
+    \brief the degree of an expression in a state x: 0, 1, or 2 for any
+    other dependence, e.g. x*x, 1/x, exp(x) or a LOCAL computed from x
+ */
+class degree {
+public:
+    degree(const std::vector<token> &e, const std::string &x, const std::set<std::string> &through)
+        : e_(e), x_(x), through_(through), i_(0) {}
+
+    int of() {
+        int d = logical();
+        if (i_ < e_.size())
+            throw error(e_[i_].line, "unexpected '" + e_[i_].text + "'");
+        return d;
+    }
+
+private:
+    bool accept(const char *s) {
+        if (i_ < e_.size() && e_[i_].k == token::punct && e_[i_].text == s) {
+            ++i_;
+            return true;
+        }
+        return false;
+    }
+
+    /** the comparisons and the logical operators */
+    int logical() {
+        int d = sum();
+        while (accept("<") || accept(">") || accept("<=") || accept(">=") || accept("==")
+               || accept("!=") || accept("&&") || accept("||"))
+            d = (sum() || d) ? 2 : 0;
+        return d;
+    }
+
+    int sum() {
+        int d = product();
+        while (accept("+") || accept("-"))
+            d = std::max(d, product());
+        return d;
+    }
+
+    int product() {
+        int d = unary();
+        for (;;) {
+            if (accept("*"))
+                d = std::min(d + unary(), 2);
+            else if (accept("/"))
+                d = unary() ? 2 : d;
+            else
+                return d;
+        }
+    }
+
+    int unary() {
+        if (accept("-") || accept("+"))
+            return unary();
+        if (accept("!"))
+            return unary() ? 2 : 0;
+        return primary();
+    }
+
+    int primary() {
+        if (i_ >= e_.size())
+            throw error(e_.back().line, "incomplete expression");
+        const token &t = e_[i_++];
+        if (t.text == "(") {
+            int d = logical();
+            if (!accept(")"))
+                throw error(t.line, "expected ')'");
+            return d;
+        }
+        if (t.k == token::name && accept("(")) {
+            int d = 0;
+            if (!accept(")")) {
+                do {
+                    d = std::max(d, logical());
+                } while (accept(","));
+                if (!accept(")"))
+                    throw error(t.line, "expected ')'");
+            }
+            return d ? 2 : 0;
+        }
+        if (t.k == token::name)
+            return t.text == x_ ? 1 : (through_.count(t.text) ? 2 : 0);
+        if (t.k == token::number)
+            return 0;
+        throw error(t.line, "unexpected '" + t.text + "'");
+    }
+
+    const std::vector<token> &e_;
+    const std::string &x_;
+    const std::set<std::string> &through_;
+    std::size_t i_;
+};
+
+/** the statements of a block, in the loop of a kernel */
+std::string body(const std::vector<statement> &s, translator &tr, bool &odes) {
+    std::ostringstream out;
+    std::string indent(8, ' ');
+    /* the states each variable assigned in the block is computed from */
+    std::map<std::string, std::set<std::string> > from;
+    for (std::size_t i = 0; i < s.size(); ++i) {
+        const statement &st = s[i];
+        switch (st.k) {
+            case statement::local:
+                break;
+            case statement::assign: {
+                std::set<std::string> states;
+                for (std::size_t j = 0; j < st.expression.size(); ++j) {
+                    const std::string &n = st.expression[j].text;
+                    if (contains(tr.states(), n))
+                        states.insert(n);
+                    if (from.count(n))
+                        states.insert(from[n].begin(), from[n].end());
+                }
+                from[st.name] = states;
+                out << indent << tr.target(st) << " = " << tr.expression(st.expression) << " ;\n";
+                break;
+            }
+            case statement::ode: {
+                /* cnexp, x' = a + b x is x(t+dt) = x + (1 - exp(b dt)) (- a/b - x),
+                   x + a dt if b = 0 */
+                std::string x = tr.target(st);
+                std::set<std::string> through;
+                for (std::map<std::string, std::set<std::string> >::const_iterator it = from.begin(); it != from.end(); ++it)
+                    if (it->second.count(st.name))
+                        through.insert(it->first);
+                int d = degree(st.expression, st.name, through).of();
+                if (d > 1)
+                    throw error(st.line, st.name + "' is not linear in " + st.name
+                                + ", METHOD cnexp needs " + st.name + "' = a + b*" + st.name);
+                tr.name("dt", st.line);
+                if (d == 0) {
+                    out << indent << x << " = " << x << " + _dt * ( " << tr.expression(st.expression) << " ) ;\n";
+                    break;
+                }
+                out << indent << "_a = " << tr.expression(st.expression, st.name, "0.0") << " ;\n";
+                out << indent << "_b = " << tr.expression(st.expression, st.name, "1.0") << " - _a ;\n";
+                out << indent << x << " = " << x << " + (_b == 0. ? _dt * _a : (1. - exp(_dt * _b)) * (- _a / _b - "
+                    << x << ")) ;\n";
+                odes = true;
+                break;
+            }
+            case statement::if_:
+                out << indent << "if ( " << tr.expression(st.expression) << " ) {\n";
+                indent += "    ";
+                break;
+            case statement::else_if:
+                indent.resize(indent.size() - 4);
+                out << indent << "} else if ( " << tr.expression(st.expression) << " ) {\n";
+                indent += "    ";
+                break;
+            case statement::else_:
+                indent.resize(indent.size() - 4);
+                out << indent << "} else {\n";
+                indent += "    ";
+                break;
+            case statement::end:
+                indent.resize(indent.size() - 4);
+                out << indent << "}\n";
+                break;
+        }
+    }
+    return out.str();
+}
+
+/** the first lines of a kernel: the arrays */
+void arrays(std::ostream &out, const model &m, bool nodes, bool matrix) {
+    out << "    int _iml;\n";
+    out << "    int _cntml = _ml->nodecount;\n";
+    out << "    double * restrict _p = _ml->data;\n";
+    if (!m.pdata().empty()) {
+        out << "    int * restrict _ppvar = _ml->pdata;\n";
+        out << "    double * restrict _nt_data = _nt->_data;\n";
+    }
+    if (nodes) {
+        out << "    int * restrict _ni = _ml->nodeindices;\n";
+        out << "    double * restrict _vec_v = _nt->_actual_v;\n";
+    }
+    if (matrix) {
+        out << "    double * restrict _vec_rhs = _nt->_actual_rhs;\n";
+        out << "    double * restrict _vec_d = _nt->_actual_d;\n";
+    }
+}
+
+/** the variables read from the ions, to their fields */
+void ion_reads(std::ostream &out, const model &m) {
+    for (std::size_t i = 0; i < m.ions.size(); ++i)
+        for (std::size_t j = 0; j < m.ions[i].read.size(); ++j)
+            out << "        " << m.ions[i].read[j] << " = _ion_" << m.ions[i].read[j] << ";\n";
+}
+
+} // end namespace
+
+std::vector<std::string> model::fields() const {
+    std::vector<std::string> f;
+    for (std::size_t i = 0; i < parameters.size(); ++i)
+        if (range.count(parameters[i].name))
+            f.push_back(parameters[i].name);
+    f.insert(f.end(), states.begin(), states.end());
+    for (std::size_t i = 0; i < assigned.size(); ++i)
+        if (range.count(assigned[i]))
+            f.push_back(assigned[i]);
+    for (std::size_t i = 0; i < ions.size(); ++i)
+        for (std::size_t j = 0; j < ions[i].read.size(); ++j)
+            if (!contains(f, ions[i].read[j]))
+                f.push_back(ions[i].read[j]);
+    for (std::size_t i = 0; i < states.size(); ++i)
+        f.push_back("D" + states[i]);
+    f.push_back("_v_unused");
+    f.push_back("_g_unused");
+    return f;
+}
+
+std::vector<std::string> model::pdata() const {
+    std::vector<std::string> p;
+    for (std::size_t i = 0; i < ions.size(); ++i) {
+        for (std::size_t j = 0; j < ions[i].read.size(); ++j)
+            p.push_back("_ion_" + ions[i].read[j]);
+        for (std::size_t j = 0; j < ions[i].write.size(); ++j)
+            p.push_back("_ion_" + ions[i].write[j]);
+        for (std::size_t j = 0; j < ions[i].write.size(); ++j)
+            p.push_back("_ion_d" + ions[i].write[j] + "dv");
+    }
+    return p;
+}
+
+std::vector<std::string> model::currents() const {
+    std::vector<std::string> c(nonspecific);
+    for (std::size_t i = 0; i < ions.size(); ++i)
+        c.insert(c.end(), ions[i].write.begin(), ions[i].write.end());
+    return c;
+}
+
+model parse(std::istream &in) {
+    parser p(tokenize(in));
+    model m;
+    std::string solve, derivative;
+
+    while (!p.done()) {
+        token t = p.next();
+        if (t.text == "NEURON") {
+            neuron_block(p, m);
+        } else if (t.text == "UNITS" || t.text == "INITIAL" || t.text == "INDEPENDENT") {
+            p.expect("{");
+            p.skip("{", "}");
+        } else if (t.text == "PARAMETER") {
+            declarations(p, m, NULL, &m.parameters);
+        } else if (t.text == "ASSIGNED") {
+            declarations(p, m, &m.assigned, NULL);
+        } else if (t.text == "STATE") {
+            declarations(p, m, &m.states, NULL);
+        } else if (t.text == "BREAKPOINT") {
+            statements(p, m.breakpoint, &solve);
+        } else if (t.text == "DERIVATIVE") {
+            if (!derivative.empty())
+                throw error(t.line, "only one DERIVATIVE block is supported");
+            derivative = p.name();
+            statements(p, m.derivative, NULL);
+        } else {
+            throw error(t.line, t.text + " is not supported");
+        }
+    }
+
+    int line = p.line();
+    for (std::size_t i = 0; i < m.breakpoint.size(); ++i)
+        if (m.breakpoint[i].k == statement::ode)
+            throw error(m.breakpoint[i].line, "the ODEs go in the DERIVATIVE block");
+    if (m.suffix.empty())
+        throw error(line, "no SUFFIX in the NEURON block");
+    if (solve != derivative)
+        throw error(line, "BREAKPOINT must SOLVE the DERIVATIVE block " + derivative + " METHOD cnexp");
+    std::vector<std::string> c = m.currents();
+    for (std::size_t i = 0; i < m.ions.size(); ++i)
+        c.insert(c.end(), m.ions[i].read.begin(), m.ions[i].read.end());
+    for (std::size_t i = 0; i < c.size(); ++i)
+        if (!contains(m.assigned, c[i]))
+            throw error(line, c[i] + " of the NEURON block is not ASSIGNED");
+    for (std::set<std::string>::const_iterator it = m.range.begin(); it != m.range.end(); ++it) {
+        bool declared = contains(m.assigned, *it) || contains(m.states, *it);
+        for (std::size_t i = 0; i < m.parameters.size(); ++i)
+            declared = declared || m.parameters[i].name == *it;
+        if (!declared)
+            throw error(line, "RANGE " + *it + " is not declared");
+    }
+    return m;
+}
+
+void write_kernels(std::ostream &out, const model &m, const std::string &source) {
+    std::vector<std::string> fields = m.fields();
+    std::vector<std::string> pdata = m.pdata();
+    std::vector<std::string> currents = m.currents();
+    const std::string &s = m.suffix;
+
+    /* the kernels are written once the blocks translate */
+    translator state_tr(m, m.derivative);
+    bool odes = false;
+    std::string state_body = body(m.derivative, state_tr, odes);
+    translator current_tr(m, m.breakpoint);
+    std::string current_body = body(m.breakpoint, current_tr, odes);
+
+    out << "/*\n * Neuromapp - " << s << ".c, generated by coreneuron10_nmodl from "
+        << source << ", do not edit\n */\n\n";
+    out << "/**\n * @file " << s << ".c\n * \\brief The kernels of the mechanism " << s
+        << ", generated from " << source << "\n */\n\n";
+    out << "#include <math.h>\n\n";
+    out << "#include \"coreneuron_1.0/common/memory/nrnthread.h\"\n";
+    out << "#include \"coreneuron_1.0/common/util/vectorizer.h\"\n\n";
+    out << "#define _STRIDE _cntml + _iml\n\n";
+    for (std::size_t i = 0; i < fields.size(); ++i)
+        out << "#define " << fields[i] << " _p[" << i << "*_STRIDE]\n";
+    for (std::size_t i = 0; i < pdata.size(); ++i)
+        out << "#define " << pdata[i] << " _nt_data[_ppvar[" << i << "*_STRIDE]]\n";
+    out << "\n";
+    out << "void mech_nmodl_state_" << s << "(NrnThread *_nt, Mechanism *_ml);\n";
+    out << "void mech_nmodl_current_" << s << "(NrnThread *_nt, Mechanism *_ml);\n\n";
+
+    out << "void mech_nmodl_state_" << s << "(NrnThread *_nt, Mechanism *_ml)\n{\n";
+    if (m.derivative.empty()) {
+        out << "    (void) _nt;\n    (void) _ml;\n";
+    } else {
+        arrays(out, m, state_tr.uses("v"), false);
+        out << state_tr.constants("    ") << "\n";
+        out << "    _PRAGMA_FOR_VECTOR_LOOP_\n";
+        out << "    for (_iml = 0; _iml < _cntml; ++_iml)\n    {\n";
+        if (state_tr.uses("v"))
+            out << "        double v = _vec_v[_ni[_iml]];\n";
+        if (odes)
+            out << "        double _a, _b;\n";
+        out << state_tr.locals("        ");
+        ion_reads(out, m);
+        out << state_body;
+        out << "    }\n";
+    }
+    out << "}\n\n";
+
+    std::vector<std::string> c_currents;
+    for (std::size_t i = 0; i < currents.size(); ++i)
+        c_currents.push_back(current_tr.name(currents[i], 0));
+    std::string sum;
+    for (std::size_t i = 0; i < c_currents.size(); ++i)
+        sum += (i ? " + " : "") + c_currents[i];
+
+    out << "void mech_nmodl_current_" << s << "(NrnThread *_nt, Mechanism *_ml)\n{\n";
+    arrays(out, m, true, !currents.empty());
+    out << current_tr.constants("    ") << "\n";
+    out << "    _PRAGMA_FOR_VECTOR_LOOP_\n";
+    out << "    for (_iml = 0; _iml < _cntml; ++_iml)\n    {\n";
+    out << "        int _nd_idx = _ni[_iml];\n";
+    out << "        double _v = _vec_v[_nd_idx];\n";
+    out << "        double v;\n";
+    out << current_tr.locals("        ");
+    if (!currents.empty()) {
+        out << "        double _rhs, _g;\n";
+        for (std::size_t i = 0; i < m.ions.size(); ++i)
+            for (std::size_t j = 0; j < m.ions[i].write.size(); ++j)
+                out << "        double _d" << m.ions[i].write[j] << ";\n";
+    }
+    ion_reads(out, m);
+    if (!currents.empty()) {
+        out << "        /* the currents at v + 0.001, for the conductance */\n";
+        out << "        v = _v + 0.001;\n";
+        out << current_body;
+        out << "        _g = " << sum << ";\n";
+        for (std::size_t i = 0; i < m.ions.size(); ++i)
+            for (std::size_t j = 0; j < m.ions[i].write.size(); ++j)
+                out << "        _d" << m.ions[i].write[j] << " = "
+                    << current_tr.name(m.ions[i].write[j], 0) << ";\n";
+        out << "        /* the currents at v */\n";
+    }
+    out << "        v = _v;\n";
+    out << current_body;
+    if (!currents.empty()) {
+        out << "        _rhs = " << sum << ";\n";
+        out << "        _g = (_g - _rhs) / 0.001;\n";
+        for (std::size_t i = 0; i < m.ions.size(); ++i)
+            for (std::size_t j = 0; j < m.ions[i].write.size(); ++j) {
+                const std::string &c = m.ions[i].write[j];
+                std::string cc = current_tr.name(c, 0);
+                out << "        _ion_d" << c << "dv += (_d" << c << " - " << cc << ") / 0.001;\n";
+                out << "        _ion_" << c << " += " << cc << ";\n";
+            }
+        out << "        _vec_rhs[_nd_idx] -= _rhs;\n";
+        out << "        _vec_d[_nd_idx] += _g;\n";
+    }
+    out << "    }\n}\n";
+}
+
+void write_registry(std::ostream &out, const std::vector<model> &m, const std::vector<int> &types) {
+    std::set<std::string> suffixes;
+    for (std::size_t i = 0; i < m.size(); ++i)
+        if (!suffixes.insert(m[i].suffix).second)
+            throw error(0, "the SUFFIX " + m[i].suffix + " is described twice");
+
+    out << "/*\n * Neuromapp - the table of registry.h, generated by coreneuron10_nmodl, do not edit\n */\n\n";
+    out << "#include <stddef.h>\n\n";
+    out << "#include \"coreneuron_1.0/kernel/nmodl/registry.h\"\n\n";
+    for (std::size_t i = 0; i < m.size(); ++i) {
+        out << "void mech_nmodl_state_" << m[i].suffix << "(NrnThread *nt, Mechanism *ml);\n";
+        out << "void mech_nmodl_current_" << m[i].suffix << "(NrnThread *nt, Mechanism *ml);\n";
+    }
+    out << "\nconst struct mech_nmodl mech_nmodl_kernels[] = {\n";
+    for (std::size_t i = 0; i < m.size(); ++i)
+        out << "    {\"" << m[i].suffix << "\", " << types[i] << ", " << m[i].fields().size() << ", "
+            << m[i].pdata().size() << ", mech_nmodl_state_" << m[i].suffix
+            << ", mech_nmodl_current_" << m[i].suffix << "},\n";
+    out << "    {NULL, -1, 0, 0, NULL, NULL}\n};\n\n";
+    out << "const int mech_nmodl_nkernels = " << m.size() << ";\n";
+}
+
+} // end namespace
@@ -0,0 +1,157 @@
+/*
+ * Neuromapp - nmodl.h, Copyright (c), 2015,
+ * Timothee Ewart - Swiss Federal Institute of technology in Lausanne,
+ * Pramod Kumbhar - Swiss Federal Institute of technology in Lausanne,
+ * timothee.ewart@epfl.ch,
+ * paramod.kumbhar@epfl.ch
+ * All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+
+/**
+ * @file neuromapp/coreneuron_1.0/kernel/nmodl/nmodl.h
+ * \brief Generator of the SoA kernels of a density mechanism described in
+ * a subset of NMODL
+ *
+ * The subset: the NEURON block (SUFFIX, USEION ... READ ... WRITE of the
+ * currents, NONSPECIFIC_CURRENT, RANGE), PARAMETER, ASSIGNED and STATE,
+ * BREAKPOINT with SOLVE ... METHOD cnexp, and one DERIVATIVE block. The
+ * statements are LOCAL, assignments, if/else and the ODEs x' = f(x), f
+ * linear in x. UNITS, INITIAL and the units of the declarations are
+ * skipped, everything else (PROCEDURE, FUNCTION, POINT_PROCESS, TABLE,
+ * KINETIC, VERBATIM, ^) is an error.
+ */
+
+#ifndef MAPP_NMODL_H_
+#define MAPP_NMODL_H_
+
+#include <iosfwd>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace nmodl {
+
+/** \class error
+    \brief a description the generator does not understand, at a line
+ */
+class error : public std::runtime_error {
+public:
+    error(int line, const std::string &what) : std::runtime_error(what), line_(line) {}
+    int line() const { return line_; }
+private:
+    int line_;
+};
+
+/** \struct token
+    \brief a name, a number or a punctuation of the description
+ */
+struct token {
+    enum kind { name, number, punct };
+    token(kind kind_ = punct, const std::string &text_ = "", int line_ = 0) : k(kind_), text(text_), line(line_) {}
+    kind k;
+    std::string text;
+    int line;
+};
+
+/** \struct statement
+    \brief a statement of the BREAKPOINT or the DERIVATIVE block, the
+    if/else are flat: if_, else_if, else_ open a block, end closes it
+ */
+struct statement {
+    enum kind { assign, ode, local, if_, else_if, else_, end };
+    kind k;
+    /** the variable assigned, or declared by local */
+    std::string name;
+    /** the right hand side, or the condition */
+    std::vector<token> expression;
+    int line;
+};
+
+/** \struct ion
+    \brief USEION: the variables read from the ion and the currents written to it
+ */
+struct ion {
+    std::string name;
+    std::vector<std::string> read;
+    std::vector<std::string> write;
+};
+
+/** \struct parameter
+    \brief a PARAMETER and its default value, as written
+ */
+struct parameter {
+    std::string name;
+    std::string value;
+};
+
+/** \class model
+    \brief a mechanism described in NMODL
+ */
+class model {
+public:
+    std::string suffix;
+    std::vector<ion> ions;
+    /** NONSPECIFIC_CURRENT */
+    std::vector<std::string> nonspecific;
+    std::set<std::string> range;
+    std::vector<parameter> parameters;
+    std::vector<std::string> assigned;
+    std::vector<std::string> states;
+    std::vector<statement> breakpoint;
+    std::vector<statement> derivative;
+
+    /** \fn std::vector<std::string> fields() const
+        \brief the layout of the data of an instance, as nocmodl: the RANGE
+        parameters, the states, the RANGE assigned, the variables read from
+        the ions, the derivatives of the states, v and g
+     */
+    std::vector<std::string> fields() const;
+
+    /** \fn std::vector<std::string> pdata() const
+        \brief the layout of the pdata, per ion: the variables read, the
+        currents written, then their derivatives di/dv
+     */
+    std::vector<std::string> pdata() const;
+
+    /** the currents: NONSPECIFIC_CURRENT, then the ones written to the ions */
+    std::vector<std::string> currents() const;
+};
+
+/** \fn model parse(std::istream &in)
+    \brief reads a description
+    \throw error if the description is not in the subset
+ */
+model parse(std::istream &in);
+
+/** \fn void write_kernels(std::ostream &out, const model &m, const std::string &source)
+    \brief writes the C file of the kernels mech_nmodl_state_SUFFIX and
+    mech_nmodl_current_SUFFIX, in the conventions of kernel/mechanism
+    \param source name of the description, for the comments
+    \throw error if a statement uses an undeclared variable or function
+ */
+void write_kernels(std::ostream &out, const model &m, const std::string &source);
+
+/** \fn void write_registry(std::ostream &out, const std::vector<model> &m, const std::vector<int> &types)
+    \brief writes the C file of the table mech_nmodl_kernels of registry.h
+    \param types the type of every mechanism in the data sets
+    \throw error if two mechanisms have the same suffix
+ */
+void write_registry(std::ostream &out, const std::vector<model> &m, const std::vector<int> &types);
+
+} // end namespace
+
+#endif
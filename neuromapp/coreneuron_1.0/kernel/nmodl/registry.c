@@ -0,0 +1,52 @@
+/*
+ * Neuromapp - registry.c, Copyright (c), 2015,
+ * Timothee Ewart - Swiss Federal Institute of technology in Lausanne,
+ * Pramod Kumbhar - Swiss Federal Institute of technology in Lausanne,
+ * timothee.ewart@epfl.ch,
+ * paramod.kumbhar@epfl.ch
+ * All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+
+/**
+ * @file neuromapp/coreneuron_1.0/kernel/nmodl/registry.c
+ * \brief Implements the lookup of the generated kernels
+ */
+
+#include <stddef.h>
+#include <string.h>
+
+#include "coreneuron_1.0/kernel/nmodl/registry.h"
+
+const struct mech_nmodl *mech_nmodl_find(const char *mechanism)
+{
+    int i;
+    for(i = 0; i < mech_nmodl_nkernels; ++i)
+        if(strcmp(mech_nmodl_kernels[i].mechanism, mechanism) == 0)
+            return &mech_nmodl_kernels[i];
+    return NULL;
+}
+
+Mechanism *mech_nmodl_data(const struct mech_nmodl *k, NrnThread *nt)
+{
+    int i;
+    for(i = 0; i < nt->nmech; ++i)
+        if(nt->ml[i].type == k->type){
+            if(nt->ml[i].szp != k->szp || nt->ml[i].szdp != k->szdp || nt->ml[i].is_art)
+                return NULL;
+            return &nt->ml[i];
+        }
+    return NULL;
+}
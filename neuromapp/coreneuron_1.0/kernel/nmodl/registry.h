@@ -0,0 +1,72 @@
+/*
+ * Neuromapp - registry.h, Copyright (c), 2015,
+ * Timothee Ewart - Swiss Federal Institute of technology in Lausanne,
+ * Pramod Kumbhar - Swiss Federal Institute of technology in Lausanne,
+ * timothee.ewart@epfl.ch,
+ * paramod.kumbhar@epfl.ch
+ * All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+
+/**
+ * @file neuromapp/coreneuron_1.0/kernel/nmodl/registry.h
+ * \brief The kernels generated from the NMODL descriptions of kernel/nmodl/mod,
+ * the table is written by coreneuron10_nmodl at build time
+ */
+
+#ifndef MAPP_KERNEL_NMODL_REGISTRY_
+#define MAPP_KERNEL_NMODL_REGISTRY_
+
+#include "coreneuron_1.0/common/memory/nrnthread.h"
+
+#ifdef __cplusplus
+     extern "C" {
+#endif
+
+/** \struct mech_nmodl
+    \brief the kernels of a mechanism and the layout they expect
+ */
+struct mech_nmodl {
+    /** SUFFIX of the description, as --mechanism of the kernel miniapp */
+    const char *mechanism;
+    /** type of the mechanism in the data sets */
+    int type;
+    /** fields and pdata of an instance */
+    int szp;
+    int szdp;
+    void (*state)(NrnThread *nt, Mechanism *ml);
+    void (*current)(NrnThread *nt, Mechanism *ml);
+};
+
+/** the generated kernels, ended by an entry of NULL mechanism */
+extern const struct mech_nmodl mech_nmodl_kernels[];
+extern const int mech_nmodl_nkernels;
+
+/** \fn const struct mech_nmodl *mech_nmodl_find(const char *mechanism)
+    \return the kernels of the mechanism, NULL if none was generated
+ */
+const struct mech_nmodl *mech_nmodl_find(const char *mechanism);
+
+/** \fn Mechanism *mech_nmodl_data(const struct mech_nmodl *k, NrnThread *nt)
+    \return the instances of the type of k in nt, NULL if there are none or
+    if their layout is not the one of the description
+ */
+Mechanism *mech_nmodl_data(const struct mech_nmodl *k, NrnThread *nt);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
@@ -0,0 +1,136 @@
+/*
+ * Neuromapp - histogram.h, Copyright (c), 2015,
+ * Kai Langen - Swiss Federal Institute of technology in Lausanne,
+ * kai.langen@epfl.ch,
+ * All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+
+/**
+ * @file neuromapp/coreneuron_1.0/queueing/histogram.h
+ * \brief Contains the latency histogram of the queueing miniapp
+ */
+
+#ifndef MAPP_HISTOGRAM_H_
+#define MAPP_HISTOGRAM_H_
+
+#include <time.h>
+#include <vector>
+
+namespace queueing {
+
+/** \fn unsigned long long now_ns()
+    \return monotonic time in ns
+ */
+inline unsigned long long now_ns(){
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/** \class histogram
+    \brief log-linear histogram (as HDR histograms): every power of two range
+    is split in 32 linear buckets, so a value is known within 1/32 (3%),
+    the values below 32 exactly
+ */
+class histogram {
+public:
+	typedef unsigned long long value_type;
+
+	histogram(): counts_(nbuckets, 0), count_(0), max_(0) {}
+
+	/** \fn void record(value_type v)
+	    \brief adds the value v
+	 */
+	void record(value_type v){
+		counts_[index(v)]++;
+		count_++;
+		if(v > max_)
+			max_ = v;
+	}
+
+	/** \fn void merge(histogram const& h)
+	    \brief adds the values of h
+	 */
+	void merge(histogram const& h){
+		for(int i=0; i < nbuckets; ++i)
+			counts_[i] += h.counts_[i];
+		count_ += h.count_;
+		if(h.max_ > max_)
+			max_ = h.max_;
+	}
+
+	/** \fn value_type percentile(double p) const
+	    \param p percentage in [0,100]
+	    \return the highest value of the bucket of the p-th percentile, 0 if empty
+	 */
+	value_type percentile(double p) const {
+		if(count_ == 0)
+			return 0;
+		value_type rank = (value_type)(p / 100. * count_ + 0.5);
+		if(rank < 1)
+			rank = 1;
+		value_type seen = 0;
+		for(int i=0; i < nbuckets; ++i){
+			seen += counts_[i];
+			if(seen >= rank)
+				return highest(i) < max_ ? highest(i) : max_;
+		}
+		return max_;
+	}
+
+	/** \fn value_type count() const
+	    \return the number of values
+	 */
+	value_type count() const {return count_;}
+
+	/** \fn value_type max() const
+	    \return the largest value
+	 */
+	value_type max() const {return max_;}
+
+	/** \fn int index(value_type v)
+	    \return the bucket of the value v
+	 */
+	static int index(value_type v){
+		if(v < nsub)
+			return (int)v;
+		int e = 63 - __builtin_clzll(v);
+		return (e - sub_bits + 1) * nsub + (int)((v >> (e - sub_bits)) & (nsub - 1));
+	}
+
+	/** \fn value_type highest(int i)
+	    \return the highest value of the bucket i
+	 */
+	static value_type highest(int i){
+		if(i < nsub)
+			return i;
+		int e = i / nsub + sub_bits - 1;
+		value_type width = 1ULL << (e - sub_bits);
+		return ((value_type)(nsub + i % nsub) << (e - sub_bits)) + width - 1;
+	}
+
+private:
+	static const int sub_bits = 5;
+	static const int nsub = 1 << sub_bits;
+	static const int nbuckets = (64 - sub_bits + 1) * nsub;
+
+	std::vector<value_type> counts_;
+	value_type count_;
+	value_type max_;
+};
+
+}
+#endif
@@ -25,6 +25,7 @@
 
 #include <iostream>
 #include <ctime>
+#include <climits>
 #include <boost/program_options.hpp>
 #include <sys/time.h>
 
@@ -35,6 +36,7 @@
 #include "coreneuron_1.0/queueing/pool.h"
 #include "coreneuron_1.0/queueing/thread.h"
 #include "coreneuron_1.0/queueing/queueing.h"
+#include "coreneuron_1.0/common/util/affinity.h"
 #include "utils/error.h"
 
 /** namespace alias for boost::program_options **/
@@ -55,16 +57,37 @@ int qhelp(int argc, char* const argv[], po::variables_map& vm){
     ("help", "produce help message")
     ("numthread", po::value<int>()->default_value(1),
      "number of OMP thread")
+    ("bind", po::value<std::string>()->default_value("none"),
+     "placement of the OMP threads: none, compact, scatter or a list of cpus as 0,2,4-7")
     ("eventsper", po::value<int>()->default_value(50),
      "number of events created per time step")
     ("simtime", po::value<int>()->default_value(5000),
      "number of time steps in the simulation")
+    ("ncellgroups", po::value<int>()->default_value(64),
+     "number of cell groups (NrnThreadData) shared by the OMP threads")
     ("percent-ite", po::value<int>()->default_value(90),
      "the percentage of inter-thread events out of total events")
     ("spike-enabled","determines whether or not to include spike events")
     ("verbose","provides additional outputs during execution")
     ("spinlock","runs the simulation using spinlocks/linked-list instead of mutexes/vector")
-    ("with-algebra","simulation performs linear algebra calculations");
+    ("with-algebra","simulation performs linear algebra calculations")
+    ("windowed","cell groups integrate min-delay windows without barrier, "
+     "then exchange the spikes in parallel")
+    ("steal","idle threads steal cell groups from the others at every time step, not with --windowed")
+    ("imbalance", po::value<int>()->default_value(0),
+     "the percentage of inter-thread events sent to the cell group 0")
+    ("traffic", po::value<std::string>()->default_value("uniform"),
+     "destinations of the inter-thread events: uniform, zipf, ring or block")
+    ("zipf", po::value<double>()->default_value(1.),
+     "exponent s of the zipf traffic, the cell group k receives in 1/(k+1)^s")
+    ("block-size", po::value<int>()->default_value(8),
+     "number of cell groups of a community in the block traffic")
+    ("locality", po::value<int>()->default_value(90),
+     "the percentage of inter-thread events sent inside the community in the block traffic")
+    ("burst", po::value<int>()->default_value(1),
+     "a cell group sends burst*eventsper events one time step out of burst, on average")
+    ("false-sharing","benchmarks per-thread counters packed in one cache line against padded ones, "
+     "100*simtime*eventsper increments per thread");
     //future options : fraction of interthread events
 
     po::store(po::parse_command_line(argc, argv, desc), vm);
@@ -78,15 +101,49 @@ int qhelp(int argc, char* const argv[], po::variables_map& vm){
     if(vm["numthread"].as<int>() < 1)
 		return mapp::MAPP_BAD_ARG;
 
+    if(nrn_bind_check(vm["bind"].as<std::string>().c_str()) != 0)
+		return mapp::MAPP_BAD_ARG;
+
     if(vm["eventsper"].as<int>() < 1)
 		return mapp::MAPP_BAD_ARG;
 
     if(vm["simtime"].as<int>() < 1)
 		return mapp::MAPP_BAD_ARG;
 
+    // the increments of the false sharing benchmark must fit in a long
+    if(vm.count("false-sharing") &&
+       vm["simtime"].as<int>() > LONG_MAX / 100 / vm["eventsper"].as<int>())
+		return mapp::MAPP_BAD_ARG;
+
+    // the windows of the cell groups are not stolen
+    if(vm.count("windowed") && vm.count("steal"))
+		return mapp::MAPP_BAD_ARG;
+
+    if(vm["ncellgroups"].as<int>() < 1)
+		return mapp::MAPP_BAD_ARG;
+
    if( (vm["percent-ite"].as<int>() < 0) || (vm["percent-ite"].as<int>() > 100) )
 		return mapp::MAPP_BAD_ARG;
 
+   if( (vm["imbalance"].as<int>() < 0) || (vm["imbalance"].as<int>() > 100) )
+		return mapp::MAPP_BAD_ARG;
+
+    traffic_model model;
+    if(!traffic_model_from_string(vm["traffic"].as<std::string>(), model))
+		return mapp::MAPP_BAD_ARG;
+
+    if(vm["zipf"].as<double>() <= 0.)
+		return mapp::MAPP_BAD_ARG;
+
+    if(vm["block-size"].as<int>() < 1)
+		return mapp::MAPP_BAD_ARG;
+
+   if( (vm["locality"].as<int>() < 0) || (vm["locality"].as<int>() > 100) )
+		return mapp::MAPP_BAD_ARG;
+
+    if(vm["burst"].as<int>() < 1)
+		return mapp::MAPP_BAD_ARG;
+
 #ifdef _OPENMP
     omp_set_num_threads(vm["numthread"].as<int>());
 #endif
@@ -101,14 +158,94 @@ template<implementation I>
 void run_sim(Pool<I> &pl, po::variables_map const&vm){
     struct timeval start, end;
     gettimeofday(&start, NULL);
-    for(int j = 0; j < vm["simtime"].as<int>(); ++j){
-        pl.timeStep(vm["simtime"].as<int>());
-		pl.handleSpike(vm["simtime"].as<int>());
+    if(vm.count("windowed")){
+        pl.windowedRun(vm["simtime"].as<int>());
+    } else {
+        bool steal = vm.count("steal");
+        for(int j = 0; j < vm["simtime"].as<int>(); ++j){
+            if(steal)
+                pl.timeStepStealing(vm["simtime"].as<int>());
+            else
+                pl.timeStep(vm["simtime"].as<int>());
+            pl.handleSpike(vm["simtime"].as<int>());
+        }
     }
 	pl.accumulate_stats();
     gettimeofday(&end, NULL);
     long long diff_ms = (1000 * (end.tv_sec - start.tv_sec)) + ((end.tv_usec - start.tv_usec) / 1000);
+    neuromapp_data.put_copy(STORAGE_COMPUTE_TIME,
+                            (end.tv_sec - start.tv_sec) + 1e-6 * (end.tv_usec - start.tv_usec));
 	std::cout<<"run time: "<<diff_ms<<" ms"<<std::endl;
+	std::cout<<"event size: "<<sizeof(event)<<" bytes"<<std::endl;
+	if(diff_ms > 0)
+		std::cout<<"throughput: "<<1000. * neuromapp_data.get<int>("enqueued") / diff_ms
+		         <<" events/s"<<std::endl;
+}
+
+/** \struct counter
+    \brief a per-thread event counter
+ */
+struct counter {
+    long n;
+};
+
+/** \fn double count_events(std::vector<T>& counters, long nincrements)
+    \brief every thread increments its own counter, returns the elapsed time (ms)
+    \param counters one counter per thread
+    \param nincrements number of increments per thread
+ */
+template<class T>
+double count_events(std::vector<T>& counters, long nincrements){
+    struct timeval start, end;
+    int size = counters.size();
+    gettimeofday(&start, NULL);
+    #pragma omp parallel for schedule(static,1)
+    for(int i=0; i < size; ++i){
+        // volatile: one store per increment, as with the NrnThreadData counters
+        volatile long& n = counters[i].n;
+        for(long j=0; j < nincrements; ++j)
+            n = n + 1;
+    }
+    gettimeofday(&end, NULL);
+    return (1000. * (end.tv_sec - start.tv_sec)) + ((end.tv_usec - start.tv_usec) / 1000.);
+}
+
+/** \fn long sum_counters(std::vector<T> const& counters)
+    \brief the increments counted by all the threads
+ */
+template<class T>
+long sum_counters(std::vector<T> const& counters){
+    long sum = 0;
+    for(std::size_t i=0; i < counters.size(); ++i)
+        sum += counters[i].n;
+    return sum;
+}
+
+/** \fn false_sharing(po::variables_map const& vm)
+    \brief times per-thread counters sharing a cache line against counters
+    on their own cache lines, the times and the increments counted are
+    stored in neuromapp_data
+    \param vm encapsulate the command line and all needed informations
+ */
+void false_sharing(po::variables_map const& vm){
+    int nthreads = vm["numthread"].as<int>();
+    long nincrements = 100L * vm["simtime"].as<int>() * vm["eventsper"].as<int>();
+
+    std::vector<counter> packed(nthreads, counter());
+    std::vector<cache_line_padded<counter> > padded(nthreads, cache_line_padded<counter>());
+
+    double packed_ms = count_events(packed, nincrements);
+    double padded_ms = count_events(padded, nincrements);
+
+    std::cout<<"packed counters: "<<packed_ms<<" ms"<<std::endl;
+    std::cout<<"padded counters: "<<padded_ms<<" ms"<<std::endl;
+    if(padded_ms > 0.)
+        std::cout<<"slowdown from false sharing: "<<packed_ms/padded_ms<<std::endl;
+
+    neuromapp_data.put_copy("false_sharing_packed", packed_ms);
+    neuromapp_data.put_copy("false_sharing_padded", padded_ms);
+    neuromapp_data.put_copy("false_sharing_packed_count", sum_counters(packed));
+    neuromapp_data.put_copy("false_sharing_padded_count", sum_counters(padded));
 }
 
 /** \fn queueing_miniapp(po::variables_map const& vm)
@@ -119,12 +256,25 @@ void queueing_miniapp(po::variables_map const& vm){
 	bool verbose = vm.count("verbose");
 	bool spike = vm.count("spike-enabled");
 	bool algebra = vm.count("with-algebra");
+	traffic_model model = uniform;
+	traffic_model_from_string(vm["traffic"].as<std::string>(), model);
+	traffic t(model, vm["imbalance"].as<int>(), vm["zipf"].as<double>(), vm["block-size"].as<int>(),
+	          vm["locality"].as<int>(), vm["burst"].as<int>());
+
+    nrn_bind_threads(vm["bind"].as<std::string>().c_str());
+
+    if(vm.count("false-sharing")){
+        false_sharing(vm);
+        return;
+    }
 
     if(vm.count("spinlock")){
-   		Pool<spinlock> pl(verbose, vm["eventsper"].as<int>(), vm["percent-ite"].as<int>(), spike, algebra);
+   		Pool<spinlock> pl(verbose, vm["eventsper"].as<int>(), vm["percent-ite"].as<int>(), spike, algebra,
+		                  vm["ncellgroups"].as<int>(), t);
 		run_sim(pl,vm);
     } else {
-   		Pool<mutex> pl(verbose, vm["eventsper"].as<int>(), vm["percent-ite"].as<int>(), spike, algebra);
+   		Pool<mutex> pl(verbose, vm["eventsper"].as<int>(), vm["percent-ite"].as<int>(), spike, algebra,
+		               vm["ncellgroups"].as<int>(), t);
 		run_sim(pl,vm);
     }
 }
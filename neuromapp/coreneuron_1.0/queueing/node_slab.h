@@ -0,0 +1,121 @@
+/*
+ * Neuromapp - node_slab.h, Copyright (c), 2015,
+ * Kai Langen - Swiss Federal Institute of technology in Lausanne,
+ * kai.langen@epfl.ch,
+ * All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+
+/**
+ * @file neuromapp/coreneuron_1.0/queueing/node_slab.h
+ * \brief Slab allocator for the nodes of the inter-thread linked-lists
+ */
+
+#include <stdlib.h>
+#include <vector>
+#include <new>
+#include <boost/atomic.hpp>
+
+#ifndef MAPP_NODE_SLAB_
+#define MAPP_NODE_SLAB_
+
+namespace queueing {
+
+/** size of a cache line in bytes, cell groups are aligned on it */
+static const size_t cache_line_size = 64;
+
+/** \class node_slab
+    \brief allocates the nodes sent by a cell group in blocks. Only the owner
+    allocates, the receivers give the nodes back on a lock-free stack that
+    the owner takes whole when its free list is empty. Node must have a
+    Node* next member
+ */
+template<class Node>
+class node_slab {
+public:
+	/** \fn node_slab(size_t block)
+	    \param block number of nodes allocated at once
+	 */
+	explicit node_slab(size_t block = 1024): free_(NULL), block_(block), remote_(NULL) {}
+
+	/** \fn ~node_slab()
+	    \brief frees the blocks, the nodes still in a queue included
+	 */
+	~node_slab(){
+		for(size_t i=0; i < blocks_.size(); ++i)
+			free(blocks_[i]);
+	}
+
+	/** \fn Node* allocate()
+	    \brief owner only: takes a node of the free list
+	 */
+	Node* allocate(){
+		if(free_ == NULL)
+			free_ = remote_.exchange(NULL, boost::memory_order_acquire);
+		if(free_ == NULL)
+			grow();
+		Node* n = free_;
+		free_ = n->next;
+		return n;
+	}
+
+	/** \fn void deallocate(Node* n)
+	    \brief any thread: gives a node back to the owner
+	 */
+	void deallocate(Node* n){
+		Node* head = remote_.load(boost::memory_order_relaxed);
+		do {
+			n->next = head;
+		} while(!remote_.compare_exchange_weak(head, n, boost::memory_order_release,
+		                                       boost::memory_order_relaxed));
+	}
+
+	/** \fn size_t capacity() const
+	    \return the number of nodes allocated by the slab
+	 */
+	size_t capacity() const {return blocks_.size() * block_;}
+
+private:
+	node_slab(node_slab const&);
+	node_slab& operator=(node_slab const&);
+
+	/** \fn void grow()
+	    \brief allocates a block of nodes on whole cache lines
+	 */
+	void grow(){
+		void* p = NULL;
+		size_t bytes = (block_ * sizeof(Node) + cache_line_size - 1) / cache_line_size * cache_line_size;
+		if(posix_memalign(&p, cache_line_size, bytes) != 0)
+			throw std::bad_alloc();
+		blocks_.push_back(p);
+		Node* nodes = static_cast<Node*>(p);
+		for(size_t i=0; i < block_; ++i){
+			nodes[i].next = free_;
+			free_ = &nodes[i];
+		}
+	}
+
+	/// written by the owner only
+	Node* free_;
+	size_t block_;
+	std::vector<void*> blocks_;
+	/// the stack written by the receivers is alone on its cache line
+	char pad0_[cache_line_size];
+	boost::atomic<Node*> remote_;
+	char pad1_[cache_line_size - sizeof(boost::atomic<Node*>)];
+};
+
+}
+#endif
@@ -23,16 +23,21 @@
  * \brief Contains Pool class declaration.
  */
 
-#include <boost/array.hpp>
 #include <stdio.h>
 #include <stdlib.h>
 #include <iostream>
 #include <fstream>
 #include <time.h>
 #include <ctime>
+#include <sys/time.h>
+#include <algorithm>
 #include <numeric>
+#include <vector>
+#include <new>
 
 #include "coreneuron_1.0/queueing/thread.h"
+#include "coreneuron_1.0/queueing/steal.h"
+#include "coreneuron_1.0/queueing/traffic.h"
 #include "utils/storage/neuromapp_data.h"
 
 #ifdef _OPENMP
@@ -44,6 +49,15 @@
 
 namespace queueing {
 
+/** \fn double wtime()
+    \return wall clock time in ms
+ */
+inline double wtime(){
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return 1000. * tv.tv_sec + tv.tv_usec / 1000.;
+}
+
 template<implementation I>
 class NrnThreadData;
 
@@ -58,58 +72,186 @@ private:
 	int all_spiked_;
 	const static int min_delay_ = 5;
 	int percent_spike_;
+	/// destinations and number of the events
+	traffic traffic_;
+	/// deques of the work-stealing time step, created by its first call
+	task_deques* tasks_;
 
-	boost::array<NrnThreadData<I>,64> threadDatas;
+	/// one cache-line aligned allocation per cell group
+	std::vector<NrnThreadData<I>*> threadDatas;
+
+	// a cell group is not copyable (locks), neither is the pool
+	Pool(Pool const&);
+	Pool& operator=(Pool const&);
+
+	/** \fn NrnThreadData<I>* create_cellgroup(bool with_algebra)
+	    \brief allocates and constructs a cell group on its own cache lines,
+	    the memory is first touched by the calling thread
+	    \param with_algebra the cell group gets its own copy of the dataset
+	 */
+	static NrnThreadData<I>* create_cellgroup(bool with_algebra){
+		void* p = NULL;
+		if(posix_memalign(&p, cache_line_size, cellgroup_bytes()) != 0)
+			throw std::bad_alloc();
+		return new(p) NrnThreadData<I>(with_algebra);
+	}
+
+	/** \fn void destroy_cellgroup(NrnThreadData<I>* nt)
+	    \brief destroys and frees a cell group created by create_cellgroup
+	 */
+	static void destroy_cellgroup(NrnThreadData<I>* nt){
+		nt->~NrnThreadData<I>();
+		free(nt);
+	}
+
+	/** \fn size_t cellgroup_bytes()
+	    \return size of a cell group rounded up to a whole number of cache lines,
+	    so two cell groups never share a line
+	 */
+	static size_t cellgroup_bytes(){
+		return (sizeof(NrnThreadData<I>) + cache_line_size - 1)
+		       / cache_line_size * cache_line_size;
+	}
 
 public:
-	/** \fn Pool(bool verbose, int eventsPer, int percent_ITE_, bool isSpike, bool algebra)
+	/** \fn Pool(bool verbose, int eventsPer, int percent_ITE_, bool isSpike, bool algebra, int ncellgroups)
 	    \brief initializes a Pool with a threadDatas array
 	    \param verbose verbose mode: 1 = on, 0 = off
 	    \param events_per_step_ number of events per time step
 	    \param percent_ITE_ is the percentage of inter-thread events
 	    \param isSpike determines whether or not there are spike events
 	    \param algebra determines whether to perform linear algebra calculations
+	    \param ncellgroups number of cell groups (NrnThreadData) in the pool
+	    \param t the traffic model of the events
 	 */
-	explicit Pool(bool verbose=false, int eventsPer=0, int pITE=0, bool isSpike=0, bool algebra=0):
+	explicit Pool(bool verbose=false, int eventsPer=0, int pITE=0, bool isSpike=0, bool algebra=0,
+	              int ncellgroups=64, traffic const& t=traffic()):
 	v_(verbose), events_per_step_(eventsPer), percent_ITE_(pITE),
-	perform_algebra_(algebra), all_spiked_(0), time_(0){
+	perform_algebra_(algebra), all_spiked_(0), time_(0), traffic_(t), tasks_(NULL),
+	threadDatas(ncellgroups, NULL){
+				traffic_.setup(ncellgroups);
 				percent_spike_ = isSpike ? 3:0;
 				std::cout<<"isSpike = "<<isSpike<<std::endl;
    				srand(time(NULL));
+
+				// same schedule as timeStep: every cell group, and its copy of
+				// the dataset for the algebra, is first touched by the thread
+				// that works on it (NUMA first-touch)
+				int size = threadDatas.size();
+				#pragma omp parallel for schedule(static,1)
+				for(int i=0; i < size; ++i)
+					threadDatas[i] = create_cellgroup(perform_algebra_);
+	}
+
+	/** \fn ~Pool()
+	    \brief destroys the cell groups
+	 */
+	~Pool(){
+		// the inter-thread nodes belong to the slab of their sender: no
+		// queue may hold one when the cell groups are destroyed
+		for(int i=0; i < threadDatas.size(); ++i)
+			threadDatas[i]->enqueueMyEvents();
+		for(int i=0; i < threadDatas.size(); ++i)
+			destroy_cellgroup(threadDatas[i]);
+		delete tasks_;
 	}
 
+	/** \fn int ncellgroups() const
+	    \return the number of cell groups in the pool
+	 */
+	int ncellgroups() const {return threadDatas.size();}
+
+	/** \fn NrnThread* nrnthread(int i)
+	    \return the dataset of the cell group i
+	 */
+	NrnThread* nrnthread(int i){return threadDatas[i]->nrnthread();}
+
 	/** \fn accumulate_stats()
 	    \brief accumulates statistics from the threadData array and stores them using impl::storage
 	 */
 	void accumulate_stats(){
 		int all_ite_received = 0;
+		int all_ite_sent = 0;
 		int all_enqueued = 0;
 		int all_delivered = 0;
     	for(int i=0; i < threadDatas.size(); ++i){
-			all_ite_received += threadDatas[i].ite_received_;
-			all_enqueued += threadDatas[i].enqueued_;
-			all_delivered += threadDatas[i].delivered_;
+			all_spiked_ += threadDatas[i]->spiked_;
+			threadDatas[i]->spiked_ = 0;
+			all_ite_received += threadDatas[i]->ite_received_;
+			all_ite_sent += threadDatas[i]->ite_sent_;
+			all_enqueued += threadDatas[i]->enqueued_;
+			all_delivered += threadDatas[i]->delivered_;
 			if(v_){
 				std::cout<<"Cellgroup "<<i<<" ite received: "
-				<<threadDatas[i].ite_received_<<std::endl;
+				<<threadDatas[i]->ite_received_<<std::endl;
+				std::cout<<"Cellgroup "<<i<<" ite sent: "
+				<<threadDatas[i]->ite_sent_<<std::endl;
 				std::cout<<"Cellgroup "<<i<<" enqueued: "<<
-				threadDatas[i].enqueued_<<std::endl;
+				threadDatas[i]->enqueued_<<std::endl;
 				std::cout<<"Cellgroup "<<i<<" delivered: "<<
-				threadDatas[i].delivered_<<std::endl;
+				threadDatas[i]->delivered_<<std::endl;
 			}
 		}
 
 		if(v_){
+			std::cout<<"Total inter-thread sent: "<<all_ite_sent<<std::endl;
 			std::cout<<"Total inter-thread received: "<<all_ite_received<<std::endl;
 			std::cout<<"Total enqueued: "<<all_enqueued<<std::endl;
 			std::cout<<"Total spiked: "<<all_spiked_<<std::endl;
 			std::cout<<"Total delivered: "<<all_delivered<<std::endl;
 		}
-		neuromapp_data.put_copy("inter_received", all_ite_received);
+		// every event sent is in a destination queue, drained or not yet
+		neuromapp_data.put_copy("inter_received", all_ite_sent);
 		neuromapp_data.put_copy("enqueued", all_enqueued);
 	    neuromapp_data.put_copy("spikes", all_spiked_);
 	    neuromapp_data.put_copy("delivered", all_delivered);
+#ifdef NEUROMAPP_QUEUEING_LATENCY
+		latency_stats();
+#endif
+		if(tasks_){
+			if(v_)
+				std::cout<<"Total stolen cell groups: "<<tasks_->steals()<<std::endl;
+			neuromapp_data.put_copy("steals", tasks_->steals());
+		}
+	}
+
+#ifdef NEUROMAPP_QUEUEING_LATENCY
+	/** \fn void latency_stats()
+	    \brief prints the percentiles (ns) of the transfer and residency
+	    times, per cell group in verbose mode, and stores the ones of all the
+	    cell groups using impl::storage (transfer_p50, residency_p99, ...)
+	 */
+	void latency_stats(){
+		const double p[] = {50., 90., 99., 99.9};
+		const char* name[] = {"p50", "p90", "p99", "p999"};
+		histogram transfer, residency;
+		for(int i=0; i < threadDatas.size(); ++i){
+			transfer.merge(threadDatas[i]->transfer_);
+			residency.merge(threadDatas[i]->residency_);
+			if(v_)
+				std::cout<<"Cellgroup "<<i<<" transfer p50/p99/max: "
+				<<threadDatas[i]->transfer_.percentile(50.)<<"/"
+				<<threadDatas[i]->transfer_.percentile(99.)<<"/"
+				<<threadDatas[i]->transfer_.max()<<" ns, residency p50/p99/max: "
+				<<threadDatas[i]->residency_.percentile(50.)<<"/"
+				<<threadDatas[i]->residency_.percentile(99.)<<"/"
+				<<threadDatas[i]->residency_.max()<<" ns"<<std::endl;
+		}
+
+		std::cout<<"transfer latency (ns):";
+		for(int k=0; k < 4; ++k){
+			std::cout<<" "<<name[k]<<" "<<transfer.percentile(p[k]);
+			neuromapp_data.put_copy(std::string("transfer_")+name[k], (double)transfer.percentile(p[k]));
+		}
+		std::cout<<" max "<<transfer.max()<<std::endl;
+		std::cout<<"heap residency (ns):";
+		for(int k=0; k < 4; ++k){
+			std::cout<<" "<<name[k]<<" "<<residency.percentile(p[k]);
+			neuromapp_data.put_copy(std::string("residency_")+name[k], (double)residency.percentile(p[k]));
+		}
+		std::cout<<" max "<<residency.max()<<std::endl;
 	}
+#endif
 
 	/** \fn void timeStep(int totalTime)
 	    \brief master function to call generate, enqueue, and deliver
@@ -118,48 +260,203 @@ public:
 	void timeStep(int totalTime){
 	    int size = threadDatas.size();
 	    #pragma omp parallel for schedule(static,1)
-	    for(int i=0; i < size; ++i){
-			generateEvents(totalTime,i);
+	    for(int i=0; i < size; ++i)
+			cellgroupStep(totalTime, i);
+	    time_++;
+	}
 
-			threadDatas[i].enqueueMyEvents();
-			//Have threads enqueue their interThreadEvents
-			while(threadDatas[i].deliver(i, time_)); // deliver
-			
-			if(perform_algebra_)
-				threadDatas[i].l_algebra();
+	/** \fn void timeStepStealing(int totalTime)
+	    \brief same as timeStep, the cell groups start with the static
+	    distribution on per-thread deques and idle threads steal them
+	    \param totalTime tells the provides the total simulation time
+	 */
+	void timeStepStealing(int totalTime){
+	    int size = threadDatas.size();
+	    int nthreads = 1;
+#ifdef _OPENMP
+	    nthreads = omp_get_max_threads();
+#endif
+	    if(tasks_ == NULL || tasks_->size() < nthreads){
+			delete tasks_;
+			tasks_ = new task_deques(nthreads);
+	    }
 
+	    #pragma omp parallel
+	    {
+			int tid = 0, team = 1, i = 0;
+#ifdef _OPENMP
+			tid = omp_get_thread_num();
+			team = omp_get_num_threads();
+#endif
+			for(int j = tid; j < size; j += team)
+				tasks_->push(tid, j);
+			#pragma omp barrier
+			while(tasks_->pop(tid, i) || tasks_->steal(tid, i))
+				cellgroupStep(totalTime, i);
 	    }
 	    time_++;
 	}
 
+	/** \fn void cellgroupStep(int totalTime, int i)
+	    \brief the time step of the cell group i
+	    \param totalTime tells the provides the total simulation time
+	    \param i the cell group index
+	 */
+	void cellgroupStep(int totalTime, int i){
+		generateEvents(totalTime,i);
+
+		//Have threads enqueue their interThreadEvents
+		threadDatas[i]->enqueueMyEvents();
+		while(threadDatas[i]->deliver(i, time_)); // deliver
+
+		if(perform_algebra_)
+			threadDatas[i]->l_algebra();
+	}
+
+	/** \fn void windowedRun(int totalTime)
+	    \brief runs the whole simulation with CoreNEURON's schedule: every cell
+	    group integrates min_delay_ steps without synchronization, then the
+	    threads publish their spikes and gather the global list. The compute,
+	    exchange and wait times (ms, average over the threads) are stored
+	    using impl::storage
+	    \param totalTime tells the provides the total simulation time
+	 */
+	void windowedRun(int totalTime){
+		int size = threadDatas.size();
+		// as many spikes per window as handleSpike, split over the cell groups
+		int num_spikes = min_delay_*size*events_per_step_*percent_spike_/100;
+		double compute = 0., exchange = 0., wait = 0.;
+		int nthreads = 1;
+
+		#pragma omp parallel reduction(+:compute,exchange,wait)
+		{
+#ifdef _OPENMP
+			#pragma omp single
+			nthreads = omp_get_num_threads();
+#endif
+			double t0;
+			for(int start = 0; start < totalTime; start += min_delay_){
+				int end = std::min(start + min_delay_, totalTime);
+
+				// integration: no barrier before the end of the window
+				t0 = wtime();
+				#pragma omp for schedule(static,1) nowait
+				for(int i=0; i < size; ++i){
+					threadDatas[i]->clearSpikes();
+					for(int t = start; t < end; ++t){
+						generateEvents(totalTime, i, t);
+						threadDatas[i]->enqueueMyEvents();
+						while(threadDatas[i]->deliver(i, t));
+						if(perform_algebra_)
+							threadDatas[i]->l_algebra();
+					}
+					generateSpikes(totalTime, i, start,
+					               num_spikes/size + (i < num_spikes%size));
+				}
+				compute += wtime() - t0;
+
+				t0 = wtime();
+				#pragma omp barrier
+				wait += wtime() - t0;
+
+				// exchange: the same schedule, so a group is gathered by its owner
+				t0 = wtime();
+				#pragma omp for schedule(static,1) nowait
+				for(int i=0; i < size; ++i)
+					gatherSpikes(i);
+				exchange += wtime() - t0;
+
+				// the buffers are cleared by the next window
+				t0 = wtime();
+				#pragma omp barrier
+				wait += wtime() - t0;
+			}
+		}
+		time_ = totalTime;
+
+		compute /= nthreads;
+		exchange /= nthreads;
+		wait /= nthreads;
+		std::cout<<"compute time: "<<compute<<" ms"<<std::endl;
+		std::cout<<"exchange time: "<<exchange<<" ms"<<std::endl;
+		std::cout<<"wait time: "<<wait<<" ms"<<std::endl;
+		neuromapp_data.put_copy("compute_time", compute);
+		neuromapp_data.put_copy("exchange_time", exchange);
+		neuromapp_data.put_copy("wait_time", wait);
+	}
+
+	/** \fn void generateSpikes(int totalTime, int myID, int start, int nspikes)
+	    \brief buffers the spikes of a cell group for the window beginning at start,
+	    they are delivered after the min delay
+	    \param totalTime tells the provides the total simulation time
+	    \param myID the cell group index
+	    \param start the first time step of the window
+	    \param nspikes number of spikes
+	 */
+	void generateSpikes(int totalTime, int myID, int start, int nspikes){
+		int diff(1);
+		if(totalTime > 10)
+			diff = rand() % (totalTime/10);
+		int dst(0);
+		for(int i = 0; i < nspikes; ++i){
+			dst = rand() % threadDatas.size();
+			threadDatas[myID]->spike(dst, (double)(start + diff + min_delay_));
+		}
+	}
+
+	/** \fn void gatherSpikes(int myID)
+	    \brief scans the spike buffers of all the cell groups and enqueues the
+	    spikes targeting this one
+	    \param myID the cell group index
+	 */
+	void gatherSpikes(int myID){
+		for(int j=0; j < threadDatas.size(); ++j){
+			std::vector<event> const& spikes = threadDatas[j]->spikes();
+			for(int k=0; k < spikes.size(); ++k)
+				if(spikes[k].dst_ == myID)
+					threadDatas[myID]->selfSend(myID, spikes[k].t_);
+		}
+	}
+
 	/** \fn void generateEvents(int totalTime, int myID)
-	    \brief creates events which are sent to random destination threads
+	    \brief creates events at the current time
 	    \param totalTime tells the provides the total simulation time
 	    \param i the thread index
 	 */
 	void generateEvents(int totalTime, int myID){
+		generateEvents(totalTime, myID, time_);
+	}
+
+	/** \fn void generateEvents(int totalTime, int myID, int t)
+	    \brief creates events which are sent to random destination threads
+	    \param totalTime tells the provides the total simulation time
+	    \param i the thread index
+	    \param t the time step of the sending cell group
+	 */
+	void generateEvents(int totalTime, int myID, int t){
 	    //events can be generated with time range: (current time) to (current time + 10%)
 	    int diff(1);
 	    if(totalTime > 10)
 	        diff = rand() % (totalTime/10);
-	    /// Simulated target of a NetCon and the event time
+	    /// Simulated target of a NetCon (the j-th of the cell group) and the event time
 	    double tt = double();
-	    double data = double();
 	    int dst_nt = myID;
-	    for(int j=0; j < events_per_step_; ++j){
+	    int nevents = traffic_.events(events_per_step_);
+	    for(int j=0; j < nevents; ++j){
 			//set time_ to be some time in the future t + diff
-			tt = static_cast<double>(time_ + diff);
+			tt = static_cast<double>(t + diff);
 			if(percent_ITE_ > 0)
 			    dst_nt = chooseDst(myID);
 			else
 			    dst_nt = myID;
 
-			data = static_cast<double>(dst_nt);
-
 			if (dst_nt == myID)
-			    threadDatas[dst_nt].selfSend(data, tt);
-			else
-			    threadDatas[dst_nt].interThreadSend(data, tt + min_delay_);
+			    threadDatas[dst_nt]->selfSend(dst_nt, tt, j);
+			else {
+			    threadDatas[myID]->ite_sent_++;
+			    threadDatas[dst_nt]->interThreadSend(dst_nt, tt + min_delay_, j,
+			                                         &threadDatas[myID]->slab());
+			}
 	    }
 	}
 
@@ -176,12 +473,11 @@ public:
 			//serial distribution of spike events to inter-thread events
 			int num_spikes = min_delay_*threadDatas.size()*events_per_step_*percent_spike_/100;
 			int dst(0);
-			double data, tt;
+			double tt;
 			for(int i = 0; i < num_spikes; ++i){
 			   tt = (double)(time_ + diff + min_delay_);
 			   dst = rand() % threadDatas.size();
-			   data = (double)dst;
-			   threadDatas[dst].selfSend(data, tt);
+			   threadDatas[dst]->selfSend(dst, tt);
 			   all_spiked_++;
 			}
 	    }
@@ -189,15 +485,14 @@ public:
 
 	/** \fn int chooseDst(int myID)
 	    \brief Generates a random destination according to the variable percent_ITE_
+	    and the traffic model
 	    \param myID the thread index
 	    \return destination
 	 */
 	int chooseDst(int myID){
 	    int dst = myID;
-	    if ((rand() % 100) < percent_ITE_) //if destination is another thread
-		while(dst == myID)
-		    dst = rand() % threadDatas.size();
-
+	    if (threadDatas.size() > 1 && (rand() % 100) < percent_ITE_) //if destination is another thread
+		dst = traffic_.destination(myID, threadDatas.size());
 	    return dst;
 	}
 };
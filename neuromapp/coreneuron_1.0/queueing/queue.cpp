@@ -33,8 +33,8 @@
 
 namespace queueing {
 
-void queue::insert(double tt, double d) {
-    pq_que.push(event(d,tt));
+void queue::insert(double tt, int dst, int netcon) {
+    pq_que.push(event(dst,tt,netcon));
 }
 
 bool queue::atomic_dq(double tt, event& q) {
@@ -33,18 +33,37 @@
 #ifndef MAPP_CONTAINER_H_
 #define MAPP_CONTAINER_H_
 
+#ifdef NEUROMAPP_QUEUEING_LATENCY
+#include "coreneuron_1.0/queueing/histogram.h"
+#endif
+
 namespace queueing {
 
+/** \struct event
+    \brief 16 bytes without padding: the event time, the destination cell
+    group and the NetCon that delivers the event. With NEUROMAPP_QUEUEING_LATENCY
+    an event also carries the time it was handed over: sent to an inter-thread
+    queue or inserted in a heap, both construct a new event
+ */
 struct event {
-	/** \fn Event(double,double)
-	    \brief Initializes an event with data d and time t
-	    \param d event data
+	/** \fn event(int dst, double t, int netcon)
+	    \brief Initializes an event for the cell group dst at time t
+	    \param dst destination cell group
 	    \param t event time
+	    \param netcon index of the NetCon
 	 */
-	explicit event(double d=double(), double t=double(), bool s=false):data_(d),t_(t),set_(s){};
-	double data_;
+	explicit event(int dst=0, double t=double(), int netcon=0):t_(t),dst_(dst),netcon_(netcon)
+#ifdef NEUROMAPP_QUEUEING_LATENCY
+	,stamp_(now_ns())
+#endif
+	{};
 	double t_;
-    bool set_;
+	int dst_;
+	int netcon_;
+#ifdef NEUROMAPP_QUEUEING_LATENCY
+	/// wall clock time (ns) of the hand-over
+	unsigned long long stamp_;
+#endif
 };
 
 class queue {
@@ -68,12 +87,13 @@ public:
 	 */
 	bool atomic_dq(double til, event& q);
 
-	/** \fn void insert(double t, double data)
-	    \brief inserts an event with time t and data value
+	/** \fn void insert(double t, int dst, int netcon)
+	    \brief inserts an event with time t
 	    \param t the event time.
-	    \param data the event data.
+	    \param dst the destination cell group.
+	    \param netcon the NetCon of the event.
 	 */
-	void insert(double t, double data);
+	void insert(double t, int dst, int netcon=0);
 
 private:
 	std::priority_queue<event, std::vector<event>, is_more> pq_que;
@@ -25,6 +25,8 @@
 
 #include <pthread.h>
 
+#include "coreneuron_1.0/queueing/node_slab.h"
+
 #ifdef __APPLE__
 #include "coreneuron_1.0/queueing/spinlock_apple.h"
 #endif
@@ -40,6 +42,8 @@ public:
     struct node{
         T data;
         node* next;
+        /// the slab of the sender, NULL if allocated with new
+        node_slab<node>* slab;
     };
 
     spinlock_queue() : head_(NULL), size_(0) {pthread_spin_init(&lock_,0);}
@@ -49,7 +53,9 @@ public:
         while(head_ != NULL){
             node* temp = head_;
             head_ = head_ -> next;
-            delete temp;
+            // the slab nodes are freed with their slab
+            if(temp->slab == NULL)
+                delete temp;
         }
     }
 
@@ -57,12 +63,27 @@ public:
 
     void push(const T &data){
         node* n = new node;
-        n->data = data;
-        pthread_spin_lock(&lock_);
-        n->next = head_;
-        head_ = n;
-		++size_;
-        pthread_spin_unlock(&lock_);
+        n->slab = NULL;
+        push(n, data);
+    }
+
+    /** \fn void push(const T &data, node_slab<node>& slab)
+        \brief pushes data in a node of the slab of the sender
+     */
+    void push(const T &data, node_slab<node>& slab){
+        node* n = slab.allocate();
+        n->slab = &slab;
+        push(n, data);
+    }
+
+    /** \fn void release(node* n)
+        \brief frees a node returned by pop_all
+     */
+    static void release(node* n){
+        if(n->slab)
+            n->slab->deallocate(n);
+        else
+            delete n;
     }
 
     node* pop_all(void){
@@ -75,6 +96,15 @@ public:
     }
 
 private:
+    void push(node* n, const T &data){
+        n->data = data;
+        pthread_spin_lock(&lock_);
+        n->next = head_;
+        head_ = n;
+		++size_;
+        pthread_spin_unlock(&lock_);
+    }
+
     size_t size_;
     pthread_spinlock_t lock_;
     node* head_;
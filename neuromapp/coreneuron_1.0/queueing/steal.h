@@ -0,0 +1,143 @@
+/*
+ * Neuromapp - steal.h, Copyright (c), 2015,
+ * Kai Langen - Swiss Federal Institute of technology in Lausanne,
+ * kai.langen@epfl.ch,
+ * All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+
+/**
+ * @file neuromapp/coreneuron_1.0/queueing/steal.h
+ * \brief Contains the per-thread task deques of the work-stealing time step
+ */
+
+#ifndef MAPP_STEAL_H_
+#define MAPP_STEAL_H_
+
+#include <deque>
+
+#include "coreneuron_1.0/queueing/thread.h"
+#include "coreneuron_1.0/queueing/lock.h"
+
+namespace queueing {
+
+/** \class task_deques
+    \brief one deque of cell group indices per thread: a thread takes the last
+    of its own cell groups, an idle thread steals the first of another thread
+ */
+class task_deques {
+private:
+	struct task_deque {
+		std::deque<int> q_;
+		/// cell groups stolen by the owner of the deque
+		int steals_;
+#ifdef _OPENMP
+		OMPLock lock_;
+#else
+		DummyLock lock_;
+#endif
+		task_deque(): steals_(0) {}
+	};
+
+	/// the deques of two threads never share a cache line
+	std::vector<cache_line_padded<task_deque>*> deques_;
+
+	task_deques(task_deques const&);
+	task_deques& operator=(task_deques const&);
+
+public:
+	/** \fn task_deques(int nthreads)
+	    \param nthreads number of threads sharing the cell groups
+	 */
+	explicit task_deques(int nthreads): deques_(nthreads, NULL) {
+		for(int i=0; i < nthreads; ++i)
+			deques_[i] = new cache_line_padded<task_deque>();
+	}
+
+	~task_deques(){
+		for(int i=0; i < deques_.size(); ++i)
+			delete deques_[i];
+	}
+
+	/** \fn int size() const
+	    \return the number of threads
+	 */
+	int size() const {return deques_.size();}
+
+	/** \fn void push(int tid, int task)
+	    \brief gives the cell group task to the thread tid
+	 */
+	void push(int tid, int task){
+		task_deque& d = *deques_[tid];
+		d.lock_.acquire();
+		d.q_.push_back(task);
+		d.lock_.release();
+	}
+
+	/** \fn bool pop(int tid, int& task)
+	    \brief the thread tid takes the last of its cell groups
+	    \return false if the deque is empty
+	 */
+	bool pop(int tid, int& task){
+		task_deque& d = *deques_[tid];
+		bool found = false;
+		d.lock_.acquire();
+		if(!d.q_.empty()){
+			task = d.q_.back();
+			d.q_.pop_back();
+			found = true;
+		}
+		d.lock_.release();
+		return found;
+	}
+
+	/** \fn bool steal(int tid, int& task)
+	    \brief the thread tid takes the first cell group of the next thread
+	    which has one
+	    \return false if every deque is empty
+	 */
+	bool steal(int tid, int& task){
+		int n = deques_.size();
+		for(int k=1; k < n; ++k){
+			task_deque& victim = *deques_[(tid + k) % n];
+			bool found = false;
+			victim.lock_.acquire();
+			if(!victim.q_.empty()){
+				task = victim.q_.front();
+				victim.q_.pop_front();
+				found = true;
+			}
+			victim.lock_.release();
+			if(found){
+				deques_[tid]->steals_++;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	/** \fn int steals() const
+	    \return the number of cell groups stolen by all the threads
+	 */
+	int steals() const {
+		int sum = 0;
+		for(int i=0; i < deques_.size(); ++i)
+			sum += deques_[i]->steals_;
+		return sum;
+	}
+};
+
+}
+#endif
@@ -52,6 +52,48 @@ namespace queueing {
 
 enum implementation {mutex, spinlock};
 
+/** \struct cache_line_padded
+    \brief T padded up to a whole number of cache lines, so the members that
+    follow it start on a new line when the object is cache-line aligned
+ */
+template<class T>
+struct cache_line_padded : public T {
+	char pad_[cache_line_size - sizeof(T) % cache_line_size];
+};
+
+/** name of the dataset of the cell groups in the storage */
+const char nrnthread_name[] = "coreneuron_1.0_cstep_data";
+
+/** \fn NrnThread* load_nrnthread()
+    \brief gets the cstep dataset shared by the cell groups from the storage,
+    the first call loads it. It stays pinned in the storage until
+    release_nrnthread()
+    \return the dataset, the program exits if it cannot be opened
+ */
+inline NrnThread* load_nrnthread(){
+	std::string data = mapp::data_test();
+	std::vector<char> chardata(data.begin(), data.end());
+	chardata.push_back('\0');
+	NrnThread* nt = (NrnThread *) storage_acquire(nrnthread_name, make_nrnthread, &chardata[0],
+	                                              free_nrnthread, size_nrnthread);
+	if(nt == NULL){
+		std::cout<<"Error: Unable to open data file"<<std::endl;
+		storage_clear(nrnthread_name);
+		exit(EXIT_FAILURE);
+	}
+	return nt;
+}
+
+/** \fn void release_nrnthread()
+    \brief the cell group does not use the dataset of load_nrnthread() any more
+ */
+inline void release_nrnthread(){
+	storage_release(nrnthread_name);
+}
+
+/** slab of the inter-thread nodes sent by a cell group */
+typedef node_slab<spinlock_queue<event>::node> event_slab;
+
 template<implementation I>
 struct InterThread;
 
@@ -76,44 +118,82 @@ struct InterThread<spinlock>{
 template<implementation I>
 class NrnThreadData{
 private:
+	/// written by the sending threads, alone on its cache lines
+	cache_line_padded<InterThread<I> > inter_thread_events_;
+	/// everything below is only written by the owner thread
 	queue qe_;
 	NrnThread* nt_;
-	InterThread<I> inter_thread_events_;
+	/// true if nt_ is a private copy, freed with the cell group
+	bool own_nt_;
+	/// spikes of the current min_delay window, published to the other groups
+	std::vector<event> spikes_;
+	/// nodes of the inter-thread events this cell group sends
+	event_slab slab_;
+
+	// a private copy of the dataset is not shared between cell groups
+	NrnThreadData(NrnThreadData const&);
+	NrnThreadData& operator=(NrnThreadData const&);
 public:
+	/// inter-thread events moved into qe_ by enqueueMyEvents
 	int ite_received_;
+	/// inter-thread events this cell group sent to the others
+	int ite_sent_;
 	int enqueued_;
 	int delivered_;
+	/// spikes generated by this cell group in the windowed mode
+	int spiked_;
+#ifdef NEUROMAPP_QUEUEING_LATENCY
+	/// time (ns) from the inter-thread send to the enqueue in the heap
+	histogram transfer_;
+	/// time (ns) from the insertion in the heap to the delivery
+	histogram residency_;
+#endif
 
-	/** \fn NrnThreadData()
+	/** \fn NrnThreadData(bool with_algebra)
 	    \brief initializes NrnThreadData and creates a new priority queue
-	    \param i provides the thread id for this NrnThreadData
-	    \param verbose verbose mode: 1 = ON, 0 = OFF
+	    \param with_algebra if true the cell group works on its own copy of the
+	    dataset, allocated (first touched) by the calling thread, with the
+	    read-only index arrays shared, else it shares the copy of the storage
+	    read-only
 	 */
-	NrnThreadData(): ite_received_(0), enqueued_(0), delivered_(0) {
-		input_parameters p;
-		char name[] = "coreneuron_1.0_cstep_data";
-		std::string data = mapp::data_test();
-		p.name = name;
-
-		std::vector<char> chardata(data.begin(), data.end());
-		chardata.push_back('\0');
-		p.d = &chardata[0];
-                nt_ = (NrnThread *) storage_get(p.name, make_nrnthread, p.d, free_nrnthread);
-		if(nt_ == NULL){
-			std::cout<<"Error: Unable to open data file"<<std::endl;
-			storage_clear(p.name);
-			exit(EXIT_FAILURE);
+	explicit NrnThreadData(bool with_algebra=false):
+	own_nt_(with_algebra), ite_received_(0), ite_sent_(0), enqueued_(0), delivered_(0), spiked_(0) {
+		nt_ = load_nrnthread();
+		if(own_nt_){
+			nt_ = (NrnThread *) share_nrnthread(nt_);
+			if(nt_ == NULL){
+				std::cout<<"Error: Unable to copy the dataset"<<std::endl;
+				exit(EXIT_FAILURE);
+			}
 		}
 	}
 
-	/** \fn void selfSend(double d, double tt)
+	/** \fn ~NrnThreadData()
+	    \brief frees the copy of the dataset if the cell group owns one, and
+	    releases the dataset of the storage
+	 */
+	~NrnThreadData(){
+		// gives the inter-thread nodes back to their slab
+		enqueueMyEvents();
+		if(own_nt_)
+			free_nrnthread(nt_);
+		release_nrnthread();
+	}
+
+	/** \fn NrnThread* nrnthread()
+	 *  \return the dataset this cell group works on
+	 */
+	NrnThread* nrnthread(){return nt_;}
+
+	/** \fn void selfSend(int dst, double tt, int netcon)
 	 *  \brief send an item directly to my priority queue
-	 *  \param d the Event's data value
+	 *  \param dst the Event's destination, this cell group
 	 *  \param tt the Event's time value
+	 *  \param netcon the Event's NetCon
 	 **/
-	void selfSend(double d, double tt){
+	void selfSend(int dst, double tt, int netcon=0){
 		enqueued_++;
-		qe_.insert(tt, d);
+		qe_.insert(tt, dst, netcon);
 	}
 
 	/** \fn void l_algebra()
@@ -134,6 +214,32 @@ public:
    		mech_state_ProbAMPANMDA_EMS(nt_,&(nt_->ml[18]));
 	}
 
+	/** \fn void spike(int dst, double tt)
+	 *  \brief buffers a spike until the exchange at the end of the window
+	 *  \param dst the destination cell group
+	 *  \param tt the event time
+	 **/
+	void spike(int dst, double tt){
+		spiked_++;
+		spikes_.push_back(event(dst, tt));
+	}
+
+	/** \fn event_slab& slab()
+	 *  \return the slab of the inter-thread events sent by this cell group
+	 */
+	event_slab& slab(){return slab_;}
+
+	/** \fn std::vector<event> const& spikes() const
+	 *  \return the spikes of the current window, read by all the threads
+	 *  during the exchange
+	 */
+	std::vector<event> const& spikes() const {return spikes_;}
+
+	/** \fn void clearSpikes()
+	 *  \brief empties the spike buffer, once every thread gathered it
+	 */
+	void clearSpikes(){spikes_.clear();}
+
 	/** \fn bool deliver(int id, int til)
 	    \brief dequeue all items with time < til
 	    \param id used in sanity check to verify destination
@@ -144,7 +250,10 @@ public:
 		event q;
 		if(qe_.atomic_dq(til,q)){
 		    delivered_++;
-			assert((int)q.data_ == id);
+#ifdef NEUROMAPP_QUEUEING_LATENCY
+			residency_.record(now_ns() - q.stamp_);
+#endif
+			assert(q.dst_ == id);
 
 			// Use imitation of the point_receive calculation time (ms).
 			// Varies per a specific simulation case.
@@ -164,12 +273,15 @@ public:
 	 */
 	size_t PQSize(){return qe_.size();}
 
-	/** \fn void interThreadSend(double d, double tt)
-	    \brief sends an Event to the destination thread's array
-	    \param d the event's data value
+	/** \fn void interThreadSend(int dst, double tt, int netcon, event_slab* slab)
+	    \brief sends an Event to the destination thread's array, called by the
+	    sender: it must not touch the owner's counters
+	    \param dst the event's destination, this cell group
 	    \param tt the event's time value
+	    \param netcon the event's NetCon
+	    \param slab the slab of the sender for the linked-list node, new if NULL
 	 */
-	void interThreadSend(double d, double tt) {}
+	void interThreadSend(int dst, double tt, int netcon=0, event_slab* slab=NULL) {}
 
 	/** \fn void enqeueMyEvents()
 	    \brief (for this thread) push all the events from my
@@ -178,11 +290,11 @@ public:
 	void enqueueMyEvents() {}
 };
 
+/* the vector of the mutex queue holds the events, it does not use the slab */
 template<>
-inline void NrnThreadData<mutex>::interThreadSend(double d, double tt){
+inline void NrnThreadData<mutex>::interThreadSend(int dst, double tt, int netcon, event_slab* /*slab*/){
 	inter_thread_events_.lock_.acquire();
-	event ite(d,tt,true);
-	ite_received_++;
+	event ite(dst,tt,netcon);
 	inter_thread_events_.q_.push_back(ite);
 	inter_thread_events_.lock_.release();
 }
@@ -191,19 +303,28 @@ template<>
 inline void NrnThreadData<mutex>::enqueueMyEvents(){
 	inter_thread_events_.lock_.acquire();
 	event ite = event();
+#ifdef NEUROMAPP_QUEUEING_LATENCY
+	unsigned long long now = now_ns();
+#endif
 	for(int i = 0; i < inter_thread_events_.q_.size(); ++i){
 		ite = inter_thread_events_.q_[i];
-		selfSend(ite.data_, ite.t_);
+		ite_received_++;
+#ifdef NEUROMAPP_QUEUEING_LATENCY
+		transfer_.record(now - ite.stamp_);
+#endif
+		selfSend(ite.dst_, ite.t_, ite.netcon_);
 	}
 	inter_thread_events_.q_.clear();
 	inter_thread_events_.lock_.release();
 }
 
 template<>
-inline void NrnThreadData<spinlock>::interThreadSend(double d, double tt){
-	event ite(d,tt,true);
-	ite_received_++;
-	inter_thread_events_.q_.push(ite);
+inline void NrnThreadData<spinlock>::interThreadSend(int dst, double tt, int netcon, event_slab* slab){
+	event ite(dst,tt,netcon);
+	if(slab)
+		inter_thread_events_.q_.push(ite, *slab);
+	else
+		inter_thread_events_.q_.push(ite);
 }
 
 template<>
@@ -211,12 +332,19 @@ inline void NrnThreadData<spinlock>::enqueueMyEvents(){
 	spinlock_queue<event>::node* head = inter_thread_events_.q_.pop_all();
 	spinlock_queue<event>::node* elem = NULL;
 	event ite = event();
+#ifdef NEUROMAPP_QUEUEING_LATENCY
+	unsigned long long now = now_ns();
+#endif
 	while(head){
 		elem = head;
 		ite = elem->data;
-		selfSend(ite.data_, ite.t_);
+		ite_received_++;
+#ifdef NEUROMAPP_QUEUEING_LATENCY
+		transfer_.record(now - ite.stamp_);
+#endif
+		selfSend(ite.dst_, ite.t_, ite.netcon_);
 		head = head->next;
-		delete elem;
+		spinlock_queue<event>::release(elem);
 	}
 }
 
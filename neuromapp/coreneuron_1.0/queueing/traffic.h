@@ -0,0 +1,165 @@
+/*
+ * Neuromapp - traffic.h, Copyright (c), 2015,
+ * Kai Langen - Swiss Federal Institute of technology in Lausanne,
+ * kai.langen@epfl.ch,
+ * All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+
+/**
+ * @file neuromapp/coreneuron_1.0/queueing/traffic.h
+ * \brief Contains the traffic models: destinations of the inter-thread
+ * events and number of events per time step
+ */
+
+#ifndef MAPP_TRAFFIC_H_
+#define MAPP_TRAFFIC_H_
+
+#include <stdlib.h>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+namespace queueing {
+
+/** uniform: any other cell group, zipf: the cell group k is chosen with a
+    probability in 1/(k+1)^s, ring: one of the two neighbours, block: mostly
+    a cell group of the same community */
+enum traffic_model {uniform, zipf, ring, block};
+
+/** \fn bool traffic_model_from_string(std::string const& name, traffic_model& m)
+    \return false if the name is not a traffic model
+ */
+inline bool traffic_model_from_string(std::string const& name, traffic_model& m){
+	if(name == "uniform") m = uniform;
+	else if(name == "zipf") m = zipf;
+	else if(name == "ring") m = ring;
+	else if(name == "block") m = block;
+	else return false;
+	return true;
+}
+
+/** \class traffic
+    \brief draws the destination of the inter-thread events and the number of
+    events of a cell group per time step, with rand() as the rest of the pool
+ */
+class traffic {
+private:
+	traffic_model model_;
+	/// percentage of the inter-thread events sent to the cell group 0
+	int imbalance_;
+	/// exponent of the zipf model
+	double s_;
+	/// number of cell groups of a community in the block model
+	int block_size_;
+	/// percentage of the events sent inside the community in the block model
+	int locality_;
+	/// a cell group sends burst*eventsper events, one time step out of burst
+	int burst_;
+	/// cumulative distribution of the zipf model
+	std::vector<double> cdf_;
+
+	static double uniform01(){return rand() / (RAND_MAX + 1.0);}
+
+public:
+	/** \fn traffic(traffic_model m, int imbalance, double s, int block_size, int locality, int burst)
+	    \brief the default is the uniform traffic with a fixed number of events
+	 */
+	explicit traffic(traffic_model m=uniform, int imbalance=0, double s=1., int block_size=8,
+	                 int locality=90, int burst=1):
+	model_(m), imbalance_(imbalance), s_(s), block_size_(block_size), locality_(locality),
+	burst_(burst) {}
+
+	/** \fn void setup(int n)
+	    \brief prepares the distribution for n cell groups
+	 */
+	void setup(int n){
+		cdf_.clear();
+		if(model_ != zipf)
+			return;
+		double sum = 0.;
+		for(int k=0; k < n; ++k){
+			sum += 1. / std::pow(k + 1., s_);
+			cdf_.push_back(sum);
+		}
+		for(int k=0; k < n; ++k)
+			cdf_[k] /= sum;
+	}
+
+	/** \fn traffic_model model() const
+	    \return the destination model
+	 */
+	traffic_model model() const {return model_;}
+
+	/** \fn int destination(int myID, int n) const
+	    \brief chooses the destination of an inter-thread event
+	    \param myID the sending cell group
+	    \param n the number of cell groups, at least 2
+	    \return a cell group different from myID
+	 */
+	int destination(int myID, int n) const {
+		//skewed traffic: the cell group 0 receives a share of all the events
+		if(imbalance_ > 0 && myID != 0 && (rand() % 100) < imbalance_)
+			return 0;
+
+		int dst = myID;
+		switch(model_){
+			case zipf:
+				while(dst == myID){
+					dst = std::lower_bound(cdf_.begin(), cdf_.end(), uniform01()) - cdf_.begin();
+					dst = std::min(dst, n - 1);
+				}
+				break;
+			case ring:
+				dst = (myID + ((rand() % 2) ? 1 : n - 1)) % n;
+				break;
+			case block: {
+				int lo = myID / block_size_ * block_size_;
+				int hi = std::min(lo + block_size_, n);
+				bool inside = (rand() % 100) < locality_;
+				if(hi - lo == 1)
+					inside = false;
+				if(hi - lo == n)
+					inside = true;
+				if(inside){
+					while(dst == myID)
+						dst = lo + rand() % (hi - lo);
+				} else {
+					while(dst >= lo && dst < hi)
+						dst = rand() % n;
+				}
+				break;
+			}
+			default:
+				while(dst == myID)
+					dst = rand() % n;
+		}
+		return dst;
+	}
+
+	/** \fn int events(int mean) const
+	    \brief number of events of a cell group for one time step
+	    \param mean the average number of events per time step
+	 */
+	int events(int mean) const {
+		if(burst_ <= 1)
+			return mean;
+		return (rand() % burst_ == 0) ? burst_ * mean : 0;
+	}
+};
+
+}
+#endif
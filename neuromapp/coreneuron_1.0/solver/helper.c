@@ -36,10 +36,11 @@
 #include "coreneuron_1.0/solver/helper.h"
 #include "utils/error.h"
 int solver_print_usage() {
-    printf("usage: solver --data [string] --name [string]\n");
+    printf("usage: solver --data [string] --name [string] --alloc [string]\n");
     printf("details: \n");
     printf("                 --data [path to the input] \n");
     printf("                 --name [to internally reference the data, default name coreneuron_1.0_solver_data] \n");
+    printf("                 --alloc [default, hugepage, firsttouch or interleave, for the data loaded, with firsttouch the solver computes on a copy made by its thread] \n");
     return MAPP_USAGE;
 }
 
@@ -49,6 +50,7 @@ int solver_help(int argc, char* const argv[], struct input_parameters * p)
 
   p->d = "";
   p->name = "coreneuron_1.0_solver_data";
+  p->alloc = NRN_ALLOC_DEFAULT;
 
   optind = 0;
 
@@ -59,11 +61,12 @@ int solver_help(int argc, char* const argv[], struct input_parameters * p)
           {"help", no_argument, NULL, 'h'},
           {"data", required_argument,     NULL, 'd'},
           {"name", required_argument,     NULL, 'n'},
+          {"alloc", required_argument,    NULL, 'a'},
           {NULL, 0, NULL, 0}
       };
       /* getopt_long stores the option index here. */
       int option_index = 0;
-      c = getopt_long (argc, argv, "d:n:",
+      c = getopt_long (argc, argv, "d:n:a:",
                        long_options, &option_index);
       /* Detect the end of the options. */
       if (c == -1)
@@ -78,6 +81,10 @@ int solver_help(int argc, char* const argv[], struct input_parameters * p)
               break;
           case 'n': p->name = optarg;
               break;
+          case 'a':
+              if(nrn_alloc_policy_from_string(optarg, &p->alloc) != 0)
+                  return MAPP_BAD_ARG;
+              break;
           case 'h':
               return solver_print_usage();
               break;
@@ -30,6 +30,8 @@
 #ifndef MAPP_SOLVER_HELPER_
 #define MAPP_SOLVER_HELPER_
 
+#include "coreneuron_1.0/common/memory/memory.h"
+
 /** \struct input_parameters
     \brief contains the data provides by the user
  */
@@ -38,6 +40,8 @@ struct input_parameters{
     char * d;
     /** key for the storage */
     char * name;
+    /** allocation policy of the data set */
+    enum nrn_alloc_policy alloc;
 };
 
 /** \fn cstep_print_usage()
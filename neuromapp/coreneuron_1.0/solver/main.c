@@ -39,27 +39,46 @@
 #include "coreneuron_1.0/common/memory/nrnthread.h"
 #include "coreneuron_1.0/common/util/nrnthread_handler.h"
 #include "coreneuron_1.0/common/util/timer.h"
+#include "coreneuron_1.0/common/util/perf_counters.h"
 
 int coreneuron10_solver_execute(int argc, char * const argv[])
 {
     struct input_parameters p;
+    enum nrn_alloc_policy alloc;
     int error = MAPP_OK; //so far, so good
     error = solver_help(argc, argv, &p);
     if(error != MAPP_OK)
         return error;
 
-    NrnThread * nt = (NrnThread *) storage_get (p.name,  make_nrnthread, p.d, free_nrnthread);
+    alloc = nrn_get_alloc_policy();
+    nrn_set_alloc_policy(p.alloc);
+    NrnThread * nt = (NrnThread *) storage_acquire (p.name,  make_nrnthread, p.d, free_nrnthread, size_nrnthread);
 
     if(nt == NULL){
         storage_clear(p.name);
+        nrn_set_alloc_policy(alloc);
         return MAPP_BAD_DATA;
     }
+    /* the data loaded are placed by the loading thread, maybe a prefetch one:
+       first touch places a copy made by the thread that computes */
+    if(p.alloc == NRN_ALLOC_FIRSTTOUCH){
+        nt = (NrnThread *) clone_nrnthread(nt);
+        storage_put(p.name, nt, free_nrnthread);
+    }
+
+    struct perf_counters pc;
+    perf_counters_start(&pc);
     gettimeofday(&tvBegin, NULL);
     nrn_solve_minimal(nt);
     gettimeofday(&tvEnd, NULL);
+    perf_counters_stop(&pc);
 
     timeval_subtract(&tvDiff, &tvEnd, &tvBegin);
     printf("\n Time For Hines Solver : %ld [s] %ld [us]", tvDiff.tv_sec, (long) tvDiff.tv_usec);
+    storage_put_double(STORAGE_COMPUTE_TIME, tvDiff.tv_sec + 1e-6 * tvDiff.tv_usec);
+    perf_counters_print(&pc);
 
+    storage_release(p.name);
+    nrn_set_alloc_policy(alloc);
     return error;
 }
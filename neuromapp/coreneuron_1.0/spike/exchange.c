@@ -0,0 +1,299 @@
+/*
+ * Neuromapp - exchange.c, Copyright (c), 2015,
+ * Timothee Ewart - Swiss Federal Institute of technology in Lausanne,
+ * timothee.ewart@epfl.ch,
+ * All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+
+/**
+ * @file neuromapp/coreneuron_1.0/spike/exchange.c
+ * \brief Spike encodings and the variable-size allgather of the spike miniapp
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "coreneuron_1.0/spike/exchange.h"
+#include "utils/error.h"
+
+/** cache line size, the slots of the processes do not share a line */
+#define SPIKE_LINE 64
+
+/** \struct spike_header
+ *  \brief beginning of the shared memory segment
+ */
+struct spike_header {
+    /** monotonic barrier counter: window w is complete at (w+1)*nprocs */
+    long long arrived;
+    /** set by a process that failed, releases the waiting ones */
+    int abort;
+};
+
+static size_t round_line(size_t n){
+    return (n + SPIKE_LINE - 1) / SPIKE_LINE * SPIKE_LINE;
+}
+
+static size_t slot_size(struct spike_exchange const* ex){
+    /* the count is alone on the first line of the slot */
+    return SPIKE_LINE + round_line(ex->capacity * spike_encoding_size(&ex->enc));
+}
+
+static struct spike_header* header(struct spike_exchange const* ex){
+    return (struct spike_header*)ex->segment;
+}
+
+static struct spike_stats* stats(struct spike_exchange const* ex){
+    return (struct spike_stats*)((char*)ex->segment + SPIKE_LINE);
+}
+
+static long long* slot(struct spike_exchange const* ex, int rank, int window){
+    size_t offset = SPIKE_LINE + round_line(ex->nprocs * sizeof(struct spike_stats));
+    offset += (2 * rank + window % 2) * slot_size(ex);
+    return (long long*)((char*)ex->segment + offset);
+}
+
+int spike_encoding_init(struct spike_encoding* e, int compact, int steps, long long ngids, double dt){
+    e->compact = compact;
+    e->dt = dt;
+    e->tbits = 0;
+    while((1LL << e->tbits) < steps)
+        e->tbits++;
+    if(compact && ngids > (1LL << (32 - e->tbits))){
+        printf("Error: %lld cells and %d steps per window do not fit in 32 bits\n", ngids, steps);
+        return MAPP_BAD_ARG;
+    }
+    return MAPP_OK;
+}
+
+size_t spike_encoding_size(struct spike_encoding const* e){
+    return e->compact ? sizeof(uint32_t) : sizeof(struct spike_full);
+}
+
+void spike_encode(struct spike_encoding const* e, struct spike const* s, int n, double t0, void* buf){
+    int i;
+    if(e->compact){
+        uint32_t* w = (uint32_t*)buf;
+        for(i = 0; i < n; ++i)
+            w[i] = ((uint32_t)s[i].gid << e->tbits) | (uint32_t)s[i].step;
+    } else {
+        struct spike_full* f = (struct spike_full*)buf;
+        for(i = 0; i < n; ++i){
+            f[i].gid = s[i].gid;
+            f[i].t = t0 + s[i].step * e->dt;
+        }
+    }
+}
+
+void spike_decode(struct spike_encoding const* e, void const* buf, int n, double t0, struct spike* s){
+    int i;
+    if(e->compact){
+        uint32_t const* w = (uint32_t const*)buf;
+        uint32_t mask = (1u << e->tbits) - 1;
+        for(i = 0; i < n; ++i){
+            s[i].gid = (int)(w[i] >> e->tbits);
+            s[i].step = (int)(w[i] & mask);
+        }
+    } else {
+        struct spike_full const* f = (struct spike_full const*)buf;
+        for(i = 0; i < n; ++i){
+            s[i].gid = f[i].gid;
+            s[i].step = (int)((f[i].t - t0) / e->dt + 0.5);
+        }
+    }
+}
+
+int spike_exchange_shm_create(struct spike_exchange* ex, int nprocs, size_t capacity, struct spike_encoding const* e){
+    char name[64];
+    int fd;
+
+    memset(ex, 0, sizeof(*ex));
+    ex->nprocs = nprocs;
+    ex->capacity = capacity;
+    ex->enc = *e;
+    ex->segment_size = SPIKE_LINE + round_line(nprocs * sizeof(struct spike_stats))
+                     + 2 * nprocs * slot_size(ex);
+
+    snprintf(name, sizeof(name), "/neuromapp_spike_%d", (int)getpid());
+    fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+    if(fd == -1){
+        perror("shm_open");
+        return MAPP_UNKNOWN_ERROR;
+    }
+    /* the forked processes inherit the mapping, the name is not needed anymore */
+    shm_unlink(name);
+    if(ftruncate(fd, ex->segment_size) == -1){
+        perror("ftruncate");
+        close(fd);
+        return MAPP_UNKNOWN_ERROR;
+    }
+    ex->segment = mmap(NULL, ex->segment_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if(ex->segment == MAP_FAILED){
+        perror("mmap");
+        ex->segment = NULL;
+        return MAPP_UNKNOWN_ERROR;
+    }
+
+    ex->global = (struct spike*)malloc(nprocs * capacity * sizeof(struct spike));
+    if(ex->global == NULL){
+        spike_exchange_destroy(ex);
+        return MAPP_UNKNOWN_ERROR;
+    }
+    return MAPP_OK;
+}
+
+#ifdef NEUROMAPP_SPIKE_MPI
+int spike_exchange_mpi_create(struct spike_exchange* ex, size_t capacity, struct spike_encoding const* e){
+    int i;
+    size_t bytes;
+
+    memset(ex, 0, sizeof(*ex));
+    ex->mpi = 1;
+    MPI_Comm_rank(MPI_COMM_WORLD, &ex->rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &ex->nprocs);
+    ex->capacity = capacity;
+    ex->enc = *e;
+
+    bytes = capacity * spike_encoding_size(e);
+    for(i = 0; i < 2; ++i){
+        ex->sendbuf[i] = malloc(bytes);
+        ex->recvbuf[i] = malloc(ex->nprocs * bytes);
+        ex->counts[i] = (int*)malloc(ex->nprocs * sizeof(int));
+        ex->displs[i] = (int*)malloc(ex->nprocs * sizeof(int));
+        ex->req[i] = MPI_REQUEST_NULL;
+    }
+    ex->global = (struct spike*)malloc(ex->nprocs * capacity * sizeof(struct spike));
+    return MAPP_OK;
+}
+#endif
+
+void spike_exchange_publish(struct spike_exchange* ex, int window, struct spike const* s, int n, double t0){
+    long long* count;
+#ifdef NEUROMAPP_SPIKE_MPI
+    if(ex->mpi){
+        int p = window % 2;
+        int i, bytes = n * (int)spike_encoding_size(&ex->enc);
+        spike_encode(&ex->enc, s, n, t0, ex->sendbuf[p]);
+        MPI_Allgather(&bytes, 1, MPI_INT, ex->counts[p], 1, MPI_INT, MPI_COMM_WORLD);
+        ex->displs[p][0] = 0;
+        for(i = 1; i < ex->nprocs; ++i)
+            ex->displs[p][i] = ex->displs[p][i-1] + ex->counts[p][i-1];
+        MPI_Iallgatherv(ex->sendbuf[p], bytes, MPI_BYTE, ex->recvbuf[p], ex->counts[p],
+                        ex->displs[p], MPI_BYTE, MPI_COMM_WORLD, &ex->req[p]);
+        return;
+    }
+#endif
+    count = slot(ex, ex->rank, window);
+    spike_encode(&ex->enc, s, n, t0, (char*)count + SPIKE_LINE);
+    *count = n;
+    /* the release orders the slot before the arrival */
+    __atomic_fetch_add(&header(ex)->arrived, 1, __ATOMIC_RELEASE);
+}
+
+int spike_exchange_wait(struct spike_exchange* ex, int window){
+    long long target = (long long)(window + 1) * ex->nprocs;
+    struct spike_header* h;
+#ifdef NEUROMAPP_SPIKE_MPI
+    if(ex->mpi){
+        MPI_Wait(&ex->req[window % 2], MPI_STATUS_IGNORE);
+        return MAPP_OK;
+    }
+#endif
+    h = header(ex);
+    while(__atomic_load_n(&h->arrived, __ATOMIC_ACQUIRE) < target){
+        if(__atomic_load_n(&h->abort, __ATOMIC_RELAXED))
+            return MAPP_UNKNOWN_ERROR;
+        /* there may be more processes than cores */
+        sched_yield();
+    }
+    return MAPP_OK;
+}
+
+int spike_exchange_gather(struct spike_exchange* ex, int window, double t0){
+    int r, n, total = 0;
+    for(r = 0; r < ex->nprocs; ++r){
+        void const* buf;
+#ifdef NEUROMAPP_SPIKE_MPI
+        if(ex->mpi){
+            int p = window % 2;
+            size_t size = spike_encoding_size(&ex->enc);
+            n = ex->counts[p][r] / (int)size;
+            buf = (char const*)ex->recvbuf[p] + ex->displs[p][r];
+        } else
+#endif
+        {
+            long long const* count = slot(ex, r, window);
+            n = (int)*count;
+            buf = (char const*)count + SPIKE_LINE;
+        }
+        spike_decode(&ex->enc, buf, n, t0, ex->global + total);
+        total += n;
+    }
+    return total;
+}
+
+int spike_exchange_stats(struct spike_exchange* ex, int nwindows, struct spike_stats const* mine, struct spike_stats* all){
+    int error = MAPP_OK;
+#ifdef NEUROMAPP_SPIKE_MPI
+    if(ex->mpi){
+        MPI_Gather((void*)mine, sizeof(*mine), MPI_BYTE, all, sizeof(*mine), MPI_BYTE, 0, MPI_COMM_WORLD);
+        return MAPP_OK;
+    }
+#endif
+    /* one more generation of the barrier after the last window */
+    stats(ex)[ex->rank] = *mine;
+    __atomic_fetch_add(&header(ex)->arrived, 1, __ATOMIC_RELEASE);
+    if(ex->rank == 0){
+        error = spike_exchange_wait(ex, nwindows);
+        if(error == MAPP_OK)
+            memcpy(all, stats(ex), ex->nprocs * sizeof(struct spike_stats));
+    }
+    return error;
+}
+
+void spike_exchange_abort(struct spike_exchange* ex){
+#ifdef NEUROMAPP_SPIKE_MPI
+    if(ex->mpi){
+        MPI_Abort(MPI_COMM_WORLD, MAPP_UNKNOWN_ERROR);
+        return;
+    }
+#endif
+    __atomic_store_n(&header(ex)->abort, 1, __ATOMIC_RELAXED);
+}
+
+void spike_exchange_destroy(struct spike_exchange* ex){
+#ifdef NEUROMAPP_SPIKE_MPI
+    int i;
+    for(i = 0; i < 2; ++i){
+        free(ex->sendbuf[i]);
+        free(ex->recvbuf[i]);
+        free(ex->counts[i]);
+        free(ex->displs[i]);
+    }
+#endif
+    if(ex->segment)
+        munmap(ex->segment, ex->segment_size);
+    free(ex->global);
+    ex->segment = NULL;
+    ex->global = NULL;
+}
@@ -0,0 +1,183 @@
+/*
+ * Neuromapp - exchange.h, Copyright (c), 2015,
+ * Timothee Ewart - Swiss Federal Institute of technology in Lausanne,
+ * timothee.ewart@epfl.ch,
+ * All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+
+/**
+ * @file neuromapp/coreneuron_1.0/spike/exchange.h
+ * \brief Spike encodings and the variable-size allgather of the spike miniapp
+ *
+ * Every process publishes the spikes of a min delay window, then gathers
+ * the spikes of all processes. The shared memory backend gives every process
+ * two slots (double buffering on the parity of the window) in one POSIX shared
+ * memory segment, created before the processes are forked, and synchronizes
+ * them with a split arrive/wait barrier on a monotonic counter. The MPI
+ * backend uses MPI_Allgather for the counts and MPI_Iallgatherv for the spikes.
+ */
+
+#ifndef MAPP_SPIKE_EXCHANGE_
+#define MAPP_SPIKE_EXCHANGE_
+
+#include <stddef.h>
+
+#ifdef NEUROMAPP_SPIKE_MPI
+#include <mpi.h>
+#endif
+
+/** \struct spike
+ *  \brief a spike of a window: global cell id and time step in the window
+ */
+struct spike {
+    int gid;
+    int step;
+};
+
+/** \struct spike_full
+ *  \brief exchanged spike in the full encoding, as NRNMPI_Spike of coreneuron
+ */
+struct spike_full {
+    int gid;
+    double t;
+};
+
+/** \struct spike_encoding
+ *  \brief how the spikes are written in the exchange buffers, the compact
+ *  encoding packs the gid and the time step in the window in 32 bits
+ */
+struct spike_encoding {
+    /** 1 for the 32 bits encoding */
+    int compact;
+    /** number of bits of the time step in the compact encoding */
+    int tbits;
+    /** time step (ms) */
+    double dt;
+};
+
+/** \struct spike_stats
+ *  \brief what a process reports to the rank 0 at the end of the run
+ */
+struct spike_stats {
+    long long generated;
+    long long received;
+    /** sum of gid + time step of the generated spikes */
+    long long gen_checksum;
+    /** sum of gid + time step of the gathered spikes */
+    long long recv_checksum;
+    /** times in ms */
+    double compute;
+    double exchange;
+    double wait;
+};
+
+/** \struct spike_exchange
+ *  \brief state of the allgather of one process
+ */
+struct spike_exchange {
+    int rank;
+    int nprocs;
+    /** maximum number of spikes a process publishes per window */
+    size_t capacity;
+    struct spike_encoding enc;
+    /** decoded spikes of all the processes, after spike_exchange_gather */
+    struct spike* global;
+    /** shared memory segment, NULL with MPI */
+    void* segment;
+    size_t segment_size;
+#ifdef NEUROMAPP_SPIKE_MPI
+    int mpi;
+    void* sendbuf[2];
+    void* recvbuf[2];
+    int* counts[2];
+    int* displs[2];
+    MPI_Request req[2];
+#endif
+};
+
+/** \fn int spike_encoding_init(struct spike_encoding* e, int compact, int steps, long long ngids, double dt)
+    \brief chooses the bit split of the compact encoding
+    \param steps number of time steps in a window
+    \param ngids number of cells
+    \return MAPP_BAD_ARG if the cells and steps do not fit in 32 bits
+ */
+int spike_encoding_init(struct spike_encoding* e, int compact, int steps, long long ngids, double dt);
+
+/** \fn size_t spike_encoding_size(struct spike_encoding const* e)
+    \return number of bytes of an encoded spike
+ */
+size_t spike_encoding_size(struct spike_encoding const* e);
+
+/** \fn void spike_encode(struct spike_encoding const* e, struct spike const* s, int n, double t0, void* buf)
+    \brief writes n spikes of the window starting at t0 in buf
+ */
+void spike_encode(struct spike_encoding const* e, struct spike const* s, int n, double t0, void* buf);
+
+/** \fn void spike_decode(struct spike_encoding const* e, void const* buf, int n, double t0, struct spike* s)
+    \brief reads n spikes of the window starting at t0 from buf
+ */
+void spike_decode(struct spike_encoding const* e, void const* buf, int n, double t0, struct spike* s);
+
+/** \fn int spike_exchange_shm_create(struct spike_exchange* ex, int nprocs, size_t capacity, struct spike_encoding const* e)
+    \brief creates the shared memory segment, must be called before fork,
+    the rank is 0 and must be set by the forked processes
+    \return MAPP_UNKNOWN_ERROR if the segment cannot be created
+ */
+int spike_exchange_shm_create(struct spike_exchange* ex, int nprocs, size_t capacity, struct spike_encoding const* e);
+
+#ifdef NEUROMAPP_SPIKE_MPI
+/** \fn int spike_exchange_mpi_create(struct spike_exchange* ex, size_t capacity, struct spike_encoding const* e)
+    \brief allocates the buffers of the MPI backend, rank and size of MPI_COMM_WORLD
+ */
+int spike_exchange_mpi_create(struct spike_exchange* ex, size_t capacity, struct spike_encoding const* e);
+#endif
+
+/** \fn void spike_exchange_publish(struct spike_exchange* ex, int window, struct spike const* s, int n, double t0)
+    \brief encodes the spikes of the window and arrives on its barrier (starts
+    the allgather with MPI), returns without waiting for the other processes
+ */
+void spike_exchange_publish(struct spike_exchange* ex, int window, struct spike const* s, int n, double t0);
+
+/** \fn int spike_exchange_wait(struct spike_exchange* ex, int window)
+    \brief waits until every process published the window
+    \return MAPP_UNKNOWN_ERROR if a process aborted
+ */
+int spike_exchange_wait(struct spike_exchange* ex, int window);
+
+/** \fn int spike_exchange_gather(struct spike_exchange* ex, int window, double t0)
+    \brief decodes the spikes of all the processes in ex->global
+    \return the number of spikes of the window
+ */
+int spike_exchange_gather(struct spike_exchange* ex, int window, double t0);
+
+/** \fn int spike_exchange_stats(struct spike_exchange* ex, int nwindows, struct spike_stats const* mine, struct spike_stats* all)
+    \brief collects the statistics of all the processes on rank 0
+    \param all nprocs entries, filled on rank 0 only
+    \return MAPP_UNKNOWN_ERROR if a process aborted
+ */
+int spike_exchange_stats(struct spike_exchange* ex, int nwindows, struct spike_stats const* mine, struct spike_stats* all);
+
+/** \fn void spike_exchange_abort(struct spike_exchange* ex)
+    \brief releases the processes waiting on the barrier, with an error
+ */
+void spike_exchange_abort(struct spike_exchange* ex);
+
+/** \fn void spike_exchange_destroy(struct spike_exchange* ex)
+    \brief unmaps the segment and frees the buffers
+ */
+void spike_exchange_destroy(struct spike_exchange* ex);
+
+#endif
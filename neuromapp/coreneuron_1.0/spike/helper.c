@@ -0,0 +1,155 @@
+/*
+ * Neuromapp - helper.c, Copyright (c), 2015,
+ * Timothee Ewart - Swiss Federal Institute of technology in Lausanne,
+ * timothee.ewart@epfl.ch,
+ * All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+
+/**
+ * @file neuromapp/coreneuron_1.0/spike/helper.c
+ * \brief Implements the helper of the spike miniapp
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <getopt.h>
+#include <unistd.h>
+
+#include "coreneuron_1.0/spike/helper.h"
+#include "utils/error.h"
+
+int spike_print_usage() {
+    printf("Usage: spike [--procs int] [--groups int] [--cells int] [--rate double] [--tstop double]\n");
+    printf("             [--dt double] [--min-delay double] [--work int] [--compact] [--overlap] [--mpi]\n");
+    printf("Details: \n");
+    printf("                 --procs <number of processes, default 4>\n");
+    printf("                 --groups <number of cell groups per process, default 4>\n");
+    printf("                 --cells <number of cells per cell group, default 256>\n");
+    printf("                 --rate <mean firing rate in Hz, default 10>\n");
+    printf("                 --tstop <simulation time in ms, default 100>\n");
+    printf("                 --dt <time step in ms, default 0.025>\n");
+    printf("                 --min-delay <ms between two exchanges, default 1>\n");
+    printf("                 --work <arithmetic iterations per cell and time step, default 4>\n");
+    printf("                 --compact [exchange 32 bits spikes instead of (gid, time)]\n");
+    printf("                 --overlap [overlap the exchange with the next window]\n");
+#ifdef NEUROMAPP_SPIKE_MPI
+    printf("                 --mpi [exchange with MPI_Allgatherv, run with mpirun]\n");
+#endif
+    return MAPP_USAGE;
+}
+
+int spike_help(int argc, char * const argv[], struct input_parameters * p)
+{
+  int c;
+  p->procs = 4;
+  p->groups = 4;
+  p->cells = 256;
+  p->rate = 10.;
+  p->tstop = 100.;
+  p->dt = 0.025;
+  p->min_delay = 1.;
+  p->work = 4;
+  p->compact = 0;
+  p->overlap = 0;
+  p->mpi = 0;
+
+  optind = 0;
+
+  while (1)
+  {
+      static struct option long_options[] =
+      {
+          {"help", no_argument, 0, 'h'},
+          {"procs", required_argument, 0, 'p'},
+          {"groups", required_argument, 0, 'g'},
+          {"cells", required_argument, 0, 'c'},
+          {"rate", required_argument, 0, 'r'},
+          {"tstop", required_argument, 0, 's'},
+          {"dt", required_argument, 0, 't'},
+          {"min-delay", required_argument, 0, 'm'},
+          {"work", required_argument, 0, 'w'},
+          {"compact", no_argument, 0, 'k'},
+          {"overlap", no_argument, 0, 'o'},
+          {"mpi", no_argument, 0, 'i'},
+
+          {0, 0, 0, 0}
+      };
+      /* getopt_long stores the option index here. */
+      int option_index = 0;
+
+      c = getopt_long (argc, argv, "p:g:c:r:s:t:m:w:koi",
+                       long_options, &option_index);
+      /* Detect the end of the options. */
+      if (c == -1)
+        break;
+
+      switch (c)
+      {
+          case 'p':
+              p->procs = atoi(optarg);
+              break;
+          case 'g':
+              p->groups = atoi(optarg);
+              break;
+          case 'c':
+              p->cells = atoi(optarg);
+              break;
+          case 'r':
+              p->rate = atof(optarg);
+              break;
+          case 's':
+              p->tstop = atof(optarg);
+              break;
+          case 't':
+              p->dt = atof(optarg);
+              break;
+          case 'm':
+              p->min_delay = atof(optarg);
+              break;
+          case 'w':
+              p->work = atoi(optarg);
+              break;
+          case 'k':
+              p->compact = 1;
+              break;
+          case 'o':
+              p->overlap = 1;
+              break;
+          case 'i':
+#ifdef NEUROMAPP_SPIKE_MPI
+              p->mpi = 1;
+              break;
+#else
+              printf("The spike miniapp is compiled without MPI (NEUROMAPP_SPIKE_MPI) \n");
+              return MAPP_BAD_ARG;
+#endif
+          case 'h':
+              return spike_print_usage();
+              break;
+          default:
+              return spike_print_usage();
+              break;
+      }
+  }
+
+  if(p->procs < 1 || p->groups < 1 || p->cells < 1 || p->work < 0)
+      return MAPP_BAD_ARG;
+
+  if(p->rate < 0. || p->tstop <= 0. || p->dt <= 0. || p->min_delay < p->dt)
+      return MAPP_BAD_ARG;
+
+  return MAPP_OK;
+}
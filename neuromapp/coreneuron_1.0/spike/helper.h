@@ -0,0 +1,88 @@
+/*
+ * Neuromapp - helper.h, Copyright (c), 2015,
+ * Timothee Ewart - Swiss Federal Institute of technology in Lausanne,
+ * timothee.ewart@epfl.ch,
+ * All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+
+/**
+ * @file neuromapp/coreneuron_1.0/spike/helper.h
+ * \brief Implements the helper of the spike miniapp
+ */
+
+#ifndef MAPP_SPIKE_HELPER_
+#define MAPP_SPIKE_HELPER_
+
+/** \struct input_parameters
+ *  \brief contains the data provides by the user
+ */
+struct input_parameters{
+    /** number of processes, ignored by the MPI backend
+     \warning The default value is 4
+     */
+    int procs;
+    /** number of cell groups per process
+     \warning The default value is 4
+     */
+    int groups;
+    /** number of cells per cell group
+     \warning The default value is 256
+     */
+    int cells;
+    /** mean firing rate of a cell (Hz)
+     \warning The default value is 10 Hz
+     */
+    double rate;
+    /** simulation time (ms)
+     \warning The default value is 100 ms
+     */
+    double tstop;
+    /** time step (ms)
+     \warning The default value is 0.025 ms
+     */
+    double dt;
+    /** minimum delay between two exchanges (ms)
+     \warning The default value is 1 ms
+     */
+    double min_delay;
+    /** number of arithmetic iterations per cell and per time step
+     \warning The default value is 4
+     */
+    int work;
+    /** 1 if the spikes are exchanged in 32 bits, else (gid, time) */
+    int compact;
+    /** 1 if the exchange overlaps the computation of the next window */
+    int overlap;
+    /** 1 if the exchange uses MPI instead of fork + shared memory */
+    int mpi;
+};
+
+/** \fn spike_print_usage()
+    \brief Print the usage of the spike function
+    \return error code MAPP_USAGE
+ */
+int spike_print_usage();
+
+/** \fn int spike_help(int argc, char * const argv[], struct input_parameters * p)
+    \brief Interpret the command line and extract/set up the needed parameter
+    \param argc The number of argument in the command line
+    \param the command line
+    \param p the structure where the input data are saved
+    \return may return error code MAPP_BAD_ARG if the arguments are wrong
+ */
+int spike_help(int argc, char * const argv[], struct input_parameters * p);
+
+#endif
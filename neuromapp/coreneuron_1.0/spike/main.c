@@ -0,0 +1,348 @@
+/*
+ * Neuromapp - main.c, Copyright (c), 2015,
+ * Timothee Ewart - Swiss Federal Institute of technology in Lausanne,
+ * timothee.ewart@epfl.ch,
+ * All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+
+/**
+ * @file neuromapp/coreneuron_1.0/spike/main.c
+ * \brief Implements a miniapp reproducing the spike exchange of coreneuron 1.0:
+ * every process integrates its cell groups during a min delay window, then
+ * the spikes of the window are exchanged with a variable-size allgather
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "coreneuron_1.0/spike/spike.h"
+#include "coreneuron_1.0/spike/helper.h"
+#include "coreneuron_1.0/spike/exchange.h"
+#include "utils/error.h"
+
+/** \struct spike_run
+ *  \brief the schedule of the simulation, the same on every process
+ */
+struct spike_run {
+    /** time steps per window */
+    int steps;
+    /** total number of time steps */
+    int nsteps;
+    int nwindows;
+    /** cells of a process */
+    int ncells;
+};
+
+static double now_ms(){
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return 1000. * tv.tv_sec + tv.tv_usec / 1000.;
+}
+
+/** xorshift64*, every process draws its own deterministic stream */
+static double uniform(unsigned long long* x){
+    *x ^= *x >> 12;
+    *x ^= *x << 25;
+    *x ^= *x >> 27;
+    return ((*x * 2685821657736338717ULL) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/** \fn int compute_window(struct input_parameters const* p, int steps, int gid0, double* v, unsigned long long* seed, struct spike* spikes)
+    \brief integrates the cell groups of a process during the steps of a window,
+    a cell spikes with probability rate*dt
+    \param gid0 global id of the first cell of the process
+    \param v state of the cells
+    \param spikes filled with the spikes of the window
+    \return the number of spikes of the window
+ */
+static int compute_window(struct input_parameters const* p, int steps, int gid0, double* v, unsigned long long* seed,
+                          struct spike* spikes){
+    int n = 0;
+    int step, g, c, k;
+    double pspike = p->rate * p->dt / 1000.;
+    for(step = 0; step < steps; ++step){
+        for(g = 0; g < p->groups; ++g){
+            double* vg = v + g * p->cells;
+            for(c = 0; c < p->cells; ++c){
+                double x = vg[c];
+                for(k = 0; k < p->work; ++k)
+                    x = x * 0.999 + 0.001;
+                vg[c] = x;
+                if(uniform(seed) < pspike){
+                    spikes[n].gid = gid0 + g * p->cells + c;
+                    spikes[n].step = step;
+                    ++n;
+                }
+            }
+        }
+    }
+    return n;
+}
+
+/** \fn long long checksum(struct spike const* s, int n, int offset)
+    \return sum of gid + global time step of the spikes
+ */
+static long long checksum(struct spike const* s, int n, int offset){
+    long long sum = 0;
+    int i;
+    for(i = 0; i < n; ++i)
+        sum += s[i].gid + offset + s[i].step;
+    return sum;
+}
+
+/** \fn int exchange_window(...)
+    \brief waits for the allgather of a window and gathers the spikes of all
+    the processes
+ */
+static int exchange_window(struct input_parameters const* p, struct spike_run const* run,
+                           struct spike_exchange* ex, int w, struct spike_stats* st){
+    int n, error;
+    double t0 = now_ms();
+    error = spike_exchange_wait(ex, w);
+    st->wait += now_ms() - t0;
+    if(error != MAPP_OK)
+        return error;
+
+    t0 = now_ms();
+    n = spike_exchange_gather(ex, w, w * run->steps * p->dt);
+    st->received += n;
+    st->recv_checksum += checksum(ex->global, n, w * run->steps);
+    st->exchange += now_ms() - t0;
+    return MAPP_OK;
+}
+
+/** \fn int run_rank(...)
+    \brief the simulation of one process: the exchange of a window follows its
+    computation, or overlaps the computation of the next window
+    \param all the statistics of all the processes, filled on rank 0
+ */
+static int run_rank(struct input_parameters const* p, struct spike_run const* run,
+                    struct spike_exchange* ex, struct spike_stats* all){
+    struct spike_stats st;
+    struct spike* spikes;
+    double* v;
+    double t0;
+    int w, i, n, steps, error = MAPP_OK;
+    int gid0 = ex->rank * run->ncells;
+    unsigned long long seed = 0x9E3779B97F4A7C15ULL * (unsigned long long)(ex->rank + 1);
+
+    memset(&st, 0, sizeof(st));
+    spikes = (struct spike*)malloc(ex->capacity * sizeof(struct spike));
+    v = (double*)malloc(run->ncells * sizeof(double));
+    if(spikes == NULL || v == NULL){
+        free(spikes);
+        free(v);
+        spike_exchange_abort(ex);
+        return MAPP_UNKNOWN_ERROR;
+    }
+    for(i = 0; i < run->ncells; ++i)
+        v[i] = uniform(&seed);
+
+    for(w = 0; w < run->nwindows && error == MAPP_OK; ++w){
+        steps = run->nsteps - w * run->steps;
+        if(steps > run->steps)
+            steps = run->steps;
+
+        t0 = now_ms();
+        n = compute_window(p, steps, gid0, v, &seed, spikes);
+        st.compute += now_ms() - t0;
+        st.generated += n;
+        st.gen_checksum += checksum(spikes, n, w * run->steps);
+
+        /* the allgather of the previous window ran during the computation */
+        if(p->overlap && w > 0)
+            error = exchange_window(p, run, ex, w - 1, &st);
+
+        t0 = now_ms();
+        spike_exchange_publish(ex, w, spikes, n, w * run->steps * p->dt);
+        st.exchange += now_ms() - t0;
+
+        if(!p->overlap && error == MAPP_OK)
+            error = exchange_window(p, run, ex, w, &st);
+    }
+    if(p->overlap && error == MAPP_OK)
+        error = exchange_window(p, run, ex, run->nwindows - 1, &st);
+
+    if(error == MAPP_OK)
+        error = spike_exchange_stats(ex, run->nwindows, &st, all);
+    else
+        spike_exchange_abort(ex);
+
+    free(spikes);
+    free(v);
+    return error;
+}
+
+/** \fn int spike_report(...)
+    \brief checks on rank 0 that every process gathered all the spikes, and
+    prints the time split between compute, exchange and wait
+    \return MAPP_UNKNOWN_ERROR if a spike was lost
+ */
+static int spike_report(struct input_parameters const* p, struct spike_run const* run,
+                        struct spike_exchange const* ex, struct spike_stats const* all){
+    long long generated = 0, checksum = 0;
+    double compute = 0., exchange = 0., wait = 0.;
+    int r, error = MAPP_OK;
+    size_t size = spike_encoding_size(&ex->enc);
+
+    for(r = 0; r < ex->nprocs; ++r){
+        generated += all[r].generated;
+        checksum += all[r].gen_checksum;
+        compute += all[r].compute;
+        exchange += all[r].exchange;
+        wait += all[r].wait;
+    }
+    for(r = 0; r < ex->nprocs; ++r)
+        if(all[r].received != generated || all[r].recv_checksum != checksum){
+            printf("Error: process %d gathered %lld spikes out of %lld \n", r, all[r].received, generated);
+            error = MAPP_UNKNOWN_ERROR;
+        }
+
+    printf("\nSpike exchange: %d processes (%s), %d cells, %d windows of %d steps \n",
+           ex->nprocs, p->mpi ? "MPI" : "shared memory", run->ncells * ex->nprocs,
+           run->nwindows, run->steps);
+    printf("Encoding: %s, %d bytes per spike, overlap: %s \n", p->compact ? "compact" : "full",
+           (int)size, p->overlap ? "on" : "off");
+    printf("Spikes: %lld, bytes gathered per process: %lld \n", generated, generated * (long long)size);
+    printf("Time per process (average): compute %f [ms], exchange %f [ms], wait %f [ms] \n",
+           compute / ex->nprocs, exchange / ex->nprocs, wait / ex->nprocs);
+    return error;
+}
+
+/** \fn int spike_shm(struct input_parameters const* p, struct spike_run const* run, struct spike_encoding const* e)
+    \brief forks the processes, the calling one is rank 0
+ */
+static int spike_shm(struct input_parameters const* p, struct spike_run const* run,
+                     struct spike_encoding const* e){
+    struct spike_exchange ex;
+    struct spike_stats* all;
+    pid_t* pids;
+    int r, status, nforked = 0;
+    int error = spike_exchange_shm_create(&ex, p->procs, (size_t)run->ncells * run->steps, e);
+    if(error != MAPP_OK)
+        return error;
+
+    all = (struct spike_stats*)malloc(p->procs * sizeof(struct spike_stats));
+    pids = (pid_t*)malloc(p->procs * sizeof(pid_t));
+
+    /* the children must not flush the buffers of the parent */
+    fflush(stdout);
+    fflush(stderr);
+    for(r = 1; r < p->procs; ++r){
+        pid_t pid = fork();
+        if(pid == 0){
+            ex.rank = r;
+            _exit(run_rank(p, run, &ex, all));
+        }
+        if(pid < 0){
+            perror("fork");
+            spike_exchange_abort(&ex);
+            error = MAPP_UNKNOWN_ERROR;
+            break;
+        }
+        pids[nforked++] = pid;
+    }
+
+    if(error == MAPP_OK)
+        error = run_rank(p, run, &ex, all);
+
+    for(r = 0; r < nforked; ++r){
+        if(waitpid(pids[r], &status, 0) == -1 || !WIFEXITED(status) || WEXITSTATUS(status) != MAPP_OK)
+            error = MAPP_UNKNOWN_ERROR;
+    }
+
+    if(error == MAPP_OK)
+        error = spike_report(p, run, &ex, all);
+
+    free(pids);
+    free(all);
+    spike_exchange_destroy(&ex);
+    return error;
+}
+
+#ifdef NEUROMAPP_SPIKE_MPI
+static void spike_mpi_finalize(){
+    MPI_Finalize();
+}
+
+/** \fn int spike_mpi(struct input_parameters const* p, struct spike_run const* run, struct spike_encoding const* e)
+    \brief one process per MPI rank
+ */
+static int spike_mpi(struct input_parameters const* p, struct spike_run const* run,
+                     struct spike_encoding const* e){
+    struct spike_exchange ex;
+    struct spike_stats* all;
+    int error = spike_exchange_mpi_create(&ex, (size_t)run->ncells * run->steps, e);
+    if(error != MAPP_OK)
+        return error;
+
+    all = (struct spike_stats*)malloc(ex.nprocs * sizeof(struct spike_stats));
+    error = run_rank(p, run, &ex, all);
+    if(error == MAPP_OK && ex.rank == 0)
+        error = spike_report(p, run, &ex, all);
+    MPI_Bcast(&error, 1, MPI_INT, 0, MPI_COMM_WORLD);
+
+    free(all);
+    spike_exchange_destroy(&ex);
+    return error;
+}
+#endif
+
+int coreneuron10_spike_execute(int argc, char * const argv[]) {
+    struct input_parameters p;
+    struct spike_run run;
+    struct spike_encoding e;
+    int nprocs;
+
+    int error = MAPP_OK;
+    error = spike_help(argc, argv, &p);
+    if(error != MAPP_OK)
+        return error;
+
+    run.steps = (int)(p.min_delay / p.dt + 0.5);
+    run.nsteps = (int)(p.tstop / p.dt + 0.5);
+    run.nwindows = (run.nsteps + run.steps - 1) / run.steps;
+    run.ncells = p.groups * p.cells;
+
+    nprocs = p.procs;
+#ifdef NEUROMAPP_SPIKE_MPI
+    /* MPI cannot be initialized twice, it is finalized at exit */
+    if(p.mpi){
+        int initialized;
+        MPI_Initialized(&initialized);
+        if(!initialized){
+            MPI_Init(NULL, NULL);
+            atexit(spike_mpi_finalize);
+        }
+        MPI_Comm_size(MPI_COMM_WORLD, &nprocs);
+    }
+#endif
+
+    error = spike_encoding_init(&e, p.compact, run.steps, (long long)run.ncells * nprocs, p.dt);
+    if(error != MAPP_OK)
+        return error;
+
+#ifdef NEUROMAPP_SPIKE_MPI
+    if(p.mpi)
+        return spike_mpi(&p, &run, &e);
+#endif
+    return spike_shm(&p, &run, &e);
+}
@@ -35,24 +35,113 @@ extern "C" {
 
 #include <iostream>
 
+#include <boost/atomic.hpp>
+
+/**
+ * constructor of the storage class
+ */
+storage::storage(): clock_(0), hits_(0), misses_(0), evictions_(0), budget_(0), used_(0) {
+    pthread_rwlock_init(&lock_, NULL);
+    pthread_mutex_init(&use_mutex_, NULL);
+    pthread_mutex_init(&build_mutex_, NULL);
+    pthread_cond_init(&built_, NULL);
+}
+
 /**
  * destructor of the storage class
  */
 storage::~storage() {
-    for (storage_map::iterator i=M.begin();i!=M.end();++i) i->second.destroy();
+    // the prefetch threads write in M
+    {
+        impl::mutex_lock b(build_mutex_);
+        while (!building_.empty())
+            pthread_cond_wait(&built_, &build_mutex_);
+    }
+    for (storage_map::iterator i=M.begin();i!=M.end();++i) i->second.item.destroy();
+    pthread_cond_destroy(&built_);
+    pthread_mutex_destroy(&build_mutex_);
+    pthread_mutex_destroy(&use_mutex_);
+    pthread_rwlock_destroy(&lock_);
+}
+
+/**
+ * wait for the functor building an item
+ */
+void storage::wait_built(std::string const &name) {
+    impl::mutex_lock b(build_mutex_);
+    while (building_.count(name))
+        pthread_cond_wait(&built_, &build_mutex_);
 }
 
 /**
  * clear item
  */
 void storage::clear(std::string const &name) {
+    impl::write_lock w(lock_);
     storage_map::iterator it = M.find(name);
     if (it!=M.end()) {
-        it->second.destroy();
+        it->second.item.destroy();
+        used_ -= it->second.size;
         M.erase(it);
     }
 }
 
+/**
+ * unpin an item of acquire()
+ */
+void storage::release(std::string const &name) {
+    impl::write_lock w(lock_);
+    storage_map::iterator it = M.find(name);
+    if (it==M.end() || it->second.pins==0)
+        throw std::logic_error("storage: release of '"+name+"' without acquire");
+    --it->second.pins;
+    evict("");
+}
+
+/**
+ * set the memory budget, 0 for unlimited
+ */
+void storage::set_budget(std::size_t bytes) {
+    impl::write_lock w(lock_);
+    budget_ = bytes;
+    evict("");
+}
+
+/**
+ * usage of the storage
+ */
+storage_stats storage::stats() const {
+    impl::read_lock r(lock_);
+    impl::mutex_lock u(use_mutex_);
+    storage_stats s;
+    s.budget = budget_;
+    s.used = used_;
+    s.items = M.size();
+    s.hits = hits_;
+    s.misses = misses_;
+    s.evictions = evictions_;
+    return s;
+}
+
+/**
+ * LRU eviction of the unpinned items with a size not returned by get(), the caller holds the write lock
+ */
+void storage::evict(std::string const &keep) {
+    while (budget_ && used_ > budget_) {
+        storage_map::iterator victim = M.end();
+        for (storage_map::iterator i=M.begin();i!=M.end();++i) {
+            if (!i->second.size || i->second.pins || i->second.held || i->first==keep) continue;
+            if (victim==M.end() || i->second.last_use < victim->second.last_use) victim = i;
+        }
+        if (victim==M.end()) return; // everything else is in use
+
+        victim->second.item.destroy();
+        used_ -= victim->second.size;
+        M.erase(victim);
+        ++evictions_;
+    }
+}
+
 /** \class ref_count_ptr
  * \brief Reference-counted managed pointer.
  *
@@ -64,19 +153,22 @@ void storage::clear(std::string const &name) {
  * registered destructor function on the owned pointer when the count
  * reaches zero.
  *
- * Not thread-safe.
+ * The count is atomic: copies of the same pointer can be made and
+ * destroyed concurrently, the last one calls the destructor function.
+ * A single ref_count_ptr object is not protected against concurrent
+ * assignment.
  */
 class ref_count_ptr {
 public:
     ref_count_ptr(): ptr(0), dtor(0), k(0) {}
 
     ref_count_ptr(const ref_count_ptr &r): ptr(r.ptr), dtor(r.dtor), k(r.k) {
-        if (*this) ++*k;
+        if (*this) k->fetch_add(1, boost::memory_order_relaxed);
         assert_invariant();
     }
 
     ref_count_ptr(void *ptr_, void (*dtor_)(void *)): ptr(ptr_), dtor(dtor_), k(0) {
-        if (ptr_) k=new size_t(1);
+        if (ptr_) k=new counter(1);
         assert_invariant();
     }
 
@@ -86,16 +178,16 @@ public:
         ptr=r.ptr;
         dtor=r.dtor;
         k=r.k;
-        if (*this) ++*k; // call operator bool() test if k != 0
+        if (*this) k->fetch_add(1, boost::memory_order_relaxed); // call operator bool() test if k != 0
         assert_invariant();
         return *this;
     }
 
     // true if not in empty state.
-    operator bool() const { return k; }
+    operator bool() const { return k!=0; }
 
     // return 0 if empty
-    void *get() {
+    void *get() const {
         assert_invariant();
         return (*this)?ptr:0;
     }
@@ -104,12 +196,14 @@ public:
         // If I am empty return
         if (!*this) return;
 
-        if (!--*k) { /* --*k == 0 */
+        // once released, the other owners may free k at any time: this
+        // object is left empty whether it was the last owner or not
+        if (k->fetch_sub(1, boost::memory_order_acq_rel)==1) { /* --*k == 0 */
             dtor(ptr); // clean up memory
             delete k;
-            k=0;
-            ptr=0;
         }
+        k=0;
+        ptr=0;
         assert_invariant();
     }
 
@@ -119,19 +213,21 @@ public:
     }
 
 private:
-    void assert_invariant() {
+    void assert_invariant() const {
         // must be either in empty state, with k zero,
         // or k must be non-zero and *k>0, and ptr!=0.
         if (k) {
             //(test *k==0)
-            if (!*k) throw std::logic_error("ref_count_ptr: k!=0 but *k==0");
+            if (!k->load(boost::memory_order_relaxed)) throw std::logic_error("ref_count_ptr: k!=0 but *k==0");
             if (!ptr) throw std::logic_error("ref_count_ptr: k!=0 but ptr==0");
         }
     }
 
+    typedef boost::atomic<size_t> counter;
+
     void *ptr;
     void (*dtor)(void *);
-    size_t *k;
+    counter *k;
 };
 
 
@@ -149,8 +245,21 @@ struct storage_ctor_wrapper {
     }
 };
 
+/** \struct storage_size_wrapper
+ * \brief Functional object giving the size of the item owned by a ref_count_ptr
+ * with the provided size function, 0 if there is none.
+ */
+struct storage_size_wrapper {
+    storage_size size;
+
+    std::size_t operator()(const ref_count_ptr &p) const {
+        return (size && p)?size(p.get()):0;
+    }
+};
+
 /**
  * Gets a pointer to the data. If data has been already loaded, returns a pointer to the existing data (not a clone).
+ * The pointer has no release: the data is not evicted any more, until it is replaced or cleared.
  * @param name keyword referring to the data (user-defined)
  * @param maker pointer to function that loads the data, if not internally existing
  * @param context parameters to pass to the maker function above (if function not called, not used, NULL can be past)
@@ -164,6 +273,59 @@ void *storage_get(const char *name, storage_ctor maker,
    return neuromapp_data.get<ref_count_ptr>(name, mk).get();
 };
 
+/**
+ * As storage_get, and the data counts in the memory budget and cannot be evicted until storage_release.
+ * @param name keyword referring to the data (user-defined)
+ * @param maker pointer to function that loads the data, if not internally existing
+ * @param context parameters to pass to the maker function above
+ * @param destroyer function pointer that will delete the data;
+ * @param sizer function pointer giving the size of the data in bytes, NULL if not counted
+ * @return pointer to the data
+ */
+void *storage_acquire(const char *name, storage_ctor maker,
+                      storage_ctor_context context, storage_dtor dtor, storage_size sizer)
+{
+   storage_ctor_wrapper mk = {maker, context, dtor};
+   storage_size_wrapper sz = {sizer};
+   return neuromapp_data.acquire<ref_count_ptr>(name, mk, sz).get();
+}
+
+/**
+ * The data of a storage_acquire is not in use any more
+ * @param name keyword referring to the data (user-defined)
+ */
+void storage_release(const char *name) {
+    neuromapp_data.release(name);
+}
+
+/** memory budget in bytes, 0 for unlimited */
+void storage_set_budget(size_t bytes) {
+    neuromapp_data.set_budget(bytes);
+}
+
+/** usage of the storage */
+void storage_get_stats(struct storage_stats *stats) {
+    *stats = neuromapp_data.stats();
+}
+
+/**
+ * Starts to load the data on a background thread and returns at once. storage_get waits
+ * for the load if it is still in flight.
+ * @param name keyword referring to the data (user-defined)
+ * @param maker pointer to function that loads the data
+ * @param context parameters to pass to the maker function, must stay valid until the maker returns
+ * @param destroyer function pointer that will delete the data;
+ * @param sizer function pointer giving the size of the data in bytes, NULL if not counted
+ * @return 1 if the maker will be called, 0 if the data is already loaded or being loaded
+ */
+int storage_prefetch(const char *name, storage_ctor maker,
+                     storage_ctor_context context, storage_dtor dtor, storage_size sizer)
+{
+   storage_ctor_wrapper mk = {maker, context, dtor};
+   storage_size_wrapper sz = {sizer};
+   return neuromapp_data.prefetch<ref_count_ptr>(name, mk, sz);
+}
+
 /**
  * Put new data to a given key
  * @param name keyword referring to the data (user-defined)
@@ -174,6 +336,15 @@ void storage_put(const char *name, void *item, storage_dtor dtor) {
     neuromapp_data.put_copy(name, ref_count_ptr(item,dtor));
 }
 
+/**
+ * Put a copy of a double to a given key, as put_copy<double>
+ * @param name keyword referring to the data (user-defined)
+ * @param value
+ */
+void storage_put_double(const char *name, double value) {
+    neuromapp_data.put_copy(name, value);
+}
+
 /** cleaning the library */
 void storage_clear(const char *name) {
     neuromapp_data.clear(name);
@@ -30,9 +30,30 @@
 #ifndef MAPP_STORAGE_
 #define MAPP_STORAGE_
 
+#include <stddef.h>
+
 typedef void *storage_ctor_context;
 typedef void *(*storage_ctor)(storage_ctor_context);
 typedef void (*storage_dtor)(void *);
+typedef size_t (*storage_size)(void *);
+
+/** \struct storage_stats
+    \brief usage of the storage, only the items with a size count in the budget
+ */
+struct storage_stats {
+    /** memory budget in bytes, 0 if unlimited */
+    size_t budget;
+    /** bytes of the items with a size */
+    size_t used;
+    /** number of items */
+    size_t items;
+    /** lookups that found the item */
+    unsigned long hits;
+    /** lookups that loaded the item, prefetches included */
+    unsigned long misses;
+    /** items removed to stay within the budget */
+    unsigned long evictions;
+};
 
 /* C interface to storage represents stored items by void pointer,
  * and the functional constructor by a void * returning function that
@@ -42,16 +63,43 @@ typedef void (*storage_dtor)(void *);
 extern "C" {
 #endif
 
-/** C interface return void* to cast by the user */
+/** C interface return void* to cast by the user, the item is not evicted any more:
+    use storage_acquire and storage_release for the items that may be */
 void *storage_get(const char *name, storage_ctor maker,
                   storage_ctor_context context, storage_dtor destroyer );
 
+/** C interface as storage_get, the item counts in the budget with sizer(item) bytes
+    and is not evicted until storage_release */
+void *storage_acquire(const char *name, storage_ctor maker,
+                      storage_ctor_context context, storage_dtor destroyer, storage_size sizer);
+
+/** C interface the item of storage_acquire can be evicted */
+void storage_release(const char *name);
+
+/** C interface start to load on a background thread, storage_get waits for it,
+    sizer may be NULL */
+int storage_prefetch(const char *name, storage_ctor maker,
+                     storage_ctor_context context, storage_dtor destroyer, storage_size sizer);
+
+/** C interface memory budget in bytes of the items with a size, 0 for unlimited */
+void storage_set_budget(size_t bytes);
+
+/** C interface current usage of the storage */
+void storage_get_stats(struct storage_stats *stats);
+
 /** C interface flush the memory */
 void storage_put(const char *name, void *item, storage_dtor dtor);
 
 /** clearing the memory */
 void storage_clear(const char *name);
 
+/** key of the duration in seconds (double) of the compute phase of the
+    last run of a miniapp, read by the bench miniapp */
+#define STORAGE_COMPUTE_TIME "compute_time"
+
+/** C interface put a copy of a double, readable as get<double> in C++ */
+void storage_put_double(const char *name, double value);
+
 
 #ifdef __cplusplus
 }
@@ -32,11 +32,18 @@
 
 #include <string>
 #include <map>
+#include <set>
 #include <utility>
 #include <typeinfo>
 #include <iostream>
 #include <stdexcept>
 
+#include <pthread.h>
+
+extern "C" {
+#include "utils/storage/storage.h"
+}
+
 //! namespace spcific for the storage implementation only
 namespace impl {
 
@@ -76,6 +83,69 @@ namespace impl {
         const std::type_info * tid_;
         void (*del_)(void *);
     };
+
+    /** \struct entry
+        \brief an item of the storage and its bookkeeping for the memory budget
+     */
+    struct entry {
+        entry(container const &c, std::size_t size_, int pins_, bool held_, unsigned long last_use_):
+              item(c), size(size_), pins(pins_), held(held_), last_use(last_use_) {}
+
+        container item;
+        /// bytes counted in the budget, 0 if the item is not managed
+        std::size_t size;
+        /// acquire() not released, a pinned item is never evicted
+        int pins;
+        /// returned by get(), whose references have no release: never evicted
+        bool held;
+        /// clock of the last lookup, the least recently used item is evicted first
+        unsigned long last_use;
+    };
+
+    /** functor of the items without size, never evicted */
+    template <typename T>
+    struct no_size {
+        std::size_t operator()(T const&) const { return 0; }
+    };
+
+    /** \class read_lock
+        \brief scoped shared lock of a pthread reader-writer lock
+     */
+    class read_lock {
+    public:
+        explicit read_lock(pthread_rwlock_t &l): l_(l) { pthread_rwlock_rdlock(&l_); }
+        ~read_lock() { pthread_rwlock_unlock(&l_); }
+    private:
+        read_lock(read_lock const&);
+        read_lock &operator=(read_lock const&);
+        pthread_rwlock_t &l_;
+    };
+
+    /** \class write_lock
+        \brief scoped exclusive lock of a pthread reader-writer lock
+     */
+    class write_lock {
+    public:
+        explicit write_lock(pthread_rwlock_t &l): l_(l) { pthread_rwlock_wrlock(&l_); }
+        ~write_lock() { pthread_rwlock_unlock(&l_); }
+    private:
+        write_lock(write_lock const&);
+        write_lock &operator=(write_lock const&);
+        pthread_rwlock_t &l_;
+    };
+
+    /** \class mutex_lock
+        \brief scoped lock of a pthread mutex
+     */
+    class mutex_lock {
+    public:
+        explicit mutex_lock(pthread_mutex_t &m): m_(m) { pthread_mutex_lock(&m_); }
+        ~mutex_lock() { pthread_mutex_unlock(&m_); }
+    private:
+        mutex_lock(mutex_lock const&);
+        mutex_lock &operator=(mutex_lock const&);
+        pthread_mutex_t &m_;
+    };
 }
 
 /** \struct bad_type_exception
@@ -94,23 +164,67 @@ struct missing_data : public std::runtime_error {
 
 /** \class storage 
     \brief store the different data set associated to a giben key provided by the user
+
+    The storage is thread-safe: the lookups share a reader-writer lock, the
+    insertions and removals take it exclusively. The functor of get(name, f)
+    runs outside of the lock and once only per key: the concurrent callers
+    for the same key wait for the first one and return its data set.
+    The references returned stay valid until the key is replaced or cleared.
+    prefetch(name, f) runs the functor on a background thread, the getters
+    wait for it.
+
+    The items loaded with a size functor are counted in a memory budget:
+    when it is exceeded the least recently used of them are destroyed,
+    unless they are pinned by acquire() and not yet released, or have been
+    returned by get(): its references are not released, such an item stays
+    until it is replaced or cleared.
  */
 class storage {
 public:
-    storage() {};
+    storage();
     ~storage();
 
     /** put a copy of a given data set*/
     template <typename T>
     T &put_copy(std::string const &name, const T &x);
 
-    /** get a data set if it does not exist 
+    /** get a data set if it does not exist, it is not evicted any more
         \param name the data set
         \param f functor for the initialisation
      */
     template <typename T, class F>
     T &get(std::string const &name, F f);
 
+    /** get(name, f) pinning the data set until release(name)
+        \param name the data set
+        \param f functor for the initialisation
+        \param size functor giving the bytes of the data set in the budget
+     */
+    template <typename T, class F, class S>
+    T &acquire(std::string const &name, F f, S size);
+
+    /** unpin a data set of acquire(), it may then be evicted */
+    void release(std::string const &name);
+
+    /** start to build a data set on a background thread, if it does not
+        exist and is not being built
+        \param name the data set
+        \param f functor for the initialisation, copied to the thread
+        \return true if f will be called
+     */
+    template <typename T, class F>
+    bool prefetch(std::string const &name, F f);
+
+    /** prefetch(name, f) of a data set counted in the budget with size(item) bytes */
+    template <typename T, class F, class S>
+    bool prefetch(std::string const &name, F f, S size);
+
+    /** memory budget of the data sets with a size, 0 for unlimited */
+    void set_budget(std::size_t bytes);
+
+    /** usage and hit/miss/eviction counts */
+    storage_stats stats() const;
+
     /* Get the data set 
         \param name the data set
      */
@@ -127,10 +241,62 @@ public:
     void clear(const std::string &name);
 
 private:
+    storage(storage const&);
+    storage &operator=(storage const&);
+
     template <typename T>
     T *get_ptr(const std::string &name);
-    typedef std::map<std::string, impl::container> storage_map;
+
+    /** inserts or replaces under the write lock, then evicts if over budget,
+        a replaced item keeps its pins, and its size if size is 0 */
+    template <typename T>
+    T &insert(std::string const &name, const T &x, std::size_t size, int pins, bool held);
+
+    /** lookup under the read lock counted as a hit, pins the item if pin,
+        holds it otherwise as get() */
+    template <typename T>
+    T *touch(std::string const &name, bool pin);
+
+    /** the once-only construction of get() and acquire() */
+    template <typename T, class F, class S>
+    T &get_or_build(std::string const &name, F f, S size, bool pin);
+
+    /** destroys the unpinned items by least recent use until the budget is met,
+        except keep. Needs the write lock */
+    void evict(std::string const &keep);
+
+    /** waits until the functor of the key, if any, has returned */
+    void wait_built(std::string const &name);
+
+    /** \class building
+        \brief unmarks a key under construction on destruction, even if the
+        functor throws, and wakes up the threads waiting for it
+     */
+    class building;
+
+    /** \class prefetcher
+        \brief the functor of prefetch() and the entry point of its thread
+     */
+    template <typename T, class F, class S>
+    class prefetcher;
+
+    typedef std::map<std::string, impl::entry> storage_map;
     storage_map M;
+
+    /// protected by the write lock, or by use_mutex_ under the read lock
+    mutable pthread_mutex_t use_mutex_;
+    unsigned long clock_;
+    unsigned long hits_, misses_, evictions_;
+    /// protected by lock_
+    std::size_t budget_, used_;
+
+    /// protects M
+    mutable pthread_rwlock_t lock_;
+    /// protects building_, lock order: build_mutex_ before lock_
+    pthread_mutex_t build_mutex_;
+    pthread_cond_t built_;
+    /// keys whose functor is running
+    std::set<std::string> building_;
 };
 
 #include "storage.ipp"
@@ -29,27 +29,86 @@
 
 #include <iostream>
 
+class storage::building {
+public:
+    building(storage &s, std::string const &name): s_(s), name_(name) {}
+
+    ~building() {
+        impl::mutex_lock b(s_.build_mutex_);
+        s_.building_.erase(name_);
+        pthread_cond_broadcast(&s_.built_);
+    }
+
+private:
+    building(building const&);
+    building &operator=(building const&);
+    storage &s_;
+    std::string name_;
+};
+
+template <typename T, class F, class S>
+class storage::prefetcher {
+public:
+    prefetcher(storage &s, std::string const &name, F f, S size): s_(s), name_(name), f_(f), size_(size) {}
+
+    static void *run(void *p) {
+        prefetcher *task = (prefetcher *)p;
+        {
+            building mark(task->s_, task->name_);
+            try {
+                const T x = task->f_();
+                task->s_.insert(task->name_, x, task->size_(x), 0, false);
+            }
+            catch (...) {} // nothing stored: the next get() calls its own functor
+        }
+        delete task;
+        return 0;
+    }
+
+private:
+    storage &s_;
+    std::string name_;
+    F f_;
+    S size_;
+};
+
 template < typename T >
 T &storage::put_copy(std::string const &name, const T &x) {
+    return insert(name, x, 0, 0, false);
+}
+
+template < typename T >
+T &storage::insert(std::string const &name, const T &x, std::size_t size, int pins, bool held) {
+    impl::write_lock w(lock_);
     storage_map::iterator it = M.find(name);
 
     T *c=0;
     if (it != M.end()) {
-        it->second.destroy();
+        it->second.item.destroy();
         try {
             c = new T(x);
-            it->second = impl::container(c);
+            it->second.item = impl::container(c);
         }
         catch (...) { //case new fails 
+            used_ -= it->second.size;
             M.erase(it);
             throw;
         }
+        if (size) {
+            used_ = used_ - it->second.size + size;
+            it->second.size = size;
+        }
+        it->second.pins += pins;
+        it->second.held = held; // the references to the replaced item are invalid
+        it->second.last_use = ++clock_;
     }
     else {
         c = new T(x);
-        M.insert(std::make_pair(name, impl::container(c)));
+        M.insert(std::make_pair(name, impl::entry(impl::container(c), size, pins, held, ++clock_)));
+        used_ += size;
     }
 
+    evict(name);
     return *c;
 }
 
@@ -58,21 +117,99 @@ T *storage::get_ptr(std::string const &name) {
     storage_map::iterator it = M.find(name);
     if (it==M.end()) return 0;
 
-    T *item=it->second.get<T>();
+    T *item=it->second.item.get<T>();
     if(!item) throw bad_type_exception("type mismatch for item '"+name+"'");
     return item;
 }
 
+template <typename T>
+T *storage::touch(std::string const &name, bool pin) {
+    T *item = get_ptr<T>(name);
+    if (item) {
+        impl::mutex_lock u(use_mutex_);
+        impl::entry &e = M.find(name)->second;
+        if (pin) ++e.pins;
+        else e.held = true;
+        e.last_use = ++clock_;
+        ++hits_;
+    }
+    return item;
+}
+
+template <typename T, class F, class S>
+T &storage::get_or_build(std::string const &name, F make_item, S size, bool pin) {
+    {
+        impl::read_lock r(lock_);
+        T *item = touch<T>(name, pin);
+        if (item) return *item;
+    }
+
+    // slow path: wait if another thread is building the item, build it otherwise
+    {
+        impl::mutex_lock b(build_mutex_);
+        while (building_.count(name))
+            pthread_cond_wait(&built_, &build_mutex_);
+
+        impl::read_lock r(lock_);
+        T *item = touch<T>(name, pin);
+        if (item) return *item;
+        building_.insert(name);
+
+        impl::mutex_lock u(use_mutex_);
+        ++misses_;
+    }
+
+    building mark(*this, name); // the functor runs without lock
+    const T x = make_item(); // call the functors, storage_ctor_wrapper()
+    return insert(name, x, size(x), pin ? 1 : 0, !pin);
+}
+
 template <typename T, class F>
 T &storage::get(std::string const &name, F make_item) {
-    T *item = get_ptr<T>(name);
-    if (!item) return put_copy<T>(name, make_item()); // call the functors, storage_ctor_wrapper()
-    return *item;
+    return get_or_build<T>(name, make_item, impl::no_size<T>(), false);
+}
+
+template <typename T, class F, class S>
+T &storage::acquire(std::string const &name, F make_item, S size) {
+    return get_or_build<T>(name, make_item, size, true);
+}
+
+template <typename T, class F>
+bool storage::prefetch(std::string const &name, F make_item) {
+    return prefetch<T>(name, make_item, impl::no_size<T>());
+}
+
+template <typename T, class F, class S>
+bool storage::prefetch(std::string const &name, F make_item, S size) {
+    {
+        impl::mutex_lock b(build_mutex_);
+        if (building_.count(name)) return false;
+
+        impl::read_lock r(lock_);
+        if (M.count(name)) return false;
+        building_.insert(name);
+
+        impl::mutex_lock u(use_mutex_);
+        ++misses_;
+    }
+
+    prefetcher<T,F,S> *task = new prefetcher<T,F,S>(*this, name, make_item, size);
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    pthread_t thread;
+    if (pthread_create(&thread, &attr, prefetcher<T,F,S>::run, task))
+        prefetcher<T,F,S>::run(task); // no thread left, load now
+    pthread_attr_destroy(&attr);
+    return true;
 }
 
 template < typename T>
 T &storage::get(std::string const & name) {
-    T *item = get_ptr<T>(name);
+    wait_built(name);
+
+    impl::read_lock r(lock_);
+    T *item = touch<T>(name, false);
     if (!item) throw missing_data("no entry named '"+name+"'");
 
     return *item;
@@ -80,6 +217,7 @@ T &storage::get(std::string const & name) {
 
 template <typename T>
 bool storage::has(std::string const &name) const {
+    impl::read_lock r(lock_);
     storage_map::const_iterator it = M.find(name);
-    return it!=M.end() && it->second.get<T>()!=0;
+    return it!=M.end() && it->second.item.get<T>()!=0;
 }
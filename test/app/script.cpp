@@ -0,0 +1,95 @@
+/*
+ * Neuromapp - script.cpp, Copyright (c), 2015,
+ * Timothee Ewart - Swiss Federal Institute of technology in Lausanne,
+ * timothee.ewart@epfl.ch,
+ * All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+
+/**
+ * @file neuromapp/test/app/script.cpp
+ *  Test the batch mode of the driver
+ */
+
+#define BOOST_TEST_MODULE ScriptTest
+#include <sstream>
+#include <boost/test/unit_test.hpp>
+
+#include "app/driver.h"
+#include "app/script.h"
+#include "utils/storage/storage.h"
+
+/** counts its runs, reports the number of arguments as compute time */
+int count_runs = 0;
+int counter(int argc, char * const argv[]){
+    ++count_runs;
+    storage_put_double(STORAGE_COMPUTE_TIME, argc);
+    return mapp::MAPP_OK;
+}
+
+template<int n>
+int foo(int argc, char * const argv[]){
+    return n;
+}
+
+BOOST_AUTO_TEST_CASE(script_expand_test){
+    std::istringstream in("# a sweep\n"
+                          "set mech Na\n"
+                          "set args --mechanism ${mech}\n"
+                          "for th in 1 2\n"
+                          "    for f in state current\n"
+                          "        kernel ${args} --function ${f} --numthread ${th}\n"
+                          "    end\n"
+                          "end\n"
+                          "\n"
+                          "quit\n"
+                          "hello\n");
+    std::vector<std::string> v = mapp::script_expand(in);
+    BOOST_REQUIRE_EQUAL(v.size(), 4);
+    BOOST_CHECK_EQUAL(v[0], "kernel --mechanism Na --function state --numthread 1");
+    BOOST_CHECK_EQUAL(v[3], "kernel --mechanism Na --function current --numthread 2");
+}
+
+BOOST_AUTO_TEST_CASE(script_error_test){
+    std::istringstream unknown("kernel --numthread ${th}\n");
+    BOOST_CHECK_THROW(mapp::script_expand(unknown), mapp::driver_exception);
+    std::istringstream no_end("for th in 1 2\nkernel\n");
+    BOOST_CHECK_THROW(mapp::script_expand(no_end), mapp::driver_exception);
+    std::istringstream no_for("kernel\nend\n");
+    BOOST_CHECK_THROW(mapp::script_expand(no_for), mapp::driver_exception);
+}
+
+BOOST_AUTO_TEST_CASE(script_run_test){
+    mapp::driver d;
+    d.insert("counter", counter);
+    d.insert("fails", foo<mapp::MAPP_BAD_DATA>);
+
+    std::istringstream in("for i in 1 2 3\ncounter --i ${i}\nend\nfails\ncounter\n");
+    std::vector<mapp::script_record> r = mapp::script_run(d, mapp::script_expand(in));
+
+    // an error does not stop the script
+    BOOST_REQUIRE_EQUAL(r.size(), 5);
+    BOOST_CHECK_EQUAL(count_runs, 4);
+    BOOST_CHECK_EQUAL(r[0].error, mapp::MAPP_OK);
+    BOOST_CHECK_EQUAL(r[0].compute, 3.);
+    BOOST_CHECK_EQUAL(r[3].error, mapp::MAPP_BAD_DATA);
+    BOOST_CHECK(r[3].compute < 0.);
+    BOOST_CHECK_EQUAL(r[4].compute, 1.);
+
+    std::ostringstream out;
+    mapp::script_summary(out, r);
+    BOOST_CHECK(out.str().find("error") != std::string::npos);
+    BOOST_CHECK(out.str().find("5 commands") != std::string::npos);
+}
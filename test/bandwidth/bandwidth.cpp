@@ -0,0 +1,77 @@
+/*
+ * Neuromapp - bandwidth.cpp, Copyright (c), 2015,
+ * Timothee Ewart - Swiss Federal Institute of technology in Lausanne,
+ * timothee.ewart@epfl.ch,
+ * All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+
+/**
+ * @file neuromapp/test/bandwidth/bandwidth.cpp
+ *  Test on the bandwidth miniapp
+ */
+
+#define BOOST_TEST_MODULE BandwidthTest
+#include <vector>
+#include <string>
+#include <boost/test/unit_test.hpp>
+
+#include "bandwidth/bandwidth.h"
+#include "bandwidth/patterns.h"
+#include "coreneuron_1.0/common/data/helper.h"
+#include "utils/storage/neuromapp_data.h"
+#include "utils/error.h"
+
+BOOST_AUTO_TEST_CASE(patterns_test){
+    double b[4] = {1., 2., 3., 4.}, c[4] = {1., 1., 1., 1.}, a[4];
+    bandwidth::triad(a, b, c, 2., 4);
+    BOOST_CHECK_EQUAL(a[3], 6.);
+
+    // the indices repeat as the nodeindices of several mechanisms
+    int idx[5] = {2, 0, 2, 1, 2};
+    double v[3] = {10., 20., 30.}, out[5], x[5] = {1., 1., 1., 1., 1.};
+    bandwidth::gather(out, v, idx, 5);
+    BOOST_CHECK_EQUAL(out[0], 30.);
+    BOOST_CHECK_EQUAL(out[3], 20.);
+    bandwidth::scatter_add(v, x, idx, 5);
+    BOOST_CHECK_EQUAL(v[0], 9.);
+    BOOST_CHECK_EQUAL(v[2], 27.);
+
+    std::vector<double> acc(bandwidth::flops_width, 0.);
+    bandwidth::multiply_add(&acc[0], 1);
+    BOOST_CHECK_CLOSE(acc[0], 1e-6, 1e-9);
+}
+
+BOOST_AUTO_TEST_CASE(bandwidth_test){
+    std::vector<std::string> command_v;
+    command_v.push_back("bandwidth");
+    command_v.push_back("--data");
+    command_v.push_back(mapp::data_test());
+    command_v.push_back("--repeat");
+    command_v.push_back("2");
+    BOOST_CHECK(mapp::execute(command_v, bandwidth_execute) == mapp::MAPP_OK);
+
+    // the ceilings are kept in the storage
+    BOOST_CHECK(neuromapp_data.get<double>("bandwidth_stream") > 0.);
+    BOOST_CHECK(neuromapp_data.get<double>("bandwidth_gather") > 0.);
+    BOOST_CHECK(neuromapp_data.get<double>("bandwidth_scatter") > 0.);
+    BOOST_CHECK(neuromapp_data.get<double>("bandwidth_flops") > 0.);
+
+    command_v[4] = "0";
+    BOOST_CHECK(mapp::execute(command_v, bandwidth_execute) == mapp::MAPP_BAD_ARG);
+    command_v[2] = "fake and wrong";
+    command_v[4] = "2";
+    BOOST_CHECK(mapp::execute(command_v, bandwidth_execute) == mapp::MAPP_BAD_DATA);
+}
@@ -0,0 +1,164 @@
+/*
+ * Neuromapp - bench.cpp, Copyright (c), 2015,
+ * Timothee Ewart - Swiss Federal Institute of technology in Lausanne,
+ * timothee.ewart@epfl.ch,
+ * All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+
+/**
+ * @file neuromapp/test/bench/bench.cpp
+ *  Test on the bench miniapp
+ */
+
+#define BOOST_TEST_MODULE BenchTest
+#include <fstream>
+#include <string>
+#include <vector>
+#include <boost/test/unit_test.hpp>
+#include <boost/filesystem.hpp>
+
+#include "bench/bench.h"
+#include "bench/statistics.h"
+#include "app/driver.h"
+#include "utils/storage/storage.h"
+#include "utils/error.h"
+#include "coreneuron_1.0/common/data/helper.h"
+
+namespace bfs = ::boost::filesystem;
+
+/** a miniapp reporting a compute phase of 0.5 s */
+int compute(int argc, char * const argv[]){
+    storage_put_double(STORAGE_COMPUTE_TIME, 0.5);
+    return mapp::MAPP_OK;
+}
+
+/** a miniapp which does not report its compute phase */
+int silent(int argc, char * const argv[]){
+    return mapp::MAPP_OK;
+}
+
+template<int n>
+int fails(int argc, char * const argv[]){
+    return n;
+}
+
+struct bench_fixture {
+    bench_fixture(): output(bfs::temp_directory_path() / bfs::unique_path()) {
+        d.insert("compute", compute);
+        d.insert("silent", silent);
+        d.insert("fails", fails<mapp::MAPP_BAD_DATA>);
+        bench_driver(&d);
+    }
+    ~bench_fixture() {
+        bfs::remove(output);
+    }
+
+    std::vector<std::string> lines() const {
+        std::vector<std::string> v;
+        std::ifstream in(output.string().c_str());
+        std::string line;
+        while(std::getline(in, line))
+            v.push_back(line);
+        return v;
+    }
+
+    mapp::driver d;
+    bfs::path output;
+};
+
+BOOST_AUTO_TEST_CASE(statistics_test){
+    double x[5] = {5., 1., 4., 2., 3.};
+    bench::summary s = bench::summarize(std::vector<double>(x, x+5));
+    BOOST_CHECK_EQUAL(s.n, 5);
+    BOOST_CHECK_CLOSE(s.mean, 3., 1e-9);
+    BOOST_CHECK_CLOSE(s.median, 3., 1e-9);
+    BOOST_CHECK_CLOSE(s.stddev, std::sqrt(2.5), 1e-9);
+    BOOST_CHECK_CLOSE(s.ci95_high - s.mean, 2.776 * std::sqrt(2.5) / std::sqrt(5.), 1e-9);
+    BOOST_CHECK_CLOSE(s.mean - s.ci95_low, s.ci95_high - s.mean, 1e-9);
+    BOOST_CHECK_EQUAL(s.min, 1.);
+    BOOST_CHECK_EQUAL(s.max, 5.);
+
+    // even number of samples and a single sample
+    s = bench::summarize(std::vector<double>(x, x+4));
+    BOOST_CHECK_CLOSE(s.median, 3., 1e-9);
+    s = bench::summarize(std::vector<double>(1, 2.));
+    BOOST_CHECK_EQUAL(s.stddev, 0.);
+    BOOST_CHECK_EQUAL(s.ci95_low, 2.);
+    BOOST_CHECK_EQUAL(bench::student_t95(1000), 1.96);
+}
+
+BOOST_FIXTURE_TEST_CASE(bench_json_test, bench_fixture){
+    std::string out("--output=" + output.string());
+    std::vector<std::string> command;
+    command.push_back("bench");
+    command.push_back("--repeat=3");
+    command.push_back(out);
+    command.push_back("--");
+    command.push_back("compute");
+    command.push_back("--numthread");
+    command.push_back("4");
+    command.push_back("--data=foo");
+    BOOST_CHECK(mapp::execute(command, bench_execute) == mapp::MAPP_OK);
+
+    std::vector<std::string> v = lines();
+    BOOST_REQUIRE_EQUAL(v.size(), 1);
+    BOOST_CHECK(v[0].find("\"miniapp\": \"compute\"") != std::string::npos);
+    BOOST_CHECK(v[0].find("\"dataset\": \"foo\"") != std::string::npos);
+    BOOST_CHECK(v[0].find("\"threads\": 4") != std::string::npos);
+    BOOST_CHECK(v[0].find("\"timer\": \"compute\"") != std::string::npos);
+    BOOST_CHECK(v[0].find("\"mean\": 0.5,") != std::string::npos);
+    BOOST_CHECK(v[0].find("\"samples\": [0.5, 0.5, 0.5]") != std::string::npos);
+}
+
+BOOST_FIXTURE_TEST_CASE(bench_csv_test, bench_fixture){
+    std::string out("--output=" + output.string());
+    std::vector<std::string> command;
+    command.push_back("bench");
+    command.push_back("--format=csv");
+    command.push_back(out);
+    command.push_back("--");
+    command.push_back("silent");
+    BOOST_CHECK(mapp::execute(command, bench_execute) == mapp::MAPP_OK);
+    BOOST_CHECK(mapp::execute(command, bench_execute) == mapp::MAPP_OK);
+
+    // the header once, then one row per run of bench
+    std::vector<std::string> v = lines();
+    BOOST_REQUIRE_EQUAL(v.size(), 3);
+    BOOST_CHECK(v[0].find("miniapp,arguments,dataset,threads") == 0);
+    BOOST_CHECK(v[1].find("\"silent\"") == 0);
+    BOOST_CHECK(v[1].find(",wall,") != std::string::npos);
+}
+
+BOOST_FIXTURE_TEST_CASE(bench_error_test, bench_fixture){
+    std::vector<std::string> command;
+    command.push_back("bench");
+    command.push_back("--");
+    command.push_back("fails");
+    BOOST_CHECK(mapp::execute(command, bench_execute) == mapp::MAPP_BAD_DATA);
+
+    command[2] = "unknown";
+    BOOST_CHECK(mapp::execute(command, bench_execute) == mapp::MAPP_BAD_ARG);
+
+    command[2] = "compute";
+    command.insert(command.begin() + 1, "--format=xml");
+    BOOST_CHECK(mapp::execute(command, bench_execute) == mapp::MAPP_BAD_ARG);
+    command[1] = "--repeat=0";
+    BOOST_CHECK(mapp::execute(command, bench_execute) == mapp::MAPP_BAD_ARG);
+
+    // the miniapp is missing
+    command.resize(2);
+    BOOST_CHECK(mapp::execute(command, bench_execute) == mapp::MAPP_USAGE);
+}
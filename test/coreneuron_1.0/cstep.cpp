@@ -25,20 +25,26 @@
 
 #define BOOST_TEST_MODULE KernelTest
 #include <vector>
+#include <algorithm>
 
 #include <boost/test/unit_test.hpp>
 #include <boost/test/test_case_template.hpp>
 #include <boost/filesystem.hpp>
 #include <iostream>
 #include <fstream>
+#include <sstream>
+#include <cstdio>
 
 extern "C" {
 #include "utils/storage/storage.h"
 #include "coreneuron_1.0/common/util/nrnthread_handler.h"
 #include "coreneuron_1.0/common/memory/nrnthread.h"
+#include "coreneuron_1.0/common/memory/partition.h"
+#include "coreneuron_1.0/common/memory/generator.h"
 }
 
 #include "coreneuron_1.0/cstep/cstep.h" // signature kernel application
+#include "coreneuron_1.0/generate/generate.h"
 #include "neuromapp/coreneuron_1.0/common/data/path.h" // this file is generated automatically
 #include "coreneuron_1.0/common/data/helper.h" // common functionalities
 #include "utils/error.h"
@@ -94,3 +100,172 @@ BOOST_AUTO_TEST_CASE(cstep_reference_solution_test){
     BOOST_CHECK(num==0);
     mapp::helper_check(command_v[4],"cstep",mapp::data_test());
 }
+
+/** reads a NrnThread from the text, as from a file */
+static int read_text(std::string const& text, NrnThread *nt){
+    FILE *f = tmpfile();
+    fwrite(text.data(), 1, text.size(), f);
+    rewind(f);
+    int error = nrnthread_read(f, nt);
+    fclose(f);
+    return error;
+}
+
+BOOST_AUTO_TEST_CASE(cstep_read_bad_data_test){
+    std::ifstream in(mapp::data_test().c_str());
+    std::stringstream data;
+    data << in.rdbuf();
+    std::string text = data.str();
+
+    NrnThread nt;
+    BOOST_REQUIRE(read_text(text, &nt) == mapp::MAPP_OK);
+    nrnthread_dealloc(&nt);
+
+    // a file truncated in the sections read, and sizes larger than the data
+    double fractions[3] = {0., 0.5, 0.9};
+    for(int i = 0; i < 3; ++i)
+        BOOST_CHECK(read_text(text.substr(0, text.size() * fractions[i]), &nt) == mapp::MAPP_BAD_DATA);
+    BOOST_CHECK(read_text("-3\n", &nt) == mapp::MAPP_BAD_DATA);
+    BOOST_CHECK(read_text("2\n1\n2\n---\n1\n8\n", &nt) == mapp::MAPP_BAD_DATA);
+}
+
+BOOST_AUTO_TEST_CASE(cstep_partition_test){
+    // the shape and the densities of bench.101392
+    nrn_generator g;
+    nrn_generator_default(&g);
+    NrnThread *nt = (NrnThread *) generate_nrnthread(&g);
+    BOOST_REQUIRE(nt != NULL);
+    const int n = 4;
+    NrnThread parts[n];
+    long outside(-1);
+
+    BOOST_CHECK(nrnthread_partition(nt, 0, parts, &outside) == mapp::MAPP_BAD_ARG);
+    BOOST_CHECK(nrnthread_partition(nt, nt->ncell + 1, parts, &outside) == mapp::MAPP_BAD_ARG);
+    BOOST_REQUIRE(nrnthread_partition(nt, n, parts, &outside) == mapp::MAPP_OK);
+    BOOST_CHECK_EQUAL(outside, 0);
+
+    // every cell, compartment and instance in one part
+    int ncell(0), end(0);
+    double cost_max(0.), cost_sum(0.);
+    for(int p = 0; p < n; ++p){
+        NrnThread const& part = parts[p];
+        ncell += part.ncell;
+        end += part.end;
+        BOOST_CHECK(part.ncell > 0);
+        for(int i = part.ncell; i < part.end; ++i)
+            BOOST_CHECK(part._v_parent_index[i] < i);
+        for(int m = 0; m < part.nmech; ++m)
+            if(!part.ml[m].is_art)
+                for(int i = 0; i < part.ml[m].nodecount; ++i)
+                    BOOST_CHECK(part.ml[m].nodeindices[i] < part.end);
+        cost_max = std::max(cost_max, nrnthread_cost(&part));
+        cost_sum += nrnthread_cost(&part);
+    }
+    BOOST_CHECK_EQUAL(ncell, nt->ncell);
+    BOOST_CHECK_EQUAL(end, nt->end);
+    for(int m = 0; m < nt->nmech; ++m){
+        int count(0);
+        for(int p = 0; p < n; ++p)
+            count += parts[p].ml[m].nodecount;
+        BOOST_CHECK_EQUAL(count, nt->ml[m].nodecount);
+    }
+    BOOST_CHECK_CLOSE(cost_sum, nrnthread_cost(nt), 1e-9);
+    BOOST_CHECK(cost_max * n / cost_sum < 1.2); // 5 cells of 17 in the largest part
+
+    // the data go back where they come from
+    NrnThread *back = (NrnThread *) generate_nrnthread(&g);
+    std::fill(back->_data, back->_data + back->_ndata, 0.);
+    BOOST_CHECK(nrnthread_gather(parts, n, back) == mapp::MAPP_OK);
+    BOOST_CHECK(std::equal(nt->_data, nt->_data + 6*nt->end_pad, back->_data));
+    for(int m = 0; m < nt->nmech; ++m)
+        BOOST_CHECK(std::equal(nt->ml[m].data, nt->ml[m].data + nt->ml[m].nodecount * nt->ml[m].szp,
+                               back->ml[m].data));
+
+    for(int p = 0; p < n; ++p)
+        nrnthread_dealloc(&parts[p]);
+    free_nrnthread(back);
+    free_nrnthread(nt);
+}
+
+BOOST_AUTO_TEST_CASE(cstep_partition_step_test){
+    // the same step on the whole data set and on sub-threads
+    std::vector<std::string> command_v;
+    command_v.push_back("generate");
+    command_v.push_back("--cells");
+    command_v.push_back("6");
+    command_v.push_back("--compartments");
+    command_v.push_back("80");
+    command_v.push_back("--name");
+    command_v.push_back("cstep_whole");
+    BOOST_CHECK(mapp::execute(command_v,coreneuron10_generate_execute) == mapp::MAPP_OK);
+    command_v[6] = "cstep_split";
+    BOOST_CHECK(mapp::execute(command_v,coreneuron10_generate_execute) == mapp::MAPP_OK);
+
+    NrnThread *split = (NrnThread *) storage_get("cstep_split", make_nrnthread, NULL, free_nrnthread);
+    NrnThread parts[3];
+    long outside(-1);
+    BOOST_REQUIRE(nrnthread_partition(split, 3, parts, &outside) == mapp::MAPP_OK);
+    BOOST_CHECK_EQUAL(outside, 0); // the generated pdata stay in their cell
+    for(int p = 0; p < 3; ++p)
+        nrnthread_dealloc(&parts[p]);
+
+    command_v.clear();
+    command_v.push_back("cstep");
+    command_v.push_back("--name");
+    command_v.push_back("cstep_whole");
+    BOOST_CHECK(mapp::execute(command_v,coreneuron10_cstep_execute) == mapp::MAPP_OK);
+    command_v[2] = "cstep_split";
+    command_v.push_back("--partition");
+    command_v.push_back("3");
+    command_v.push_back("--numthread");
+    command_v.push_back("2");
+    BOOST_CHECK(mapp::execute(command_v,coreneuron10_cstep_execute) == mapp::MAPP_OK);
+
+    NrnThread *whole = (NrnThread *) storage_get("cstep_whole", make_nrnthread, NULL, free_nrnthread);
+    split = (NrnThread *) storage_get("cstep_split", make_nrnthread, NULL, free_nrnthread);
+    BOOST_REQUIRE_EQUAL(whole->_ndata, split->_ndata);
+    BOOST_CHECK(std::equal(whole->_data, whole->_data + whole->_ndata, split->_data));
+    storage_clear("cstep_whole");
+    storage_clear("cstep_split");
+
+    //wrong number of sub-threads
+    command_v.clear();
+    command_v.push_back("cstep");
+    command_v.push_back("--data");
+    command_v.push_back(mapp::data_test());
+    command_v.push_back("--name");
+    command_v.push_back("cstep_partition");
+    command_v.push_back("--partition");
+    command_v.push_back("0");
+    BOOST_CHECK(mapp::execute(command_v,coreneuron10_cstep_execute) == mapp::MAPP_BAD_ARG);
+    command_v[6] = "18";
+    BOOST_CHECK(mapp::execute(command_v,coreneuron10_cstep_execute) == mapp::MAPP_BAD_ARG);
+    storage_clear("cstep_partition");
+}
+
+BOOST_AUTO_TEST_CASE(cstep_partition_bundled_test){
+    // the kernels read the pdata of bench.101392 nodecount apart, the file
+    // stores them nodecount_pad apart: no split computes the same step
+    NrnThread *nt = (NrnThread *) make_nrnthread((void*)mapp::data_test().c_str());
+    BOOST_REQUIRE(nt != NULL);
+    NrnThread parts[4];
+    long outside(0);
+    BOOST_CHECK(nrnthread_partition(nt, 4, parts, &outside) == mapp::MAPP_BAD_DATA);
+    BOOST_CHECK(outside > 0);
+
+    // refused by cstep, the data set is not stepped
+    std::vector<std::string> command_v;
+    command_v.push_back("cstep");
+    command_v.push_back("--data");
+    command_v.push_back(mapp::data_test());
+    command_v.push_back("--name");
+    command_v.push_back("cstep_partition");
+    command_v.push_back("--partition");
+    command_v.push_back("4");
+    BOOST_CHECK(mapp::execute(command_v,coreneuron10_cstep_execute) == mapp::MAPP_BAD_DATA);
+    NrnThread *same = (NrnThread *) storage_get("cstep_partition", make_nrnthread, NULL, free_nrnthread);
+    BOOST_REQUIRE_EQUAL(same->_ndata, nt->_ndata);
+    BOOST_CHECK(std::equal(nt->_data, nt->_data + nt->_ndata, same->_data));
+    storage_clear("cstep_partition");
+    free_nrnthread(nt);
+}
@@ -0,0 +1,247 @@
+/*
+ * Neuromapp - generate.cpp, Copyright (c), 2015,
+ * Timothee Ewart - Swiss Federal Institute of technology in Lausanne,
+ * timothee.ewart@epfl.ch,
+ * All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+
+/**
+ * @file neuromapp/test/coreneuron_1.0/generate.cpp
+ *  Test on the generate miniapp and the NrnThread generator
+ */
+
+#define BOOST_TEST_MODULE GenerateTest
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <algorithm>
+
+#include <boost/test/unit_test.hpp>
+
+extern "C" {
+#include "utils/storage/storage.h"
+#include "coreneuron_1.0/common/util/nrnthread_handler.h"
+#include "coreneuron_1.0/common/memory/nrnthread.h"
+#include "coreneuron_1.0/common/memory/generator.h"
+#include "coreneuron_1.0/common/memory/memory.h"
+}
+
+#include "coreneuron_1.0/generate/generate.h"
+#include "coreneuron_1.0/kernel/kernel.h"
+#include "coreneuron_1.0/cstep/cstep.h"
+#include "coreneuron_1.0/common/data/helper.h" // common functionalities
+#include "utils/error.h"
+
+/** the two data sets hold the same values */
+void check_equal(NrnThread const* a, NrnThread const* b){
+    BOOST_REQUIRE_EQUAL(a->_ndata, b->_ndata);
+    BOOST_REQUIRE_EQUAL(a->end_pad, b->end_pad);
+    BOOST_REQUIRE_EQUAL(a->nmech, b->nmech);
+    BOOST_CHECK_EQUAL(a->end, b->end);
+    BOOST_CHECK_EQUAL(a->ncell, b->ncell);
+    BOOST_CHECK(std::equal(a->_data, a->_data + a->_ndata, b->_data));
+    BOOST_CHECK(std::equal(a->_v_parent_index, a->_v_parent_index + a->end_pad, b->_v_parent_index));
+    for(int i = 0; i < a->nmech; ++i){
+        Mechanism const& ma = a->ml[i];
+        Mechanism const& mb = b->ml[i];
+        BOOST_REQUIRE_EQUAL(ma.nodecount_pad, mb.nodecount_pad);
+        BOOST_CHECK_EQUAL(ma.type, mb.type);
+        BOOST_CHECK_EQUAL(ma.nodecount, mb.nodecount);
+        BOOST_CHECK_EQUAL(ma.szp, mb.szp);
+        BOOST_CHECK_EQUAL(ma.szdp, mb.szdp);
+        BOOST_CHECK_EQUAL(ma.data - a->_data, mb.data - b->_data);
+        if(!ma.is_art)
+            BOOST_CHECK(std::equal(ma.nodeindices, ma.nodeindices + ma.nodecount_pad, mb.nodeindices));
+        if(ma.szdp)
+            BOOST_CHECK(std::equal(ma.pdata, ma.pdata + ma.nodecount_pad * ma.szdp, mb.pdata));
+    }
+}
+
+/** writes nt to a temporary file and reads it back */
+NrnThread* write_read(NrnThread const* nt){
+    std::string name("generate_test.dat");
+    FILE *f = fopen(name.c_str(), "w");
+    BOOST_REQUIRE(f != NULL);
+    BOOST_CHECK_EQUAL(nrnthread_write(f, nt), mapp::MAPP_OK);
+    fclose(f);
+    NrnThread *r = (NrnThread *) make_nrnthread((void *)name.c_str());
+    std::remove(name.c_str());
+    return r;
+}
+
+BOOST_AUTO_TEST_CASE(generator_test){
+    nrn_generator g;
+    nrn_generator_default(&g);
+    g.ncell = 5;
+    g.ncompartment = 100;
+    NrnThread *nt = (NrnThread *) generate_nrnthread(&g);
+    BOOST_REQUIRE(nt != NULL);
+
+    BOOST_CHECK_EQUAL(nt->ncell, 5);
+    BOOST_CHECK_EQUAL(nt->end, 500);
+    BOOST_CHECK_EQUAL(nt->end_pad, nrn_soa_padded_size(500, 0));
+    BOOST_CHECK_EQUAL(nt->nmech, NRN_GENERATOR_NMECH);
+
+    // the roots first, every other compartment after its parent
+    for(int i = 0; i < nt->ncell; ++i)
+        BOOST_CHECK_EQUAL(nt->_v_parent_index[i], 0);
+    for(int i = nt->ncell; i < nt->end; ++i)
+        BOOST_CHECK(nt->_v_parent_index[i] < i);
+
+    // the kernels find their mechanisms at the index of the provided data set
+    BOOST_CHECK_EQUAL(nt->ml[17].type, 125);
+    BOOST_CHECK_EQUAL(nt->ml[10].type, 69);
+    BOOST_CHECK_EQUAL(nt->ml[18].type, 134);
+
+    long offset = 6 * nt->end_pad;
+    for(int i = 0; i < nt->nmech; ++i){
+        Mechanism const& ml = nt->ml[i];
+        BOOST_CHECK_EQUAL(ml.nodecount_pad, nrn_soa_padded_size(ml.nodecount, 0));
+        BOOST_CHECK_EQUAL(ml.data - nt->_data, offset);
+        offset += ml.nodecount_pad * ml.szp;
+        if(!ml.is_art){
+            for(int j = 0; j < ml.nodecount; ++j){
+                BOOST_CHECK(ml.nodeindices[j] >= 0 && ml.nodeindices[j] < nt->end);
+                if(j > 0)
+                    BOOST_CHECK(ml.nodeindices[j-1] <= ml.nodeindices[j]);
+            }
+        }
+    }
+    BOOST_CHECK(offset <= nt->_ndata);
+
+    // ena, ina and dinadv of Na are the fields of na_ion on the same compartment
+    Mechanism const& na = nt->ml[17];
+    Mechanism const& ion = nt->ml[2];
+    BOOST_REQUIRE(na.nodecount > 0);
+    for(int j = 0; j < na.nodecount; ++j){
+        int e = na.pdata[j] - (ion.data - nt->_data);
+        BOOST_REQUIRE(e >= 0 && e < ion.nodecount);
+        BOOST_CHECK_EQUAL(ion.nodeindices[e], na.nodeindices[j]);
+        BOOST_CHECK_EQUAL(na.pdata[na.nodecount + j], na.pdata[j] + 3 * ion.nodecount);
+        BOOST_CHECK_EQUAL(na.pdata[2 * na.nodecount + j], na.pdata[j] + 4 * ion.nodecount);
+    }
+
+    // the ions start as in bench.101392: ena of Na, cai of the channel 141
+    for(int j = 0; j < na.nodecount; ++j)
+        BOOST_CHECK_EQUAL(nt->_data[na.pdata[j]], 50.);
+    Mechanism const& cal = nt->ml[20];
+    BOOST_CHECK_EQUAL(cal.type, 141);
+    BOOST_REQUIRE_EQUAL(cal.szdp, 4);
+    BOOST_REQUIRE(cal.nodecount > 0);
+    for(int j = 0; j < cal.nodecount; ++j)
+        BOOST_CHECK(nt->_data[cal.pdata[3 * cal.nodecount + j]] != 0.);
+
+    // the area of the compartment of a synapse
+    Mechanism const& syn = nt->ml[18];
+    for(int j = 0; j < syn.nodecount; ++j)
+        BOOST_CHECK_EQUAL(syn.pdata[j], 5 * nt->end_pad + syn.nodeindices[j]);
+
+    // the same shape gives the same data set, and it survives the file
+    NrnThread *same = (NrnThread *) generate_nrnthread(&g);
+    check_equal(nt, same);
+    NrnThread *read = write_read(nt);
+    BOOST_REQUIRE(read != NULL);
+    check_equal(nt, read);
+
+    free_nrnthread(read);
+    free_nrnthread(same);
+    free_nrnthread(nt);
+}
+
+BOOST_AUTO_TEST_CASE(density_test){
+    nrn_generator g;
+    nrn_generator_default(&g);
+    BOOST_CHECK_EQUAL(nrn_generator_density(&g, "Na=0.5,134=4"), 0);
+    BOOST_CHECK_EQUAL(g.density[17], 0.5);
+    BOOST_CHECK_EQUAL(g.density[18], 4.);
+    BOOST_CHECK_EQUAL(nrn_generator_density(&g, "Na=2"), -1); // a channel per compartment
+    BOOST_CHECK_EQUAL(nrn_generator_density(&g, "na_ion=1"), -1); // where the channels are
+    BOOST_CHECK_EQUAL(nrn_generator_density(&g, "fake=1"), -1);
+    BOOST_CHECK_EQUAL(nrn_generator_density(&g, "Na=0.5,"), -1);
+    BOOST_CHECK_EQUAL(nrn_generator_density(&g, "Na"), -1);
+
+    // no Ih at all, everywhere Na
+    g.ncell = 2;
+    g.ncompartment = 30;
+    BOOST_CHECK_EQUAL(nrn_generator_density(&g, "Ih=0,Na=1"), 0);
+    NrnThread *nt = (NrnThread *) generate_nrnthread(&g);
+    BOOST_REQUIRE(nt != NULL);
+    BOOST_CHECK_EQUAL(nt->ml[10].nodecount, 0);
+    BOOST_CHECK_EQUAL(nt->ml[17].nodecount, 60);
+    BOOST_CHECK_EQUAL(nt->ml[2].nodecount, 60);
+    free_nrnthread(nt);
+}
+
+BOOST_AUTO_TEST_CASE(write_bundled_test){
+    // the provided data set is written back in its own format
+    std::string path(mapp::data_test());
+    NrnThread *nt = (NrnThread *) make_nrnthread((void *)path.c_str());
+    BOOST_REQUIRE(nt != NULL);
+    NrnThread *read = write_read(nt);
+    BOOST_REQUIRE(read != NULL);
+    check_equal(nt, read);
+    free_nrnthread(read);
+    free_nrnthread(nt);
+}
+
+BOOST_AUTO_TEST_CASE(generate_miniapp_test){
+    std::vector<std::string> command_v;
+    command_v.push_back("generate");
+    command_v.push_back("--cells");
+    command_v.push_back("4");
+    command_v.push_back("--compartments");
+    command_v.push_back("60");
+    command_v.push_back("--name");
+    command_v.push_back("generate_test");
+    struct storage_stats before, after;
+    storage_get_stats(&before);
+    BOOST_CHECK(mapp::execute(command_v, coreneuron10_generate_execute) == mapp::MAPP_OK);
+
+    // the data set counts in the memory budget
+    storage_get_stats(&after);
+    NrnThread *nt = (NrnThread *) storage_get("generate_test", make_nrnthread, NULL, free_nrnthread);
+    BOOST_REQUIRE(nt != NULL);
+    BOOST_CHECK_EQUAL(after.used - before.used, size_nrnthread(nt));
+
+    // the other miniapps run on it by name
+    std::vector<std::string> kernel_v;
+    kernel_v.push_back("kernel");
+    kernel_v.push_back("--mechanism");
+    kernel_v.push_back("Na");
+    kernel_v.push_back("--function");
+    kernel_v.push_back("current");
+    kernel_v.push_back("--name");
+    kernel_v.push_back("generate_test");
+    BOOST_CHECK(mapp::execute(kernel_v, coreneuron10_kernel_execute) == mapp::MAPP_OK);
+    std::vector<std::string> cstep_v;
+    cstep_v.push_back("cstep");
+    cstep_v.push_back("--name");
+    cstep_v.push_back("generate_test");
+    BOOST_CHECK(mapp::execute(cstep_v, coreneuron10_cstep_execute) == mapp::MAPP_OK);
+    storage_clear("generate_test");
+
+    command_v[4] = "1";
+    BOOST_CHECK(mapp::execute(command_v, coreneuron10_generate_execute) == mapp::MAPP_BAD_ARG);
+    command_v[4] = "60";
+    command_v.push_back("--density");
+    command_v.push_back("Na=2");
+    BOOST_CHECK(mapp::execute(command_v, coreneuron10_generate_execute) == mapp::MAPP_BAD_ARG);
+    command_v.pop_back();
+    command_v.pop_back();
+    command_v.push_back("--output");
+    command_v.push_back("/fake/and/wrong");
+    BOOST_CHECK(mapp::execute(command_v, coreneuron10_generate_execute) == mapp::MAPP_BAD_ARG);
+}
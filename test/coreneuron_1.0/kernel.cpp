@@ -26,12 +26,27 @@
 
 #define BOOST_TEST_MODULE KernelTest
 #include <vector>
+#include <sstream>
+#include <algorithm>
+#include <cmath>
 
 #include <boost/test/unit_test.hpp>
 #include <boost/test/test_case_template.hpp>
 #include <boost/filesystem.hpp>
 
 #include "coreneuron_1.0/kernel/kernel.h" // signature kernel application
+#include "coreneuron_1.0/kernel/mechanism/descriptor.h"
+#include "coreneuron_1.0/kernel/mechanism/mechanism.h"
+#include "coreneuron_1.0/kernel/mechanism/isa.h"
+#include "coreneuron_1.0/kernel/mechanism/template/kernels.h"
+#include "coreneuron_1.0/kernel/mechanism/template/NaTs2_t.h"
+#include "coreneuron_1.0/kernel/mechanism/template/Ih.h"
+#include "coreneuron_1.0/kernel/mechanism/template/ProbAMPANMDA_EMS.h"
+#include "coreneuron_1.0/kernel/nmodl/nmodl.h"
+#include "coreneuron_1.0/kernel/nmodl/registry.h"
+#include "coreneuron_1.0/common/util/nrnthread_handler.h"
+#include "coreneuron_1.0/common/memory/memory.h"
+#include "coreneuron_1.0/common/util/affinity.h"
 #include "neuromapp/coreneuron_1.0/common/data/path.h" // this file is generated automatically
 #include "coreneuron_1.0/common/data/helper.h" // common functionalities
 #include "utils/error.h"
@@ -172,3 +187,535 @@ BOOST_AUTO_TEST_CASE(kernels_reference_solution_test){
         mapp::helper_check(command_v[8],mechanisms[i],path);
     }
 }
+
+BOOST_AUTO_TEST_CASE(kernels_reference_solution_share_test){
+    std::string path(mapp::data_test());
+    std::string mechanisms[3] = {"Na","Ih","ProbAMPANMDA"};
+
+    std::vector<std::string> command_v;
+    command_v.push_back("coreneuron10_kernel_execute");
+    command_v.push_back("--mechanism");
+    command_v.push_back("mechanism");
+    command_v.push_back("--function");
+    command_v.push_back("state");
+    command_v.push_back("--data");
+    command_v.push_back(path);
+    command_v.push_back("--name");
+    command_v.push_back("dummy");
+    command_v.push_back("--clone");
+    command_v.push_back("share");
+
+    // the clones sharing the index arrays compute the same solution
+    for(size_t i(0); i < 3 ;++i){
+        command_v[2] = mechanisms[i];
+        command_v[4] = "state";
+        command_v[8] = "internal_storage_share_"+mechanisms[i];
+        BOOST_CHECK(mapp::execute(command_v,coreneuron10_kernel_execute)==mapp::MAPP_OK);
+        command_v[4] = "current";
+        BOOST_CHECK(mapp::execute(command_v,coreneuron10_kernel_execute)==mapp::MAPP_OK);
+        mapp::helper_check(command_v[8],mechanisms[i],path);
+    }
+
+    command_v[10] = "wrong";
+    BOOST_CHECK(mapp::execute(command_v,coreneuron10_kernel_execute)==mapp::MAPP_BAD_ARG);
+}
+
+BOOST_AUTO_TEST_CASE(share_nrnthread_test){
+    std::string path(mapp::data_test());
+    NrnThread *nt = (NrnThread *) make_nrnthread((void *)path.c_str());
+    BOOST_REQUIRE(nt != NULL);
+
+    NrnThread *copy = (NrnThread *) clone_nrnthread(nt);
+    NrnThread *shared = (NrnThread *) share_nrnthread(nt);
+    BOOST_CHECK(shared->_v_parent_index == nt->_v_parent_index);
+    BOOST_CHECK(shared->ml[17].nodeindices == nt->ml[17].nodeindices);
+    BOOST_CHECK(shared->_data != nt->_data);
+    BOOST_CHECK(*shared->_shared_count == 2);
+
+    // the index arrays outlive the original
+    free_nrnthread(nt);
+    BOOST_CHECK(*shared->_shared_count == 1);
+    for(int i=0; i < copy->end; ++i)
+        BOOST_CHECK(shared->_v_parent_index[i] == copy->_v_parent_index[i]);
+    for(int i=0; i < copy->ml[17].nodecount; ++i)
+        BOOST_CHECK(shared->ml[17].nodeindices[i] == copy->ml[17].nodeindices[i]);
+
+    free_nrnthread(shared);
+    free_nrnthread(copy);
+}
+
+BOOST_AUTO_TEST_CASE(arena_nrnthread_test){
+    std::string path(mapp::data_test());
+    NrnThread *nt = (NrnThread *) make_nrnthread((void *)path.c_str());
+    BOOST_REQUIRE(nt != NULL);
+
+    // every array lives in the single allocation
+    const char *begin = (const char *) nt->_arena;
+    const char *end = begin + nt->_arena_size;
+    BOOST_CHECK(nt->_index_arena == nt->_arena);
+    BOOST_CHECK((const char *)nt->_data >= begin && (const char *)(nt->_data + nt->_ndata) <= end);
+    BOOST_CHECK((const char *)nt->_v_parent_index >= begin && (const char *)(nt->_v_parent_index + nt->end_pad) <= end);
+    for(int i=0; i < nt->nmech; ++i){
+        BOOST_CHECK(nt->ml[i].data >= nt->_data && nt->ml[i].data < nt->_data + nt->_ndata);
+        if(!nt->ml[i].is_art)
+            BOOST_CHECK((const char *)nt->ml[i].nodeindices >= begin && (const char *)nt->ml[i].nodeindices < end);
+        if(nt->ml[i].szdp)
+            BOOST_CHECK((const char *)nt->ml[i].pdata >= begin && (const char *)nt->ml[i].pdata < end);
+    }
+
+    // the copy is relocated to its own arena with the same content
+    NrnThread *copy = (NrnThread *) clone_nrnthread(nt);
+    BOOST_CHECK(copy->_arena != nt->_arena && copy->_arena_size == nt->_arena_size);
+    BOOST_CHECK(std::equal(nt->_data, nt->_data + nt->_ndata, copy->_data));
+    for(int i=0; i < nt->nmech; ++i){
+        BOOST_CHECK(copy->ml[i].data >= copy->_data && copy->ml[i].data < copy->_data + copy->_ndata);
+        if(!nt->ml[i].is_art)
+            BOOST_CHECK(std::equal(nt->ml[i].nodeindices, nt->ml[i].nodeindices + nt->ml[i].nodecount_pad, copy->ml[i].nodeindices));
+    }
+
+    // a shared clone allocates only the mutable part
+    NrnThread *shared = (NrnThread *) share_nrnthread(nt);
+    BOOST_CHECK(shared->_index_arena == nt->_arena && shared->_arena_size < nt->_arena_size);
+
+    free_nrnthread(shared);
+    free_nrnthread(copy);
+    free_nrnthread(nt);
+}
+
+BOOST_AUTO_TEST_CASE(descriptor_test){
+    std::string path(mapp::data_test());
+    NrnThread *nt = (NrnThread *) make_nrnthread((void *)path.c_str());
+    BOOST_REQUIRE(nt != NULL);
+
+    // every kernel has a descriptor which fits in the layout of its mechanism
+    BOOST_CHECK_EQUAL(mech_ndescriptors, 6);
+    for(int i=0; i < mech_ndescriptors; ++i){
+        const mech_descriptor &d = mech_descriptors[i];
+        BOOST_CHECK(mech_descriptor_find(d.mechanism, d.function) == &d);
+        BOOST_REQUIRE(d.mech_id < nt->nmech);
+        BOOST_CHECK_EQUAL(mech_descriptor_check(&d, &nt->ml[d.mech_id]), 0);
+        BOOST_CHECK(mech_flops(&d, &nt->ml[d.mech_id]) > 0.);
+        BOOST_CHECK(mech_stream_bytes(&d, &nt->ml[d.mech_id]) > 0.);
+    }
+    BOOST_CHECK(mech_descriptor_find("Na", "fake") == NULL);
+
+    // m, h read, m, h, ena written, _ni and _ppvar[0] streamed, v and ena gathered
+    const mech_descriptor *na = mech_descriptor_find("Na", "state");
+    const Mechanism &ml = nt->ml[na->mech_id];
+    BOOST_CHECK_EQUAL(mech_stream_bytes(na, &ml), ml.nodecount * (5 * sizeof(double) + 2 * sizeof(int)));
+    BOOST_CHECK_EQUAL(mech_gather_bytes(na, &ml), ml.nodecount * 2 * sizeof(double));
+    BOOST_CHECK_EQUAL(mech_scatter_bytes(na, &ml), 0.);
+    BOOST_CHECK_EQUAL(mech_flops(na, &ml), ml.nodecount * (52. + 6 * MECH_EXP_FLOPS));
+    free_nrnthread(nt);
+}
+
+BOOST_AUTO_TEST_CASE(template_kernels_test){
+    std::string path(mapp::data_test());
+    NrnThread *nt = (NrnThread *) make_nrnthread((void *)path.c_str());
+    BOOST_REQUIRE(nt != NULL);
+
+    // the descriptors as types fit the data
+    BOOST_CHECK_EQUAL(nt->ml[17].type, (int) mechanism::NaTs2_t::type);
+    BOOST_CHECK_EQUAL(nt->ml[17].szp, (int) mechanism::NaTs2_t::szp);
+    BOOST_CHECK_EQUAL(nt->ml[17].szdp, (int) mechanism::NaTs2_t::szdp);
+    BOOST_CHECK_EQUAL(nt->ml[10].type, (int) mechanism::Ih::type);
+    BOOST_CHECK_EQUAL(nt->ml[10].szp, (int) mechanism::Ih::szp);
+    BOOST_CHECK_EQUAL(nt->ml[18].type, (int) mechanism::ProbAMPANMDA_EMS::type);
+    BOOST_CHECK_EQUAL(nt->ml[18].szp, (int) mechanism::ProbAMPANMDA_EMS::szp);
+    BOOST_CHECK_EQUAL(nt->ml[18].szdp, (int) mechanism::ProbAMPANMDA_EMS::szdp);
+
+    BOOST_CHECK(mech_template_kernel("Na", "state", 3) == NULL);
+    BOOST_CHECK(mech_template_kernel("fake", "state", 4) == NULL);
+    BOOST_CHECK(mech_template_kernel("Na", "fake", 4) == NULL);
+    BOOST_CHECK(mech_template_kernel("Na", "state", 0) == mech_template_kernel("Na", "state", NRN_SOA_PAD));
+
+    // every width computes what the C kernel does, the tails included
+    const char *mechanisms[3] = {"Na", "Ih", "ProbAMPANMDA"};
+    const int mech_id[3] = {17, 10, 18};
+    const char *functions[2] = {"state", "current"};
+    mech_kernel c_kernels[3][2] = {{mech_state_NaTs2_t, mech_current_NaTs2_t},
+                                   {mech_state_Ih, mech_current_Ih},
+                                   {mech_state_ProbAMPANMDA_EMS, mech_current_ProbAMPANMDA_EMS}};
+    const int widths[4] = {1, 2, 4, 8};
+    for(int w = 0; w < 4; ++w){
+        for(int i = 0; i < 3; ++i){
+            for(int f = 0; f < 2; ++f){
+                NrnThread *c = (NrnThread *) clone_nrnthread(nt);
+                NrnThread *t = (NrnThread *) clone_nrnthread(nt);
+                mech_kernel kernel = mech_template_kernel(mechanisms[i], functions[f], widths[w]);
+                BOOST_REQUIRE(kernel != NULL);
+                c_kernels[i][f](c, &c->ml[mech_id[i]]);
+                kernel(t, &t->ml[mech_id[i]]);
+                double error = 0.;
+                for(int k = 0; k < nt->_ndata; ++k)
+                    if(c->_data[k] != t->_data[k])
+                        error = std::max(error, std::fabs(c->_data[k] - t->_data[k]) / std::fabs(c->_data[k]));
+                BOOST_CHECK_SMALL(error, 1e-12);
+                free_nrnthread(t);
+                free_nrnthread(c);
+            }
+        }
+    }
+    free_nrnthread(nt);
+}
+
+BOOST_AUTO_TEST_CASE(template_reference_solution_test){
+    std::string path(mapp::data_test());
+    std::string mechanisms[3] = {"Na","Ih","ProbAMPANMDA"};
+
+    std::vector<std::string> command_v;
+    command_v.push_back("coreneuron10_kernel_execute");
+    command_v.push_back("--mechanism");
+    command_v.push_back("mechanism");
+    command_v.push_back("--function");
+    command_v.push_back("state");
+    command_v.push_back("--data");
+    command_v.push_back(path);
+    command_v.push_back("--name");
+    command_v.push_back("dummy");
+    command_v.push_back("--variant");
+    command_v.push_back("template");
+    command_v.push_back("--width");
+    command_v.push_back("8");
+
+    for(size_t i(0); i < 3 ;++i){
+        command_v[2] = mechanisms[i];
+        command_v[4] = "state";
+        command_v[8] = "internal_storage_template_"+mechanisms[i];
+        BOOST_CHECK(mapp::execute(command_v,coreneuron10_kernel_execute)==mapp::MAPP_OK);
+        command_v[4] = "current";
+        BOOST_CHECK(mapp::execute(command_v,coreneuron10_kernel_execute)==mapp::MAPP_OK);
+        mapp::helper_check(command_v[8],mechanisms[i],path);
+    }
+
+    command_v[12] = "3";
+    BOOST_CHECK(mapp::execute(command_v,coreneuron10_kernel_execute)==mapp::MAPP_BAD_ARG);
+    command_v[10] = "wrong";
+    command_v[12] = "4";
+    BOOST_CHECK(mapp::execute(command_v,coreneuron10_kernel_execute)==mapp::MAPP_BAD_ARG);
+}
+
+BOOST_AUTO_TEST_CASE(isa_test){
+    enum mech_isa isa;
+    BOOST_CHECK(mech_isa_supported(MECH_ISA_BASE));
+    BOOST_CHECK(mech_isa_supported(mech_isa_best()));
+    BOOST_CHECK_EQUAL(mech_get_isa(), mech_isa_best());
+    BOOST_CHECK(mech_isa_from_string("auto", &isa) == 0 && isa == mech_isa_best());
+    BOOST_CHECK(mech_isa_from_string("avx2", &isa) == 0 && isa == MECH_ISA_AVX2);
+    BOOST_CHECK(mech_isa_from_string("sse2", &isa) != 0);
+    BOOST_CHECK_EQUAL(std::string(mech_isa_name(MECH_ISA_AVX512)), "avx512");
+    BOOST_CHECK(mech_set_isa(MECH_ISA_COUNT) != 0);
+
+    // every instruction set computes what the base one does, up to the contractions in FMA
+    std::string path(mapp::data_test());
+    NrnThread *nt = (NrnThread *) make_nrnthread((void *)path.c_str());
+    BOOST_REQUIRE(nt != NULL);
+    const int mech_id[3] = {17, 10, 18};
+    mech_kernel kernels[3][2] = {{mech_state_NaTs2_t, mech_current_NaTs2_t},
+                                 {mech_state_Ih, mech_current_Ih},
+                                 {mech_state_ProbAMPANMDA_EMS, mech_current_ProbAMPANMDA_EMS}};
+    for(int i = 0; i < 3; ++i){
+        for(int f = 0; f < 2; ++f){
+            BOOST_REQUIRE(mech_set_isa(MECH_ISA_BASE) == 0);
+            NrnThread *base = (NrnThread *) clone_nrnthread(nt);
+            kernels[i][f](base, &base->ml[mech_id[i]]);
+            for(int k = MECH_ISA_SSE4; k < MECH_ISA_COUNT; ++k){
+                if(!mech_isa_supported((enum mech_isa) k)){
+                    BOOST_CHECK(mech_set_isa((enum mech_isa) k) != 0);
+                    continue;
+                }
+                BOOST_REQUIRE(mech_set_isa((enum mech_isa) k) == 0);
+                NrnThread *copy = (NrnThread *) clone_nrnthread(nt);
+                kernels[i][f](copy, &copy->ml[mech_id[i]]);
+                double error = 0.;
+                for(int j = 0; j < nt->_ndata; ++j)
+                    if(base->_data[j] != copy->_data[j])
+                        error = std::max(error, std::fabs(base->_data[j] - copy->_data[j]) / std::fabs(base->_data[j]));
+                BOOST_CHECK_SMALL(error, 1e-10);
+                free_nrnthread(copy);
+            }
+            free_nrnthread(base);
+        }
+    }
+    BOOST_CHECK(mech_set_isa(mech_isa_best()) == 0);
+    free_nrnthread(nt);
+}
+
+BOOST_AUTO_TEST_CASE(isa_reference_solution_test){
+    std::string path(mapp::data_test());
+    std::string mechanisms[3] = {"Na","Ih","ProbAMPANMDA"};
+    std::string isas[4] = {"base","sse4","avx2","avx512"};
+
+    std::vector<std::string> command_v;
+    command_v.push_back("coreneuron10_kernel_execute");
+    command_v.push_back("--mechanism");
+    command_v.push_back("mechanism");
+    command_v.push_back("--function");
+    command_v.push_back("state");
+    command_v.push_back("--data");
+    command_v.push_back(path);
+    command_v.push_back("--name");
+    command_v.push_back("dummy");
+    command_v.push_back("--isa");
+    command_v.push_back("base");
+
+    for(size_t k(0); k < 4; ++k){
+        enum mech_isa isa;
+        BOOST_REQUIRE(mech_isa_from_string(isas[k].c_str(), &isa) == 0);
+        command_v[10] = isas[k];
+        if(!mech_isa_supported(isa)){
+            BOOST_CHECK(mapp::execute(command_v,coreneuron10_kernel_execute)==mapp::MAPP_BAD_ARG);
+            continue;
+        }
+        for(size_t i(0); i < 3 ;++i){
+            command_v[2] = mechanisms[i];
+            command_v[4] = "state";
+            command_v[8] = "internal_storage_"+isas[k]+"_"+mechanisms[i];
+            BOOST_CHECK(mapp::execute(command_v,coreneuron10_kernel_execute)==mapp::MAPP_OK);
+            command_v[4] = "current";
+            BOOST_CHECK(mapp::execute(command_v,coreneuron10_kernel_execute)==mapp::MAPP_OK);
+            mapp::helper_check(command_v[8],mechanisms[i],path);
+        }
+        // the miniapp restores the instruction set of the process
+        BOOST_CHECK_EQUAL(mech_get_isa(), mech_isa_best());
+    }
+
+    command_v[10] = "sse2";
+    BOOST_CHECK(mapp::execute(command_v,coreneuron10_kernel_execute)==mapp::MAPP_BAD_ARG);
+}
+
+/** largest difference of the doubles of a and b, relative to the largest of both */
+static double max_error(const double *a, const double *b, int n){
+    double error = 0.;
+    for(int i = 0; i < n; ++i)
+        if(a[i] != b[i])
+            error = std::max(error, std::fabs(a[i] - b[i]) / std::max(std::fabs(a[i]), std::fabs(b[i])));
+    return error;
+}
+
+BOOST_AUTO_TEST_CASE(nmodl_kernels_test){
+    std::string path(mapp::data_test());
+    NrnThread *nt = (NrnThread *) make_nrnthread((void *)path.c_str());
+    BOOST_REQUIRE(nt != NULL);
+
+    BOOST_CHECK_EQUAL(mech_nmodl_nkernels, 3);
+    BOOST_CHECK(mech_nmodl_find("Na") == NULL);
+    const struct mech_nmodl *ih = mech_nmodl_find("Ih");
+    const struct mech_nmodl *na = mech_nmodl_find("NaTs2_t");
+    const struct mech_nmodl *sk = mech_nmodl_find("SKv3_1");
+    BOOST_REQUIRE(ih != NULL && na != NULL && sk != NULL);
+    // the layouts of the descriptions are the ones of the data set
+    BOOST_CHECK(mech_nmodl_data(ih, nt) == &nt->ml[10]);
+    BOOST_CHECK(mech_nmodl_data(na, nt) == &nt->ml[17]);
+    BOOST_CHECK(mech_nmodl_data(sk, nt) != NULL);
+    struct mech_nmodl wrong = *sk;
+    wrong.szp += 1;
+    BOOST_CHECK(mech_nmodl_data(&wrong, nt) == NULL);
+
+    // the generated kernels compute what the hand written ones do, with their
+    // time steps, the conductance by a finite difference as nocmodl
+    struct { const struct mech_nmodl *k; int id; double dt; mech_kernel state, current; } cases[2] = {
+        {ih, 10, 0.1, mech_state_Ih, mech_current_Ih},
+        {na, 17, 0.001, mech_state_NaTs2_t, mech_current_NaTs2_t}};
+    for(int i = 0; i < 2; ++i){
+        NrnThread *c = (NrnThread *) clone_nrnthread(nt);
+        NrnThread *g = (NrnThread *) clone_nrnthread(nt);
+        c->dt = g->dt = cases[i].dt;
+        cases[i].state(c, &c->ml[cases[i].id]);
+        cases[i].k->state(g, &g->ml[cases[i].id]);
+        BOOST_CHECK_SMALL(max_error(c->_data, g->_data, nt->_ndata), 1e-12);
+        cases[i].current(c, &c->ml[cases[i].id]);
+        cases[i].k->current(g, &g->ml[cases[i].id]);
+        BOOST_CHECK_SMALL(max_error(c->_actual_rhs, g->_actual_rhs, nt->end), 1e-12);
+        BOOST_CHECK_SMALL(max_error(c->_actual_d, g->_actual_d, nt->end), 1e-8);
+        free_nrnthread(g);
+        free_nrnthread(c);
+    }
+
+    // SKv3_1 has no hand written kernel: its gates stay in [0, 1]
+    Mechanism *ml = mech_nmodl_data(sk, nt);
+    sk->state(nt, ml);
+    sk->current(nt, ml);
+    for(int i = 0; i < ml->nodecount; ++i)
+        BOOST_CHECK(ml->data[ml->nodecount + i] >= 0. && ml->data[ml->nodecount + i] <= 1.);
+    free_nrnthread(nt);
+}
+
+/** the message of the error of the description, empty if it is generated */
+static std::string nmodl_error(const std::string &description){
+    std::istringstream in(description);
+    std::ostringstream out;
+    try {
+        nmodl::write_kernels(out, nmodl::parse(in), "test.mod");
+    } catch(nmodl::error &e) {
+        return e.what();
+    }
+    return "";
+}
+
+BOOST_AUTO_TEST_CASE(nmodl_generator_test){
+    std::string neuron = "NEURON { SUFFIX test\n USEION k READ ek WRITE ik\n RANGE gbar\n }\n"
+                         "PARAMETER { gbar = 0.1 (S/cm2) <0,1e9>\n }\n"
+                         "ASSIGNED { v (mV)\n ek (mV)\n ik (mA/cm2)\n }\n"
+                         "STATE { n }\n";
+    std::string breakpoint = "BREAKPOINT { SOLVE states METHOD cnexp\n ik = gbar*n*(v-ek)\n }\n";
+    std::string derivative = "DERIVATIVE states { n' = (1-n)/2 }\n";
+
+    BOOST_CHECK_EQUAL(nmodl_error(neuron + breakpoint + derivative), "");
+
+    std::istringstream in(neuron + breakpoint + derivative);
+    nmodl::model m = nmodl::parse(in);
+    std::vector<std::string> fields = m.fields();
+    std::vector<std::string> pdata = m.pdata();
+    BOOST_REQUIRE_EQUAL(fields.size(), 6u);
+    BOOST_CHECK(fields[0] == "gbar" && fields[1] == "n" && fields[2] == "ek" && fields[3] == "Dn");
+    BOOST_REQUIRE_EQUAL(pdata.size(), 3u);
+    BOOST_CHECK(pdata[0] == "_ion_ek" && pdata[1] == "_ion_ik" && pdata[2] == "_ion_dikdv");
+
+    BOOST_CHECK(nmodl_error(neuron + breakpoint + "DERIVATIVE states { n' = (1-n)/tau }\n") != "");
+    BOOST_CHECK(nmodl_error(neuron + breakpoint + "DERIVATIVE states { n' = (1-n)^2 }\n") != "");
+    BOOST_CHECK(nmodl_error(neuron + breakpoint + "DERIVATIVE states { v' = 1-v }\n") != "");
+    BOOST_CHECK(nmodl_error(neuron + breakpoint + "DERIVATIVE states { n' = rate(v) }\n") != "");
+    BOOST_CHECK(nmodl_error(neuron + breakpoint + "DERIVATIVE other { n' = 1-n }\n") != "");
+    BOOST_CHECK(nmodl_error(neuron + "BREAKPOINT { SOLVE states METHOD derivimplicit\n ik = 0\n }\n" + derivative) != "");
+    BOOST_CHECK(nmodl_error(neuron + breakpoint + derivative + "PROCEDURE rates() { }\n") != "");
+    BOOST_CHECK(nmodl_error("NEURON { POINT_PROCESS test }\n") != "");
+    BOOST_CHECK(nmodl_error(neuron + breakpoint + "DERIVATIVE states { tau = 1\n n' = 1-n }\n") != "");
+
+    // cnexp solves x' = a + b*x only
+    BOOST_CHECK(nmodl_error(neuron + breakpoint + "DERIVATIVE states { n' = (1-n)*(1-n) }\n") != "");
+    BOOST_CHECK(nmodl_error(neuron + breakpoint + "DERIVATIVE states { n' = n*n }\n") != "");
+    BOOST_CHECK(nmodl_error(neuron + breakpoint + "DERIVATIVE states { n' = exp(n) }\n") != "");
+    BOOST_CHECK(nmodl_error(neuron + breakpoint + "DERIVATIVE states { LOCAL a\n a = n*gbar\n n' = a*n }\n") != "");
+    BOOST_CHECK_EQUAL(nmodl_error(neuron + breakpoint + "DERIVATIVE states { n' = gbar*(2*n-1)/3 }\n"), "");
+
+    // b = 0: x + a*dt, not - a/b
+    std::istringstream constant(neuron + breakpoint + "DERIVATIVE states { n' = 0.5 }\n");
+    std::ostringstream out;
+    nmodl::write_kernels(out, nmodl::parse(constant), "test.mod");
+    BOOST_CHECK(out.str().find("n = n + _dt * ( 0.5 ) ;") != std::string::npos);
+    BOOST_CHECK(out.str().find("_b") == std::string::npos);
+}
+
+BOOST_AUTO_TEST_CASE(nmodl_miniapp_test){
+    std::string path(mapp::data_test());
+    std::string mechanisms[3] = {"Ih","NaTs2_t","SKv3_1"};
+
+    std::vector<std::string> command_v;
+    command_v.push_back("coreneuron10_kernel_execute");
+    command_v.push_back("--mechanism");
+    command_v.push_back("mechanism");
+    command_v.push_back("--function");
+    command_v.push_back("state");
+    command_v.push_back("--data");
+    command_v.push_back(path);
+    command_v.push_back("--name");
+    command_v.push_back("dummy");
+    command_v.push_back("--variant");
+    command_v.push_back("nmodl");
+
+    for(size_t i(0); i < 3 ;++i){
+        command_v[2] = mechanisms[i];
+        command_v[8] = "internal_storage_nmodl_"+mechanisms[i];
+        command_v[4] = "state";
+        BOOST_CHECK(mapp::execute(command_v,coreneuron10_kernel_execute)==mapp::MAPP_OK);
+        command_v[4] = "current";
+        BOOST_CHECK(mapp::execute(command_v,coreneuron10_kernel_execute)==mapp::MAPP_OK);
+    }
+
+    // the generated mechanisms only with nmodl, the hand written ones only without
+    command_v[2] = "Na";
+    BOOST_CHECK(mapp::execute(command_v,coreneuron10_kernel_execute)==mapp::MAPP_BAD_ARG);
+    command_v[2] = "SKv3_1";
+    command_v[10] = "c";
+    BOOST_CHECK(mapp::execute(command_v,coreneuron10_kernel_execute)==mapp::MAPP_BAD_ARG);
+}
+
+BOOST_AUTO_TEST_CASE(alloc_policy_test){
+    enum nrn_alloc_policy policy;
+    BOOST_CHECK(nrn_alloc_policy_from_string("wrong",&policy)!=0);
+
+    const char *names[4] = {"default","hugepage","firsttouch","interleave"};
+    for(int i=0; i < 4; ++i){
+        BOOST_REQUIRE(nrn_alloc_policy_from_string(names[i],&policy)==0);
+        BOOST_CHECK(std::string(nrn_alloc_policy_name(policy))==names[i]);
+        nrn_set_alloc_policy(policy);
+
+        // small arrays stay on the heap, the large ones are mapped
+        size_t sizes[2] = {100, 1<<22};
+        for(int j=0; j < 2; ++j){
+            double *p = (double *) ecalloc_align(sizes[j], NRN_SOA_BYTE_ALIGN, sizeof(double));
+            BOOST_CHECK(is_aligned(p, NRN_SOA_BYTE_ALIGN));
+            BOOST_CHECK(p[0]==0. && p[sizes[j]-1]==0.);
+            p[sizes[j]-1] = 1.;
+            efree_align(p);
+        }
+    }
+
+    // a data set loaded with a policy computes as the default one
+    nrn_set_alloc_policy(NRN_ALLOC_HUGEPAGE);
+    std::string path(mapp::data_test());
+    NrnThread *nt = (NrnThread *) make_nrnthread((void *)path.c_str());
+    nrn_set_alloc_policy(NRN_ALLOC_DEFAULT);
+    NrnThread *ref = (NrnThread *) make_nrnthread((void *)path.c_str());
+    BOOST_REQUIRE(nt != NULL && ref != NULL);
+    BOOST_CHECK(std::equal(nt->_data, nt->_data + nt->_ndata, ref->_data));
+    free_nrnthread(nt);
+    free_nrnthread(ref);
+
+    // the miniapp restores the policy, the next ones of a batch allocate as before
+    std::vector<std::string> command_v;
+    command_v.push_back("coreneuron10_kernel_execute");
+    command_v.push_back("--mechanism");
+    command_v.push_back("Na");
+    command_v.push_back("--function");
+    command_v.push_back("state");
+    command_v.push_back("--data");
+    command_v.push_back(path);
+    command_v.push_back("--name");
+    command_v.push_back("internal_storage_alloc");
+    command_v.push_back("--alloc");
+    command_v.push_back("hugepage");
+    BOOST_CHECK(mapp::execute(command_v,coreneuron10_kernel_execute)==mapp::MAPP_OK);
+    BOOST_CHECK(nrn_get_alloc_policy()==NRN_ALLOC_DEFAULT);
+    command_v[6] = "wrong_path";
+    command_v[8] = "internal_storage_alloc_wrong";
+    BOOST_CHECK(mapp::execute(command_v,coreneuron10_kernel_execute)!=mapp::MAPP_OK);
+    BOOST_CHECK(nrn_get_alloc_policy()==NRN_ALLOC_DEFAULT);
+}
+
+BOOST_AUTO_TEST_CASE(bind_test){
+    std::vector<int> compact(1024), scatter(1024), list(1024);
+    BOOST_CHECK(nrn_bind_order("none", &compact[0], 1024) == 0);
+    int n = nrn_bind_order("compact", &compact[0], 1024);
+    BOOST_REQUIRE(n >= 1);
+
+    // scatter places the same cpus in another order
+    BOOST_REQUIRE(nrn_bind_order("scatter", &scatter[0], 1024) == n);
+    std::sort(scatter.begin(), scatter.begin() + n);
+    std::vector<int> sorted(compact.begin(), compact.begin() + n);
+    std::sort(sorted.begin(), sorted.end());
+    BOOST_CHECK(std::equal(sorted.begin(), sorted.end(), scatter.begin()));
+
+    // an explicit list of the allowed cpus
+    std::stringstream spec;
+    spec << compact[0] << "-" << compact[0] << "," << compact[0];
+    BOOST_CHECK(nrn_bind_order(spec.str().c_str(), &list[0], 1024) == 2);
+    BOOST_CHECK(list[0] == compact[0] && list[1] == compact[0]);
+
+    const char *wrong[5] = {"foo", "3-1", "0,", "-1", "99999"};
+    for(int i=0; i < 5; ++i)
+        BOOST_CHECK(nrn_bind_check(wrong[i]) != 0);
+
+    std::vector<std::string> command_v;
+    command_v.push_back("coreneuron10_kernel_execute");
+    command_v.push_back("--data");
+    command_v.push_back(mapp::data_test());
+    command_v.push_back("--bind");
+    command_v.push_back("foo");
+    BOOST_CHECK(mapp::execute(command_v,coreneuron10_kernel_execute)==mapp::MAPP_BAD_ARG);
+    command_v[4] = "compact";
+    BOOST_CHECK(mapp::execute(command_v,coreneuron10_kernel_execute)==mapp::MAPP_OK);
+    command_v[4] = "none";
+    BOOST_CHECK(mapp::execute(command_v,coreneuron10_kernel_execute)==mapp::MAPP_OK);
+}
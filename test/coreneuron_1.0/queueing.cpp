@@ -31,12 +31,14 @@
 
 #include <vector>
 #include <string>
+#include <algorithm>
 #include <sstream>
 #include <iostream>
 #include <fstream>
 #include "coreneuron_1.0/queueing/queueing.h"
 #include "coreneuron_1.0/queueing/pool.h"
 #include "coreneuron_1.0/queueing/thread.h"
+#include "coreneuron_1.0/queueing/histogram.h"
 #include "utils/error.h"
 #include "utils/storage/neuromapp_data.h"
 #include "coreneuron_1.0/common/data/helper.h"
@@ -219,7 +221,213 @@ BOOST_AUTO_TEST_CASE(spike_enabled){
     neuromapp_data.clear("spikes");
 }
 
+BOOST_AUTO_TEST_CASE(windowed){
+    char arg1[]="NULL";
+    char arg2[]="--numthread=8";
+    char arg3[]="--eventsper=25";
+    char arg4[]="--simtime=25";
+    char arg5[]="--percent-ite=0";
+    char arg6[]="--spike-enabled";
+    char arg7[]="--windowed";
+    char * const argv[] = {arg1, arg2, arg3, arg4, arg5, arg6, arg7};
+    int argc = 7;
+    BOOST_CHECK(queueing_execute(argc,argv)==0);
+
+    const int simtime = 25;
+    const int cellgroups = 64;
+    const int eventsper = 25;
+    const int percentspike = 3;
+    const int spikes = simtime * cellgroups * eventsper * percentspike / 100;
+    //same number of spikes as the serial injection
+    BOOST_CHECK(neuromapp_data.get<int>("spikes") == spikes);
+    //every spike was gathered by its destination
+    BOOST_CHECK(neuromapp_data.get<int>("enqueued") ==
+		    (simtime * cellgroups * eventsper + spikes));
+    BOOST_CHECK(neuromapp_data.get<int>("inter_received") == 0);
+    BOOST_CHECK(neuromapp_data.has<double>("compute_time"));
+    BOOST_CHECK(neuromapp_data.has<double>("exchange_time"));
+    BOOST_CHECK(neuromapp_data.has<double>("wait_time"));
+    neuromapp_data.clear("inter_received");
+    neuromapp_data.clear("enqueued");
+    neuromapp_data.clear("delivered");
+    neuromapp_data.clear("spikes");
+    neuromapp_data.clear("compute_time");
+    neuromapp_data.clear("exchange_time");
+    neuromapp_data.clear("wait_time");
+}
+
+BOOST_AUTO_TEST_CASE(ncellgroups){
+    char arg1[]="NULL";
+    char arg2[]="--numthread=8";
+    char arg3[]="--eventsper=25";
+    char arg4[]="--simtime=25";
+    char arg5[]="--percent-ite=0";
+    char arg6[]="--ncellgroups=128";
+    char * const argv[] = {arg1, arg2, arg3, arg4, arg5, arg6};
+    int argc = 6;
+    BOOST_CHECK(queueing_execute(argc,argv)==0);
+
+    std::string key2("enqueued");
+    BOOST_CHECK(neuromapp_data.has<int>(key2));
+
+    const int simtime = 25;
+    const int cellgroups = 128;
+    const int eventsper = 25;
+    //verify that the work scales with the number of cell groups
+    BOOST_CHECK(neuromapp_data.get<int>(key2) == (simtime * cellgroups * eventsper));
+    neuromapp_data.clear("inter_received");
+    neuromapp_data.clear("enqueued");
+    neuromapp_data.clear("delivered");
+    neuromapp_data.clear("spikes");
+
+    char arg7[]="--ncellgroups=0";
+    char * const argv_bad[] = {arg1, arg2, arg7};
+    BOOST_CHECK(queueing_execute(3,argv_bad)==mapp::MAPP_BAD_ARG);
+}
+
+BOOST_AUTO_TEST_CASE(steal){
+    char arg1[]="NULL";
+    char arg2[]="--numthread=4";
+    char arg3[]="--eventsper=25";
+    char arg4[]="--simtime=25";
+    char arg5[]="--percent-ite=0";
+    char arg6[]="--steal";
+    char * const argv[] = {arg1, arg2, arg3, arg4, arg5, arg6};
+    int argc = 6;
+    BOOST_CHECK(queueing_execute(argc,argv)==0);
+
+    const int simtime = 25;
+    const int cellgroups = 64;
+    const int eventsper = 25;
+    //every cell group ran every time step, stolen or not
+    BOOST_CHECK(neuromapp_data.get<int>("enqueued") == (simtime * cellgroups * eventsper));
+    BOOST_CHECK(neuromapp_data.has<int>("steals"));
+    neuromapp_data.clear("inter_received");
+    neuromapp_data.clear("enqueued");
+    neuromapp_data.clear("delivered");
+    neuromapp_data.clear("spikes");
+    neuromapp_data.clear("steals");
+
+    char arg7[]="--imbalance=101";
+    char * const argv_bad[] = {arg1, arg2, arg7};
+    BOOST_CHECK(queueing_execute(3,argv_bad)==mapp::MAPP_BAD_ARG);
+
+    char arg8[]="--windowed";
+    char * const argv_windowed[] = {arg1, arg2, arg6, arg8};
+    BOOST_CHECK(queueing_execute(4,argv_windowed)==mapp::MAPP_BAD_ARG);
+}
+
+BOOST_AUTO_TEST_CASE(traffic){
+    char arg1[]="NULL";
+    char arg2[]="--numthread=4";
+    char arg3[]="--eventsper=25";
+    char arg4[]="--simtime=25";
+    char arg5[]="--traffic=zipf";
+    char arg6[]="--burst=4";
+    char * const argv[] = {arg1, arg2, arg3, arg4, arg5, arg6};
+    int argc = 6;
+    BOOST_CHECK(queueing_execute(argc,argv)==0);
+
+    //an event is delivered after it was enqueued
+    BOOST_CHECK(neuromapp_data.get<int>("delivered") <= neuromapp_data.get<int>("enqueued"));
+    neuromapp_data.clear("inter_received");
+    neuromapp_data.clear("enqueued");
+    neuromapp_data.clear("delivered");
+    neuromapp_data.clear("spikes");
+
+    char arg7[]="--traffic=ring";
+    char arg8[]="--spinlock";
+    char * const argv_ring[] = {arg1, arg2, arg3, arg4, arg7, arg8};
+    BOOST_CHECK(queueing_execute(argc,argv_ring)==0);
+    neuromapp_data.clear("inter_received");
+    neuromapp_data.clear("enqueued");
+    neuromapp_data.clear("delivered");
+    neuromapp_data.clear("spikes");
+
+    char arg9[]="--traffic=gaussian";
+    char * const argv_bad[] = {arg1, arg2, arg9};
+    BOOST_CHECK(queueing_execute(3,argv_bad)==mapp::MAPP_BAD_ARG);
+}
+
+#ifdef NEUROMAPP_QUEUEING_LATENCY
+BOOST_AUTO_TEST_CASE(latency){
+    char arg1[]="NULL";
+    char arg2[]="--numthread=4";
+    char arg3[]="--eventsper=25";
+    char arg4[]="--simtime=25";
+    char * const argv[] = {arg1, arg2, arg3, arg4};
+    int argc = 4;
+    BOOST_CHECK(queueing_execute(argc,argv)==0);
+
+    BOOST_CHECK(neuromapp_data.has<double>("transfer_p50"));
+    BOOST_CHECK(neuromapp_data.has<double>("residency_p999"));
+    BOOST_CHECK(neuromapp_data.get<double>("transfer_p50") <= neuromapp_data.get<double>("transfer_p999"));
+    neuromapp_data.clear("inter_received");
+    neuromapp_data.clear("enqueued");
+    neuromapp_data.clear("delivered");
+    neuromapp_data.clear("spikes");
+}
+#endif
+
+BOOST_AUTO_TEST_CASE(with_algebra){
+    char arg1[]="NULL";
+    char arg2[]="--numthread=4";
+    char arg3[]="--eventsper=25";
+    char arg4[]="--simtime=5";
+    char arg5[]="--ncellgroups=4";
+    char arg6[]="--with-algebra";
+    char arg7[]="--percent-ite=0";
+    char * const argv[] = {arg1, arg2, arg3, arg4, arg5, arg6, arg7};
+    int argc = 7;
+    BOOST_CHECK(queueing_execute(argc,argv)==0);
+
+    std::string key2("enqueued");
+    BOOST_CHECK(neuromapp_data.has<int>(key2));
+    BOOST_CHECK(neuromapp_data.get<int>(key2) == (5 * 4 * 25));
+    neuromapp_data.clear("inter_received");
+    neuromapp_data.clear("enqueued");
+    neuromapp_data.clear("delivered");
+    neuromapp_data.clear("spikes");
+}
+
+BOOST_AUTO_TEST_CASE(false_sharing){
+    char arg1[]="NULL";
+    char arg2[]="--numthread=4";
+    char arg3[]="--simtime=25";
+    char arg4[]="--false-sharing";
+    char * const argv[] = {arg1, arg2, arg3, arg4};
+    int argc = 4;
+    BOOST_CHECK(queueing_execute(argc,argv)==0);
+
+    std::string key1("false_sharing_packed");
+    std::string key2("false_sharing_padded");
+    BOOST_CHECK(neuromapp_data.has<double>(key1));
+    BOOST_CHECK(neuromapp_data.has<double>(key2));
+    BOOST_CHECK(neuromapp_data.get<double>(key1) >= 0.);
+    BOOST_CHECK(neuromapp_data.get<double>(key2) >= 0.);
+
+    // both layouts ran every increment of every thread: 4*100*simtime*eventsper
+    std::string key3("false_sharing_packed_count");
+    std::string key4("false_sharing_padded_count");
+    BOOST_REQUIRE(neuromapp_data.has<long>(key3));
+    BOOST_REQUIRE(neuromapp_data.has<long>(key4));
+    BOOST_CHECK_EQUAL(neuromapp_data.get<long>(key3), 4L * 100 * 25 * 50);
+    BOOST_CHECK_EQUAL(neuromapp_data.get<long>(key4), 4L * 100 * 25 * 50);
+    neuromapp_data.clear(key1);
+    neuromapp_data.clear(key2);
+    neuromapp_data.clear(key3);
+    neuromapp_data.clear(key4);
+}
+
 //UNIT TESTS
+BOOST_AUTO_TEST_CASE(padded_layout){
+	//a padded block always ends on a cache line boundary
+	BOOST_CHECK(sizeof(queueing::cache_line_padded<queueing::InterThread<queueing::mutex> >)
+	            % queueing::cache_line_size == 0);
+	BOOST_CHECK(sizeof(queueing::cache_line_padded<queueing::InterThread<queueing::spinlock> >)
+	            % queueing::cache_line_size == 0);
+}
+
 BOOST_AUTO_TEST_CASE_TEMPLATE(pool_choose_dest, T, full_test_types){
 	queueing::Pool<IMPL> pl1(false, 20, 0, 0);
 	int dst = 0;
@@ -233,50 +441,219 @@ BOOST_AUTO_TEST_CASE_TEMPLATE(pool_choose_dest, T, full_test_types){
 		dst = pl2.chooseDst(0);
 		BOOST_CHECK(dst != 0);
 	}
+
+	queueing::Pool<IMPL> pl3(false, 20, 100, 0, 0, 2);
+	BOOST_CHECK(pl3.ncellgroups() == 2);
+	for(int i = 0; i < 10; ++i){
+		dst = pl3.chooseDst(0);
+		BOOST_CHECK(dst == 1);
+	}
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(pool_nrnthread_copies, T, full_test_types){
+	//without algebra the cell groups share the dataset read-only
+	queueing::Pool<IMPL> pl1(false, 20, 0, 0, 0, 2);
+	BOOST_CHECK(pl1.nrnthread(0) == pl1.nrnthread(1));
+
+	//with algebra every cell group works on its own copy
+	queueing::Pool<IMPL> pl2(false, 20, 0, 0, 1, 2);
+	BOOST_CHECK(pl2.nrnthread(0) != pl2.nrnthread(1));
+	BOOST_CHECK(pl2.nrnthread(0) != pl1.nrnthread(0));
+	BOOST_CHECK(pl2.nrnthread(0)->end == pl1.nrnthread(0)->end);
+	BOOST_CHECK(pl2.nrnthread(0)->_ndata == pl1.nrnthread(0)->_ndata);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(pool_imbalance, T, full_test_types){
+	//every inter-thread event goes to the cell group 0
+	queueing::Pool<IMPL> pl(false, 20, 100, 0, 0, 64, queueing::traffic(queueing::uniform, 100));
+	for(int i = 0; i < 10; ++i){
+		BOOST_CHECK(pl.chooseDst(5) == 0);
+		BOOST_CHECK(pl.chooseDst(0) != 0);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(traffic_models){
+	const int n = 32;
+	//the two neighbours only
+	queueing::traffic r(queueing::ring);
+	r.setup(n);
+	for(int i = 0; i < 100; ++i){
+		int dst = r.destination(0, n);
+		BOOST_CHECK(dst == 1 || dst == n-1);
+	}
+
+	//inside the community of 8, then outside of it
+	queueing::traffic b(queueing::block, 0, 1., 8, 100);
+	b.setup(n);
+	queueing::traffic b_out(queueing::block, 0, 1., 8, 0);
+	b_out.setup(n);
+	for(int i = 0; i < 100; ++i){
+		int dst = b.destination(10, n);
+		BOOST_CHECK(dst >= 8 && dst < 16 && dst != 10);
+		dst = b_out.destination(10, n);
+		BOOST_CHECK(dst < 8 || dst >= 16);
+	}
+
+	//heavy hitters: the cell group 0 receives the most events
+	queueing::traffic z(queueing::zipf, 0, 1.5);
+	z.setup(n);
+	std::vector<int> hits(n, 0);
+	for(int i = 0; i < 10000; ++i){
+		int dst = z.destination(5, n);
+		BOOST_CHECK(dst != 5 && dst >= 0 && dst < n);
+		hits[dst]++;
+	}
+	BOOST_CHECK(std::max_element(hits.begin(), hits.end()) - hits.begin() == 0);
+	BOOST_CHECK(hits[1] > hits[n-1]);
+
+	//bursts: all or nothing, the average is kept
+	queueing::traffic burst(queueing::uniform, 0, 1., 8, 90, 4);
+	int sum = 0;
+	for(int i = 0; i < 10000; ++i){
+		int e = burst.events(10);
+		BOOST_CHECK(e == 0 || e == 40);
+		sum += e;
+	}
+	BOOST_CHECK(sum > 10000 * 8 && sum < 10000 * 12);
+	BOOST_CHECK(queueing::traffic().events(10) == 10);
+
+	queueing::traffic_model m;
+	BOOST_CHECK(queueing::traffic_model_from_string("zipf", m) && m == queueing::zipf);
+	BOOST_CHECK(!queueing::traffic_model_from_string("gaussian", m));
+}
+
+BOOST_AUTO_TEST_CASE(task_deques_steal){
+	queueing::task_deques tasks(2);
+	for(int i = 0; i < 4; ++i)
+		tasks.push(0, i);
+	int task = -1;
+	//the owner takes the last, a thief the first
+	BOOST_CHECK(tasks.pop(0, task));
+	BOOST_CHECK(task == 3);
+	BOOST_CHECK(!tasks.pop(1, task));
+	BOOST_CHECK(tasks.steal(1, task));
+	BOOST_CHECK(task == 0);
+	BOOST_CHECK(tasks.steals() == 1);
+	BOOST_CHECK(tasks.pop(0, task) && tasks.pop(0, task));
+	BOOST_CHECK(!tasks.steal(1, task));
 }
 
 BOOST_AUTO_TEST_CASE_TEMPLATE(thread_self_send, T, full_test_types){
 	queueing::NrnThreadData<IMPL> nt;
-	nt.selfSend(0.0,1.0);
-	nt.selfSend(0.0,2.0);
-	nt.selfSend(0.0,3.0);
-	nt.selfSend(0.0,4.0);
+	nt.selfSend(0,1.0);
+	nt.selfSend(0,2.0);
+	nt.selfSend(0,3.0);
+	nt.selfSend(0,4.0);
 	BOOST_CHECK(nt.PQSize() == 4);
 	BOOST_CHECK(nt.enqueued_ == 4);
 }
 
 BOOST_AUTO_TEST_CASE_TEMPLATE(thread_inter_send, T, full_test_types){
 	queueing::NrnThreadData<IMPL> nt;
-	nt.interThreadSend(0.0,1.0);
-	nt.interThreadSend(0.0,2.0);
-	nt.interThreadSend(0.0,3.0);
-	nt.interThreadSend(0.0,4.0);
+	nt.interThreadSend(0,1.0);
+	nt.interThreadSend(0,2.0);
+	nt.interThreadSend(0,3.0);
+	nt.interThreadSend(0,4.0);
 	BOOST_CHECK(nt.interThreadSize() == 4);
+	//the owner counts the events when it drains them, not the sender
+	BOOST_CHECK(nt.ite_received_ == 0);
+	nt.enqueueMyEvents();
 	BOOST_CHECK(nt.ite_received_ == 4);
 }
 
+BOOST_AUTO_TEST_CASE(event_size){
+#ifdef NEUROMAPP_QUEUEING_LATENCY
+	//plus the timestamp
+	BOOST_CHECK(sizeof(queueing::event) == 24);
+#else
+	//no padding: time, destination and NetCon
+	BOOST_CHECK(sizeof(queueing::event) == 16);
+#endif
+}
+
+BOOST_AUTO_TEST_CASE(histogram_percentiles){
+	queueing::histogram h;
+	BOOST_CHECK(h.percentile(50.) == 0);
+
+	//exact below 32, within 1/32 above
+	for(queueing::histogram::value_type v = 1; v <= 1000; ++v)
+		h.record(v);
+	BOOST_CHECK(h.count() == 1000);
+	BOOST_CHECK(h.max() == 1000);
+	BOOST_CHECK(h.percentile(1.) == 10);
+	BOOST_CHECK(h.percentile(50.) >= 500 && h.percentile(50.) <= 500 + 500/32);
+	BOOST_CHECK(h.percentile(99.) >= 990 && h.percentile(99.) <= 990 + 990/32);
+	BOOST_CHECK(h.percentile(100.) == 1000);
+
+	//the buckets are contiguous and ordered
+	for(int i = 1; i < 4096; ++i)
+		BOOST_CHECK(queueing::histogram::index(i) >= queueing::histogram::index(i-1));
+	BOOST_CHECK(queueing::histogram::highest(queueing::histogram::index(12345)) >= 12345);
+
+	//tail of the merge
+	queueing::histogram tail;
+	tail.record(1000000);
+	h.merge(tail);
+	BOOST_CHECK(h.count() == 1001);
+	BOOST_CHECK(h.percentile(100.) == 1000000);
+	BOOST_CHECK(h.percentile(50.) <= 500 + 500/32);
+}
+
+BOOST_AUTO_TEST_CASE(node_slab_reuse){
+	typedef queueing::spinlock_queue<queueing::event>::node node;
+	queueing::node_slab<node> slab(4);
+	std::vector<node*> nodes;
+	for(int i = 0; i < 4; ++i)
+		nodes.push_back(slab.allocate());
+	BOOST_CHECK(slab.capacity() == 4);
+
+	//the nodes given back are reused before a new block is allocated
+	for(int i = 0; i < 4; ++i)
+		slab.deallocate(nodes[i]);
+	for(int i = 0; i < 4; ++i)
+		BOOST_CHECK(std::find(nodes.begin(), nodes.end(), slab.allocate()) != nodes.end());
+	BOOST_CHECK(slab.capacity() == 4);
+
+	slab.allocate();
+	BOOST_CHECK(slab.capacity() == 8);
+}
+
+BOOST_AUTO_TEST_CASE_TEMPLATE(thread_inter_send_slab, T, full_test_types){
+	queueing::NrnThreadData<IMPL> sender;
+	queueing::NrnThreadData<IMPL> nt;
+	for(int i = 0; i < 3; ++i)
+		nt.interThreadSend(0, 1.0 + i, i, &sender.slab());
+	BOOST_CHECK(nt.interThreadSize() == 3);
+	nt.enqueueMyEvents();
+	BOOST_CHECK(nt.ite_received_ == 3);
+
+	BOOST_CHECK(nt.deliver(0, 1));
+	BOOST_CHECK(nt.delivered_ == 1);
+}
+
 BOOST_AUTO_TEST_CASE_TEMPLATE(thread_enqueue, T, full_test_types){
 	queueing::NrnThreadData<IMPL> nt;
-	nt.selfSend(0.0,4.0);
-	nt.interThreadSend(0.0,1.0);
-	nt.interThreadSend(0.0,2.0);
-	nt.interThreadSend(0.0,3.0);
+	nt.selfSend(0,4.0);
+	nt.interThreadSend(0,1.0);
+	nt.interThreadSend(0,2.0);
+	nt.interThreadSend(0,3.0);
 	nt.enqueueMyEvents();
-	nt.selfSend(0.0,5.0);
+	nt.selfSend(0,5.0);
 	BOOST_CHECK(nt.PQSize() == 5);
 	BOOST_CHECK(nt.interThreadSize() == 0);
 	BOOST_CHECK(nt.enqueued_ == 5);
+	BOOST_CHECK(nt.ite_received_ == 3);
 }
 
 BOOST_AUTO_TEST_CASE_TEMPLATE(thread_deliver, T, full_test_types){
     queueing::NrnThreadData<IMPL> nt;
-    nt.selfSend(0.0,4.0);
-    nt.interThreadSend(0.0,1.0);
-    nt.interThreadSend(0.0,2.0);
-    nt.interThreadSend(0.0,3.0);
-    nt.selfSend(0.0,5.0);
+    nt.selfSend(0,4.0);
+    nt.interThreadSend(0,1.0);
+    nt.interThreadSend(0,2.0);
+    nt.interThreadSend(0,3.0);
+    nt.selfSend(0,5.0);
     nt.enqueueMyEvents();
-	nt.selfSend(0.0,6.0);
+	nt.selfSend(0,6.0);
     BOOST_CHECK(nt.PQSize() == 6);
 
 	//deliver the first item
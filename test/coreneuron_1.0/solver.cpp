@@ -28,12 +28,16 @@
 #include <vector>
 #include <limits>
 #include <cmath>
+#include <algorithm>
 
 #include <boost/test/unit_test.hpp>
 #include <boost/filesystem.hpp>
 
 #include "coreneuron_1.0/solver/solver.h" // signature kernel application
 #include "coreneuron_1.0/solver/hines.h" // to call the solver library's API directly
+#include "coreneuron_1.0/common/memory/memory.h"
+#include "coreneuron_1.0/common/util/nrnthread_handler.h"
+#include "utils/storage/storage.h"
 
 #include "neuromapp/coreneuron_1.0/common/data/path.h" // this file is generated automatically
 #include "coreneuron_1.0/common/data/helper.h" // common functionalities
@@ -89,6 +93,31 @@ BOOST_AUTO_TEST_CASE(solver_test){
     BOOST_CHECK(num==0);
 }
 
+BOOST_AUTO_TEST_CASE(solver_firsttouch_test){
+    // with firsttouch the solver computes on its own copy, to the same solution
+    std::string path(mapp::data_test());
+    std::vector<std::string> command_v;
+    command_v.push_back("coreneuron10_solver_execute");
+    command_v.push_back("--data");
+    command_v.push_back(path);
+    command_v.push_back("--name");
+    command_v.push_back("solver_default");
+    BOOST_CHECK(mapp::execute(command_v,coreneuron10_solver_execute)==mapp::MAPP_OK);
+    command_v[4] = "solver_firsttouch";
+    command_v.push_back("--alloc");
+    command_v.push_back("firsttouch");
+    BOOST_CHECK(mapp::execute(command_v,coreneuron10_solver_execute)==mapp::MAPP_OK);
+    BOOST_CHECK(nrn_get_alloc_policy()==NRN_ALLOC_DEFAULT);
+
+    NrnThread *ref = (NrnThread *) storage_get("solver_default", make_nrnthread, NULL, free_nrnthread);
+    NrnThread *nt = (NrnThread *) storage_get("solver_firsttouch", make_nrnthread, NULL, free_nrnthread);
+    BOOST_REQUIRE(ref != NULL && nt != NULL && nt != ref);
+    BOOST_CHECK(std::equal(ref->_actual_rhs, ref->_actual_rhs + ref->end, nt->_actual_rhs));
+    BOOST_CHECK(std::equal(ref->_actual_d, ref->_actual_d + ref->end, nt->_actual_d));
+    storage_clear("solver_default");
+    storage_clear("solver_firsttouch");
+}
+
 BOOST_AUTO_TEST_CASE(simple_matrix_solver_test){
     //smallest matrix we can represent is a 3x3
     NrnThread nt;
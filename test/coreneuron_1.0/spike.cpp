@@ -0,0 +1,117 @@
+/*
+ * Neuromapp - spike.cpp, Copyright (c), 2015,
+ * Timothee Ewart - Swiss Federal Institute of technology in Lausanne,
+ * timothee.ewart@epfl.ch,
+ * All rights reserved.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3.0 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.
+ */
+
+/**
+ * @file neuromapp/test/coreneuron_1.0/spike.cpp
+ *  Test on the spike miniapp
+ */
+
+#define BOOST_TEST_MODULE SpikeTest
+#include <vector>
+#include <string>
+
+#include <boost/test/unit_test.hpp>
+
+extern "C" {
+#include "coreneuron_1.0/spike/exchange.h"
+}
+
+#include "coreneuron_1.0/spike/spike.h" // signature spike application
+#include "coreneuron_1.0/common/data/helper.h" // common functionalities
+#include "utils/error.h"
+
+BOOST_AUTO_TEST_CASE(helper_spike_test){
+    std::vector<std::string> command_v;
+    int error(mapp::MAPP_OK);
+
+    //wrong argument
+    command_v.push_back("spike_execute"); // dummy argument to be compliant with getopt
+    command_v.push_back("--qrhqrhqethqhba"); // this does not exist
+    error = mapp::execute(command_v,coreneuron10_spike_execute);
+    BOOST_CHECK(error==mapp::MAPP_USAGE);
+
+    //helper
+    command_v.clear();
+    command_v.push_back("spike_execute");
+    command_v.push_back("--help");
+    error = mapp::execute(command_v,coreneuron10_spike_execute);
+    BOOST_CHECK(error==mapp::MAPP_USAGE);
+
+    //no process
+    command_v.clear();
+    command_v.push_back("spike_execute");
+    command_v.push_back("--procs");
+    command_v.push_back("0");
+    error = mapp::execute(command_v,coreneuron10_spike_execute);
+    BOOST_CHECK(error==mapp::MAPP_BAD_ARG);
+
+    //window shorter than a time step
+    command_v.clear();
+    command_v.push_back("spike_execute");
+    command_v.push_back("--min-delay");
+    command_v.push_back("0.01");
+    error = mapp::execute(command_v,coreneuron10_spike_execute);
+    BOOST_CHECK(error==mapp::MAPP_BAD_ARG);
+}
+
+BOOST_AUTO_TEST_CASE(spike_encoding_test){
+    struct spike s[3] = {{0, 0}, {12345, 39}, {7, 17}};
+    struct spike r[3];
+    struct spike_encoding e;
+    std::vector<char> buf(3 * sizeof(struct spike_full));
+
+    //full and compact encodings give back the same spikes
+    for(int compact = 0; compact < 2; ++compact){
+        BOOST_CHECK(spike_encoding_init(&e, compact, 40, 100000, 0.025) == mapp::MAPP_OK);
+        spike_encode(&e, s, 3, 10., &buf[0]);
+        spike_decode(&e, &buf[0], 3, 10., r);
+        for(int i = 0; i < 3; ++i){
+            BOOST_CHECK(r[i].gid == s[i].gid);
+            BOOST_CHECK(r[i].step == s[i].step);
+        }
+    }
+    BOOST_CHECK(spike_encoding_size(&e) == 4);
+
+    //the cells do not fit in 26 bits
+    BOOST_CHECK(spike_encoding_init(&e, 1, 40, 1LL << 27, 0.025) == mapp::MAPP_BAD_ARG);
+    BOOST_CHECK(spike_encoding_init(&e, 0, 40, 1LL << 27, 0.025) == mapp::MAPP_OK);
+}
+
+BOOST_AUTO_TEST_CASE(spike_exchange_test){
+    const char* options[][2] = {{"--tstop", "10"}, {"--compact", 0}, {"--overlap", 0}};
+    // every combination of encoding and overlap, the processes check the totals
+    for(int i = 0; i < 4; ++i){
+        std::vector<std::string> command_v;
+        command_v.push_back("spike_execute");
+        command_v.push_back("--procs");
+        command_v.push_back("3");
+        command_v.push_back("--cells");
+        command_v.push_back("64");
+        command_v.push_back("--rate");
+        command_v.push_back("200");
+        command_v.push_back(options[0][0]);
+        command_v.push_back(options[0][1]);
+        if(i & 1)
+            command_v.push_back(options[1][0]);
+        if(i & 2)
+            command_v.push_back(options[2][0]);
+        BOOST_CHECK(mapp::execute(command_v,coreneuron10_spike_execute) == mapp::MAPP_OK);
+    }
+}
@@ -34,6 +34,10 @@
 #include "neuromapp/coreneuron_1.0/common/data/path.h" // this file is generated automatically
 #include "coreneuron_1.0/common/data/helper.h" // common functionalities
 
+#include <pthread.h>
+#include <unistd.h>
+#include <boost/atomic.hpp>
+
 #include "utils/error.h"
 #include "utils/storage/storage.h"
 #include "utils/storage/storage.hpp"
@@ -129,6 +133,161 @@ BOOST_AUTO_TEST_CASE(storage_test_c_wrapper){
     BOOST_CHECK(dealloc_count==1);
 }
 
+static boost::atomic<int> make_count;
+static int concurrent_value=7;
+
+static void *slow_maker(void *p) {
+    ++make_count;
+    usleep(10000); // the other threads arrive while the item is built
+    return p;
+}
+
+static void *concurrent_get(void *result) {
+    *(void **)result=storage_get("concurrent_data",slow_maker,(void *)&concurrent_value,inc_dealloc_count);
+    return 0;
+}
+
+BOOST_AUTO_TEST_CASE(storage_test_concurrent_get){
+    storage_clear("concurrent_data");
+    make_count=0;
+    dealloc_count=0;
+
+    const int n=8;
+    pthread_t threads[n];
+    void *results[n];
+    for (int i=0; i<n; ++i)
+        pthread_create(&threads[i],NULL,concurrent_get,&results[i]);
+    for (int i=0; i<n; ++i)
+        pthread_join(threads[i],NULL);
+
+    // the loader ran once and every thread got its item
+    BOOST_CHECK(make_count==1);
+    for (int i=0; i<n; ++i)
+        BOOST_CHECK(results[i]==(void *)&concurrent_value);
+
+    storage_clear("concurrent_data");
+    BOOST_CHECK(dealloc_count==1);
+}
+
+BOOST_AUTO_TEST_CASE(storage_test_prefetch){
+    storage_clear("prefetched_data");
+    make_count=0;
+    dealloc_count=0;
+
+    // returns while the loader sleeps, once only
+    BOOST_CHECK(storage_prefetch("prefetched_data",slow_maker,(void *)&concurrent_value,inc_dealloc_count,NULL)==1);
+    BOOST_CHECK(storage_prefetch("prefetched_data",slow_maker,(void *)&concurrent_value,inc_dealloc_count,NULL)==0);
+
+    // waits for the load in flight instead of loading again
+    void *v=storage_get("prefetched_data",slow_maker,(void *)&concurrent_value,inc_dealloc_count);
+    BOOST_CHECK(v==(void *)&concurrent_value);
+    BOOST_CHECK(make_count==1);
+    BOOST_CHECK(storage_prefetch("prefetched_data",slow_maker,(void *)&concurrent_value,inc_dealloc_count,NULL)==0);
+
+    storage_clear("prefetched_data");
+    BOOST_CHECK(dealloc_count==1);
+}
+
+BOOST_AUTO_TEST_CASE(storage_test_prefetch_get){
+    storage s;
+    BOOST_CHECK(s.prefetch<int>("answer",make_delay(42)));
+    // the getter without functor waits as well
+    BOOST_CHECK(s.get<int>("answer")==42);
+    BOOST_CHECK(!s.prefetch<int>("answer",make_delay(0)));
+    // the destructor waits for the threads in flight
+    s.prefetch<double>("pending",make_delay(1.));
+}
+
+struct fixed_size {
+    std::size_t bytes;
+    std::size_t operator()(int const&) const { return bytes; }
+};
+
+BOOST_AUTO_TEST_CASE(storage_test_budget){
+    storage s;
+    fixed_size mb={1<<20};
+    s.set_budget(2<<20);
+
+    // pinned: not evicted even beyond the budget
+    s.acquire<int>("a",make_delay(1),mb);
+    s.acquire<int>("b",make_delay(2),mb);
+    s.acquire<int>("c",make_delay(3),mb);
+    BOOST_CHECK(s.stats().used==(3<<20));
+    BOOST_CHECK(s.stats().evictions==0);
+
+    // released beyond the budget: evicted at once
+    s.release("b");
+    BOOST_CHECK(s.stats().evictions==1);
+    BOOST_CHECK(s.has<int>("b")==false);
+    s.release("a");
+    BOOST_CHECK(s.has<int>("a")==true);
+
+    // a lookup refreshes a: the least recently used c goes for d
+    BOOST_CHECK(s.acquire<int>("a",make_delay(0),mb)==1);
+    s.release("a");
+    s.release("c");
+    s.acquire<int>("d",make_delay(4),mb);
+    BOOST_CHECK(s.has<int>("c")==false);
+    BOOST_CHECK(s.has<int>("a")==true);
+
+    // the items without size are never evicted
+    s.put_copy("stat",5.);
+    s.set_budget(1);
+    BOOST_CHECK(s.has<double>("stat")==true);
+    BOOST_CHECK(s.has<int>("a")==false);
+    BOOST_CHECK(s.has<int>("d")==true);
+
+    storage_stats st=s.stats();
+    BOOST_CHECK(st.items==2);
+    BOOST_CHECK(st.used==(1<<20));
+    BOOST_CHECK(st.misses==4);
+    BOOST_CHECK(st.hits==1);
+    BOOST_CHECK(st.evictions==3);
+
+    BOOST_CHECK_THROW(s.release("stat"),std::logic_error);
+}
+
+BOOST_AUTO_TEST_CASE(storage_test_budget_get){
+    storage s;
+    fixed_size mb={1<<20};
+    s.set_budget(1<<20);
+
+    // the reference of get() has no release: a is kept beyond the budget
+    s.acquire<int>("a",make_delay(1),mb);
+    s.release("a");
+    const int &a = s.get<int>("a");
+    s.acquire<int>("b",make_delay(2),mb);
+    s.release("b");
+    BOOST_CHECK(s.has<int>("a")==true);
+    BOOST_CHECK(a==1);
+    BOOST_CHECK(s.has<int>("b")==false);
+    BOOST_CHECK(s.stats().evictions==1);
+
+    // until it is cleared
+    s.clear("a");
+    BOOST_CHECK(s.stats().used==0);
+}
+
+struct throw_once {
+    int *calls;
+    int operator()() const {
+        if (!(*calls)++) throw std::runtime_error("loader failure");
+        return 42;
+    }
+};
+
+BOOST_AUTO_TEST_CASE(storage_test_failed_maker){
+    storage s;
+    int calls=0;
+    throw_once f={&calls};
+
+    // a failed construction does not leave the key marked as in progress
+    BOOST_CHECK_THROW(s.get<int>("retry",f), std::runtime_error);
+    BOOST_CHECK(s.has<int>("retry")==false);
+    BOOST_CHECK(s.get<int>("retry",f)==42);
+    BOOST_CHECK(calls==2);
+}
+
 BOOST_AUTO_TEST_CASE(NrnThread_test){
     std::string path(mapp::helper_build_path::test_data_path());
     std::string wrongpath("wrongpath");